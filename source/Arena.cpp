@@ -0,0 +1,77 @@
+#include "Arena.h"
+
+#include <cassert>
+#include <cstdint>
+
+namespace dae
+{
+	LinearAllocator::LinearAllocator(size_t blockSize) :
+		m_BlockSize{ blockSize }
+	{
+	}
+
+	LinearAllocator::~LinearAllocator()
+	{
+		for (const Block& block : m_Blocks)
+		{
+			::operator delete(block.pData, std::align_val_t{ alignof(std::max_align_t) });
+		}
+	}
+
+	void* LinearAllocator::Allocate(size_t size, size_t alignment)
+	{
+		assert((alignment & (alignment - 1)) == 0 && "Alignment has to be a power of 2");
+		assert(alignment <= alignof(std::max_align_t) && "Blocks are only aligned to max_align_t");
+
+		// Try the current block first, then any block left over from before the last Reset
+		while (m_CurrentBlock < m_Blocks.size())
+		{
+			const Block& block{ m_Blocks[m_CurrentBlock] };
+			const size_t alignedOffset{ (m_Offset + alignment - 1) & ~(alignment - 1) };
+			if (alignedOffset + size <= block.size)
+			{
+				m_Offset = alignedOffset + size;
+				return block.pData + alignedOffset;
+			}
+
+			++m_CurrentBlock;
+			m_Offset = 0;
+		}
+
+		// Out of blocks, big allocations get a block of their own size
+		Block block{};
+		block.size = size > m_BlockSize ? size : m_BlockSize;
+		block.pData = static_cast<std::byte*>(::operator new(block.size, std::align_val_t{ alignof(std::max_align_t) }));
+		m_Blocks.push_back(block);
+
+		m_CurrentBlock = m_Blocks.size() - 1;
+		m_Offset = size;
+		return block.pData;
+	}
+
+	void LinearAllocator::Reset()
+	{
+		m_CurrentBlock = 0;
+		m_Offset = 0;
+	}
+
+	size_t LinearAllocator::GetUsedBytes() const
+	{
+		size_t used{ m_Offset };
+		for (size_t i{}; i < m_CurrentBlock && i < m_Blocks.size(); ++i)
+		{
+			used += m_Blocks[i].size;
+		}
+		return used;
+	}
+
+	size_t LinearAllocator::GetCapacity() const
+	{
+		size_t capacity{};
+		for (const Block& block : m_Blocks)
+		{
+			capacity += block.size;
+		}
+		return capacity;
+	}
+}
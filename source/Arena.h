@@ -0,0 +1,121 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dae
+{
+#pragma region Linear Allocator
+	// Bump allocator over a list of blocks. Nothing gets freed individually, Reset() rewinds to the start
+	// but keeps the blocks, so once it has grown big enough it never touches the heap again.
+	class LinearAllocator final
+	{
+	public:
+		explicit LinearAllocator(size_t blockSize = 64 * 1024);
+		~LinearAllocator();
+
+		LinearAllocator(const LinearAllocator&) = delete;
+		LinearAllocator(LinearAllocator&&) noexcept = delete;
+		LinearAllocator& operator=(const LinearAllocator&) = delete;
+		LinearAllocator& operator=(LinearAllocator&&) noexcept = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+		void Reset();
+
+		size_t GetUsedBytes() const;
+		size_t GetCapacity() const;
+
+	private:
+		struct Block
+		{
+			std::byte* pData{};
+			size_t size{};
+		};
+
+		std::vector<Block> m_Blocks{};
+		size_t m_CurrentBlock{};
+		size_t m_Offset{};
+		size_t m_BlockSize{};
+	};
+#pragma endregion
+
+#pragma region Arena Allocator (std adapter)
+	// Lets std containers allocate from a LinearAllocator, deallocate is a no-op
+	template<typename T>
+	struct ArenaAllocator
+	{
+		using value_type = T;
+
+		ArenaAllocator(LinearAllocator& allocator) : pAllocator{ &allocator } {}
+		template<typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : pAllocator{ other.pAllocator } {}
+
+		T* allocate(size_t count)
+		{
+			return static_cast<T*>(pAllocator->Allocate(count * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T*, size_t) {}
+
+		template<typename U>
+		bool operator==(const ArenaAllocator<U>& other) const { return pAllocator == other.pAllocator; }
+
+		LinearAllocator* pAllocator{};
+	};
+#pragma endregion
+
+#pragma region Scene Arena
+	// Owns long-lived scene objects (materials, ...). Objects are constructed inside the arena's memory
+	// and destroyed in reverse order of creation when the arena goes away.
+	class SceneArena final
+	{
+	public:
+		explicit SceneArena(size_t blockSize = 64 * 1024) : m_Allocator{ blockSize } {}
+		~SceneArena()
+		{
+			for (DestructorNode* pNode{ m_pDestructors }; pNode != nullptr; pNode = pNode->pNext)
+			{
+				pNode->pDestroy(pNode->pObject);
+			}
+		}
+
+		SceneArena(const SceneArena&) = delete;
+		SceneArena(SceneArena&&) noexcept = delete;
+		SceneArena& operator=(const SceneArena&) = delete;
+		SceneArena& operator=(SceneArena&&) noexcept = delete;
+
+		template<typename T, typename... Args>
+		T* New(Args&&... args)
+		{
+			T* pObject{ new (m_Allocator.Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...) };
+
+			// The destructor list lives in the arena as well, newest first so destruction happens in reverse
+			if constexpr (!std::is_trivially_destructible_v<T>)
+			{
+				DestructorNode* pNode{ new (m_Allocator.Allocate(sizeof(DestructorNode), alignof(DestructorNode))) DestructorNode{} };
+				pNode->pObject = pObject;
+				pNode->pDestroy = [](void* pPtr) { static_cast<T*>(pPtr)->~T(); };
+				pNode->pNext = m_pDestructors;
+				m_pDestructors = pNode;
+			}
+
+			return pObject;
+		}
+
+		size_t GetUsedBytes() const { return m_Allocator.GetUsedBytes(); }
+
+	private:
+		struct DestructorNode
+		{
+			void* pObject{};
+			void (*pDestroy)(void*) {};
+			DestructorNode* pNext{};
+		};
+
+		LinearAllocator m_Allocator;
+		DestructorNode* m_pDestructors{};
+	};
+#pragma endregion
+}
@@ -1,8 +1,7 @@
 #pragma once
 #include <cassert>
-#include <SDL_keyboard.h>
-#include <SDL_mouse.h>
 
+#include "InputSource.h"
 #include "Math.h"
 #include "Timer.h"
 #include <iostream>
@@ -59,66 +58,63 @@ namespace dae
 			return cameraToWorld;
 		}
 
-		void Update(Timer* pTimer)
+		void Update(Timer* pTimer, const CameraInput& input)
 		{
 			const float deltaTime = pTimer->GetElapsed();
 
-			//Keyboard Input
-			const uint8_t* pKeyboardState = SDL_GetKeyboardState(nullptr);
-
 			// Keyboard movement of the camera
-			if (pKeyboardState[SDL_SCANCODE_W])
+			if (input.moveForward)
 			{
 				origin += forward * movementSpeed * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_S])
+			if (input.moveBackward)
 			{
 				origin -= forward * movementSpeed * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_D])
+			if (input.moveRight)
 			{
 				origin += right * movementSpeed * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_A])
+			if (input.moveLeft)
 			{
 				origin -= right * movementSpeed * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_SPACE])
+			if (input.moveUp)
 			{
 				origin += up * movementSpeed * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_LSHIFT])
+			if (input.moveDown)
 			{
 				origin -= up * movementSpeed * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_UP])
+			if (input.pitchUp)
 			{
 				totalPitch += keyboardRotationSpeed * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_DOWN])
+			if (input.pitchDown)
 			{
 				totalPitch -= keyboardRotationSpeed * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_LEFT])
+			if (input.yawLeft)
 			{
 				totalYaw -= keyboardRotationSpeed * deltaTime;
 			}
-			if (pKeyboardState[SDL_SCANCODE_RIGHT])
+			if (input.yawRight)
 			{
 				totalYaw += keyboardRotationSpeed * deltaTime;
 			}
 			//Mouse Input
-			int mouseX{}, mouseY{};
-			const uint32_t mouseState = SDL_GetRelativeMouseState(&mouseX, &mouseY);
+			const int mouseX{ input.mouseX };
+			const int mouseY{ input.mouseY };
 
 			// Mouse movements / rotation of the camera
-			if ((mouseState & SDL_BUTTON(SDL_BUTTON_LEFT)) && mouseState & SDL_BUTTON(SDL_BUTTON_RIGHT))
+			if (input.isLeftMouseDown && input.isRightMouseDown)
 			{
 				// mouseX yaw left & right, mouse Y moves forwards & backwards
 				const float upwards = -mouseY * movementSpeed * deltaTime;
 				origin += up * upwards;
 			}
-			else if (mouseState & SDL_BUTTON(SDL_BUTTON_LEFT))
+			else if (input.isLeftMouseDown)
 			{
 				// mouseX yaw left & right, mouse Y moves forwards & backwards
 				const float forwards = -mouseY * deltaTime;
@@ -127,7 +123,7 @@ namespace dae
 				origin += forward * forwards;
 				totalYaw += yaw;
 			}
-			else if (mouseState & SDL_BUTTON(SDL_BUTTON_RIGHT))
+			else if (input.isRightMouseDown)
 			{
 				// Look around the current origin
 				const float pitch = -mouseY * rotationSpeed * deltaTime;
@@ -136,8 +132,15 @@ namespace dae
 				totalPitch += pitch;
 				totalYaw += yaw;
 			}
-			
-			totalPitch = std::clamp(totalPitch, -88.0f, 88.0f);
+
+			SetOrientation(totalPitch, totalYaw);
+		}
+
+		// Degrees, pitch gets clamped so the camera never looks straight up or down
+		void SetOrientation(float pitch, float yaw)
+		{
+			totalPitch = std::clamp(pitch, -88.0f, 88.0f);
+			totalYaw = yaw;
 			if (totalYaw > 360.0f)
 				totalYaw -= 360.0f;
 			else if (totalYaw < 0.0f)
@@ -0,0 +1,91 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+#include "Camera.h"
+
+namespace dae
+{
+	bool CameraPath::Load(const std::string& filename)
+	{
+		m_Keyframes.clear();
+		std::ifstream file{ filename };
+		if (!file)
+		{
+			std::cout << "Couldn't open camera path " << filename << '\n';
+			return false;
+		}
+
+		std::string line{};
+		uint32_t lineNumber{};
+		while (std::getline(file, line))
+		{
+			++lineNumber;
+			line = line.substr(0, line.find('#'));
+			if (line.find_first_not_of(" \t\r") == std::string::npos)
+				continue;
+
+			Keyframe keyframe{};
+			std::istringstream stream{ line };
+			std::string rest{};
+			if (!(stream >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >> keyframe.pitch >> keyframe.yaw >> keyframe.fov)
+				|| stream >> rest)
+			{
+				std::cout << filename << '(' << lineNumber << "): expected <time> <x> <y> <z> <pitch> <yaw> <fov>\n";
+				return false;
+			}
+			if (!m_Keyframes.empty() && keyframe.time <= m_Keyframes.back().time)
+			{
+				std::cout << filename << '(' << lineNumber << "): time has to be after the keyframe before it\n";
+				return false;
+			}
+			m_Keyframes.push_back(keyframe);
+		}
+
+		if (m_Keyframes.empty())
+			std::cout << "No keyframes in camera path " << filename << '\n';
+		return !m_Keyframes.empty();
+	}
+
+	void CameraPath::Apply(float time, Camera& camera) const
+	{
+		if (m_Keyframes.empty())
+			return;
+
+		// The first keyframe after time, the pose is somewhere between the one before it and that one
+		const auto next{ std::upper_bound(m_Keyframes.begin(), m_Keyframes.end(), time,
+			[](float value, const Keyframe& keyframe) { return value < keyframe.time; }) };
+		const Keyframe& from{ next == m_Keyframes.begin() ? *next : *(next - 1) };
+		const Keyframe& to{ next == m_Keyframes.end() ? m_Keyframes.back() : *next };
+		const float t{ to.time > from.time ? std::clamp((time - from.time) / (to.time - from.time), 0.f, 1.f) : 0.f };
+
+		// The camera keeps yaw in [0, 360], turning from 350 to 10 goes the short way
+		float yawDelta{ to.yaw - from.yaw };
+		if (yawDelta > 180.f)
+			yawDelta -= 360.f;
+		else if (yawDelta < -180.f)
+			yawDelta += 360.f;
+
+		camera.origin = from.position + (to.position - from.position) * t;
+		camera.SetOrientation(from.pitch + (to.pitch - from.pitch) * t, from.yaw + yawDelta * t);
+		camera.SetFov(from.fov + (to.fov - from.fov) * t);
+	}
+
+	CameraPathRecorder::CameraPathRecorder(const std::string& filename) :
+		m_File{ filename }
+	{
+		m_File << "# RayTracer camera path: <time> <x> <y> <z> <pitch> <yaw> <fov>\n";
+	}
+
+	void CameraPathRecorder::Record(float time, const Camera& camera)
+	{
+		// Straight into the file's buffer, recording doesn't allocate
+		char line[192];
+		const int lineSize{ std::snprintf(line, sizeof(line), "%.6f %.6f %.6f %.6f %.4f %.4f %.4f\n", time,
+			camera.origin.x, camera.origin.y, camera.origin.z, camera.totalPitch, camera.totalYaw, camera.fovAngle) };
+		m_File.write(line, lineSize);
+	}
+}
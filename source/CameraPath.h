@@ -0,0 +1,65 @@
+#pragma once
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	struct Camera;
+
+	// Camera poses over time, so a benchmark flies the same way on every run. A text file with one keyframe per line,
+	// times in seconds & increasing, angles in degrees, everything after a '#' is a comment:
+	//   <time> <x> <y> <z> <pitch> <yaw> <fov>
+	// Between keyframes the pose gets interpolated, a path plays back the same at any frame rate
+	class CameraPath final
+	{
+	public:
+		struct Keyframe
+		{
+			float time{};
+			Vector3 position{};
+			float pitch{};
+			float yaw{};
+			float fov{};
+		};
+
+		CameraPath() = default;
+		~CameraPath() = default;
+
+		CameraPath(const CameraPath&) = delete;
+		CameraPath(CameraPath&&) noexcept = delete;
+		CameraPath& operator=(const CameraPath&) = delete;
+		CameraPath& operator=(CameraPath&&) noexcept = delete;
+
+		// Prints what's wrong with the file
+		bool Load(const std::string& filename);
+
+		// Before the first & after the last keyframe the camera stays there
+		void Apply(float time, Camera& camera) const;
+		float GetDuration() const { return m_Keyframes.empty() ? 0.f : m_Keyframes.back().time; }
+
+	private:
+		std::vector<Keyframe> m_Keyframes{};
+	};
+
+	// Writes the camera's pose every frame in CameraPath's format, e.g. while flying around in the window
+	class CameraPathRecorder final
+	{
+	public:
+		explicit CameraPathRecorder(const std::string& filename);
+		~CameraPathRecorder() = default;
+
+		CameraPathRecorder(const CameraPathRecorder&) = delete;
+		CameraPathRecorder(CameraPathRecorder&&) noexcept = delete;
+		CameraPathRecorder& operator=(const CameraPathRecorder&) = delete;
+		CameraPathRecorder& operator=(CameraPathRecorder&&) noexcept = delete;
+
+		bool IsOpen() const { return m_File.is_open(); }
+		void Record(float time, const Camera& camera);
+
+	private:
+		std::ofstream m_File{};
+	};
+}
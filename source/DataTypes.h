@@ -2,6 +2,7 @@
 #include <cassert>
 
 #include "Math.h"
+#include "MeshCompression.h"
 #include "vector"
 #include <iostream>
 
@@ -24,6 +25,102 @@ namespace dae
 		unsigned char materialIndex{ 0 };
 	};
 
+	// Axis aligned box. A room box is one-sided: only its inside faces can be hit, like 6 planes facing inwards
+	struct Box
+	{
+		Vector3 minBounds{};
+		Vector3 maxBounds{};
+		bool isRoom{ false };
+
+		unsigned char materialIndex{ 0 };
+	};
+
+	struct OrientedBox
+	{
+		Vector3 center{};
+		Vector3 halfExtents{};
+
+		// Local axes of the box in world space (normalized)
+		Vector3 axisX{ Vector3::UnitX };
+		Vector3 axisY{ Vector3::UnitY };
+		Vector3 axisZ{ Vector3::UnitZ };
+
+		// World space bounds, used to skip the box test
+		Vector3 minAABB{};
+		Vector3 maxAABB{};
+
+		unsigned char materialIndex{ 0 };
+
+		void UpdateAABB()
+		{
+			// Projected half size of the box on every world axis
+			const Vector3 extent{
+				fabsf(axisX.x) * halfExtents.x + fabsf(axisY.x) * halfExtents.y + fabsf(axisZ.x) * halfExtents.z,
+				fabsf(axisX.y) * halfExtents.x + fabsf(axisY.y) * halfExtents.y + fabsf(axisZ.y) * halfExtents.z,
+				fabsf(axisX.z) * halfExtents.x + fabsf(axisY.z) * halfExtents.y + fabsf(axisZ.z) * halfExtents.z };
+			minAABB = center - extent;
+			maxAABB = center + extent;
+		}
+	};
+
+	// Two-sided disk
+	struct Disk
+	{
+		Vector3 origin{};
+		Vector3 normal{};
+		float radius{};
+
+		unsigned char materialIndex{ 0 };
+	};
+
+	// Two-sided parallelogram spanned by edgeU & edgeV from origin (a rectangle when the edges are perpendicular)
+	struct Quad
+	{
+		Vector3 origin{};
+		Vector3 edgeU{};
+		Vector3 edgeV{};
+
+		// Cached by UpdateNormal
+		Vector3 normal{};
+		Vector3 w{};  // cross(u, v) / |cross(u, v)|^2, used to get the planar coordinates of a hit
+
+		unsigned char materialIndex{ 0 };
+
+		void UpdateNormal()
+		{
+			const Vector3 n{ Vector3::Cross(edgeU, edgeV) };
+			w = n / n.SqrMagnitude();
+			normal = n.Normalized();
+		}
+	};
+
+	// Cylinder standing on origin along axis, optionally closed off with caps
+	struct Cylinder
+	{
+		Vector3 origin{};
+		Vector3 axis{ Vector3::UnitY };
+		float radius{};
+		float height{};
+		bool isCapped{ true };
+
+		Vector3 minAABB{};
+		Vector3 maxAABB{};
+
+		unsigned char materialIndex{ 0 };
+
+		void UpdateAABB()
+		{
+			// The caps are disks, a disk with normal n extends r * sqrt(1 - n_i^2) along world axis i
+			const Vector3 extent{
+				radius * sqrtf(std::max(0.f, 1.f - Square(axis.x))),
+				radius * sqrtf(std::max(0.f, 1.f - Square(axis.y))),
+				radius * sqrtf(std::max(0.f, 1.f - Square(axis.z))) };
+			const Vector3 top{ origin + axis * height };
+			minAABB = Vector3::Min(origin, top) - extent;
+			maxAABB = Vector3::Max(origin, top) + extent;
+		}
+	};
+
 	enum class TriangleCullMode
 	{
 		FrontFaceCulling,
@@ -80,6 +177,7 @@ namespace dae
 		std::vector<Vector3> normals{};
 		std::vector<int> indices{};
 		unsigned char materialIndex{};
+		std::vector<unsigned char> triangleMaterials{};  // one per triangle, empty when the whole mesh uses materialIndex
 
 		TriangleCullMode cullMode{ TriangleCullMode::BackFaceCulling };
 
@@ -99,6 +197,11 @@ namespace dae
 		std::vector<Vector3> transformedPositions{};
 		std::vector<Vector3> transformedNormals{};
 
+		// Compressed meshes only keep the object space data below, rays get transformed into object space instead
+		bool isCompressed{ false };
+		CompressedMeshData compressed{};
+		Matrix worldToObject{};
+
 
 		void Translate(const Vector3& translation)
 		{
@@ -122,6 +225,7 @@ namespace dae
 
 		void AppendTriangle(const Triangle& triangle, bool ignoreTransformUpdate = false)
 		{
+			assert(!isCompressed && "Can't append to a compressed mesh");
 			int startIndex = static_cast<int>(positions.size());
 
 			positions.push_back(triangle.v0);
@@ -132,11 +236,19 @@ namespace dae
 			indices.push_back(++startIndex);
 			indices.push_back(++startIndex);
 
+			if (!triangleMaterials.empty())
+				triangleMaterials.push_back(triangle.materialIndex);
+
 			//Not ideal, but making sure all vertices are updated
 			if (!ignoreTransformUpdate)
 				UpdateTransforms();
 		}
 
+		unsigned char GetTriangleMaterial(size_t triangle) const
+		{
+			return triangleMaterials.empty() ? materialIndex : triangleMaterials[triangle];
+		}
+
 		void CalculateNormals()
 		{
 			// Cross of 2 edges of the triangle (clockwise order of vertices because left handed system used
@@ -165,22 +277,35 @@ namespace dae
 			// First scale, then rotate, then translate
 			const auto finalTransform = scaleTransform * rotationTransform * translationTransform;
 
+			if (isCompressed)
+			{
+				// No per vertex work, only the inverse transform (inverse scale, transposed rotation, inverse translation)
+				const Vector3 scale{ scaleTransform[0].x, scaleTransform[1].y, scaleTransform[2].z };
+				worldToObject = Matrix::CreateTranslation(-translationTransform.GetTranslation())
+					* Matrix::Transpose(rotationTransform)
+					* Matrix::CreateScale(1.f / scale.x, 1.f / scale.y, 1.f / scale.z);
+
+				UpdateTransformedAABB(finalTransform);
+				return;
+			}
+
 			// Loop over every position & apply the transformation
-			transformedPositions.clear();
-			transformedPositions.reserve(positions.size());
-			for (const Vector3& p : positions)
+			// resize only allocates the first time, after that the existing elements get overwritten
+			const size_t positionsSize{ positions.size() };
+			transformedPositions.resize(positionsSize);
+			for (size_t i{}; i < positionsSize; ++i)
 			{
-				transformedPositions.emplace_back(finalTransform.TransformPoint(p));
+				transformedPositions[i] = finalTransform.TransformPoint(positions[i]);
 			}
 
 
 			//Transform Normals (normals > transformedNormals)
 			//...
-			transformedNormals.clear();
-			transformedNormals.reserve(normals.size());
-			for (const Vector3& n : normals)
+			const size_t normalsSize{ normals.size() };
+			transformedNormals.resize(normalsSize);
+			for (size_t i{}; i < normalsSize; ++i)
 			{
-				transformedNormals.emplace_back(rotationTransform.TransformVector(n));
+				transformedNormals[i] = rotationTransform.TransformVector(normals[i]);
 			}
 
 			UpdateTransformedAABB(finalTransform);
@@ -189,6 +314,14 @@ namespace dae
 		void UpdateAABB()
 		{
 			//Update Min/Max Axis-Aligned-Bounding-Box
+			if (isCompressed)
+			{
+				// The quantization range is the AABB the mesh was compressed with
+				minAABB = compressed.quantizationMin;
+				maxAABB = compressed.quantizationMin + compressed.quantizationScale * 65535.f;
+				return;
+			}
+
 			// Init with smallest/biggest possible values
 			minAABB = { FLT_MAX, FLT_MAX, FLT_MAX };
 			maxAABB = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
@@ -201,6 +334,60 @@ namespace dae
 			}
 		}
 
+		void Compress()
+		{
+			// Quantize positions to the object space AABB, so update it first
+			UpdateAABB();
+
+			const Vector3 extent{ maxAABB - minAABB };
+			const Vector3 invExtent{
+				extent.x > 0.f ? 1.f / extent.x : 0.f,
+				extent.y > 0.f ? 1.f / extent.y : 0.f,
+				extent.z > 0.f ? 1.f / extent.z : 0.f };
+
+			compressed = {};
+			compressed.quantizationMin = minAABB;
+			compressed.quantizationScale = extent / 65535.f;
+
+			compressed.positions.reserve(positions.size() * 3);
+			for (const Vector3& p : positions)
+			{
+				compressed.positions.push_back(MeshCompression::QuantizeUnorm16(p.x, minAABB.x, invExtent.x));
+				compressed.positions.push_back(MeshCompression::QuantizeUnorm16(p.y, minAABB.y, invExtent.y));
+				compressed.positions.push_back(MeshCompression::QuantizeUnorm16(p.z, minAABB.z, invExtent.z));
+			}
+
+			compressed.normals.reserve(normals.size());
+			for (const Vector3& n : normals)
+			{
+				compressed.normals.push_back(MeshCompression::EncodeOctahedral(n));
+			}
+
+			if (positions.size() <= UINT16_MAX + size_t(1))
+				compressed.indices16.assign(indices.begin(), indices.end());
+			else
+				compressed.indices32.assign(indices.begin(), indices.end());
+
+			// Release the full precision data
+			positions = {};
+			normals = {};
+			indices = {};
+			transformedPositions = {};
+			transformedNormals = {};
+
+			isCompressed = true;
+			UpdateTransforms();
+		}
+
+		size_t GetMemoryFootprint() const
+		{
+			if (isCompressed)
+				return compressed.GetMemoryFootprint();
+
+			return (positions.size() + normals.size() + transformedPositions.size() + transformedNormals.size()) * sizeof(Vector3)
+				+ indices.size() * sizeof(int);
+		}
+
 		void UpdateTransformedAABB(const Matrix& finalTransform)
 		{
 			// Instead of transforming every position, we can use the min/max AABB to calculate the transformed AAB		
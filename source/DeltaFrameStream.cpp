@@ -0,0 +1,319 @@
+#include "DeltaFrameStream.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace dae
+{
+	namespace
+	{
+		constexpr size_t HeaderSize{ 28 };
+		constexpr uint8_t KeyframeFlag{ 1 };
+
+		// LZ4 block format limits: a match starts at least 12 bytes before the end, the last 5 bytes are always literals
+		constexpr size_t MatchStartLimit{ 12 };
+		constexpr size_t LastLiterals{ 5 };
+		constexpr uint32_t MatchTableBits{ 12 };
+
+		uint32_t Read32(const uint8_t* pData)
+		{
+			uint32_t value{};
+			std::memcpy(&value, pData, sizeof(value));
+			return value;
+		}
+
+		void Write32(uint8_t* pData, uint32_t value)
+		{
+			for (uint32_t i{}; i < 4; ++i)
+				pData[i] = static_cast<uint8_t>(value >> (i * 8));
+		}
+
+		uint32_t ReadLittleEndian32(const uint8_t* pData)
+		{
+			return uint32_t{ pData[0] } | uint32_t{ pData[1] } << 8 | uint32_t{ pData[2] } << 16 | uint32_t{ pData[3] } << 24;
+		}
+
+		size_t GetCompressBound(size_t size)
+		{
+			return size + size / 255 + 16;
+		}
+
+		// Greedy LZ4: one hash table of 4 byte sequences, no chains. Skips ahead faster the longer it doesn't find anything
+		size_t CompressLZ4(const uint8_t* pSource, size_t size, uint8_t* pOutput, std::vector<uint32_t>& matchTable)
+		{
+			std::fill(matchTable.begin(), matchTable.end(), 0u);  // positions + 1, 0 is empty
+			uint8_t* pOut{ pOutput };
+			size_t anchor{};
+
+			const auto writeLength{ [&pOut](size_t length)
+				{
+					for (; length >= 255; length -= 255)
+						*pOut++ = 255;
+					*pOut++ = static_cast<uint8_t>(length);
+				} };
+			// Literals from the anchor up to literalEnd, then the match (none for the last sequence)
+			const auto writeSequence{ [&](size_t literalEnd, size_t matchLength, size_t offset)
+				{
+					const size_t literalLength{ literalEnd - anchor };
+					uint8_t* pToken{ pOut++ };
+					*pToken = static_cast<uint8_t>(std::min<size_t>(literalLength, 15) << 4);
+					if (literalLength >= 15)
+						writeLength(literalLength - 15);
+					std::memcpy(pOut, pSource + anchor, literalLength);
+					pOut += literalLength;
+
+					if (matchLength == 0)
+						return;
+					*pOut++ = static_cast<uint8_t>(offset);
+					*pOut++ = static_cast<uint8_t>(offset >> 8);
+					const size_t extraLength{ matchLength - 4 };
+					*pToken |= static_cast<uint8_t>(std::min<size_t>(extraLength, 15));
+					if (extraLength >= 15)
+						writeLength(extraLength - 15);
+				} };
+
+			if (size > MatchStartLimit)
+			{
+				const size_t matchStartEnd{ size - MatchStartLimit };
+				const size_t matchEnd{ size - LastLiterals };
+				size_t position{};
+				while (position < matchStartEnd)
+				{
+					const uint32_t sequence{ Read32(pSource + position) };
+					const uint32_t hash{ (sequence * 2654435761u) >> (32 - MatchTableBits) };
+					const size_t candidate{ matchTable[hash] };
+					matchTable[hash] = static_cast<uint32_t>(position + 1);
+
+					if (candidate == 0 || position - (candidate - 1) > 65535 || Read32(pSource + candidate - 1) != sequence)
+					{
+						position += 1 + ((position - anchor) >> 6);
+						continue;
+					}
+
+					const size_t matchStart{ candidate - 1 };
+					size_t matchLength{ 4 };
+					while (position + matchLength < matchEnd && pSource[matchStart + matchLength] == pSource[position + matchLength])
+						++matchLength;
+
+					writeSequence(position, matchLength, position - matchStart);
+					position += matchLength;
+					anchor = position;
+				}
+			}
+			writeSequence(size, 0, 0);
+			return static_cast<size_t>(pOut - pOutput);
+		}
+
+		bool DecompressLZ4(const uint8_t* pSource, size_t size, uint8_t* pDestination, size_t destinationSize)
+		{
+			size_t in{};
+			size_t out{};
+			const auto readLength{ [&](size_t& length)
+				{
+					uint8_t value{};
+					do
+					{
+						if (in >= size)
+							return false;
+						value = pSource[in++];
+						length += value;
+					} while (value == 255);
+					return true;
+				} };
+
+			while (in < size)
+			{
+				const uint8_t token{ pSource[in++] };
+				size_t literalLength{ size_t(token >> 4) };
+				if (literalLength == 15 && !readLength(literalLength))
+					return false;
+				if (literalLength > size - in || literalLength > destinationSize - out)
+					return false;
+				std::memcpy(pDestination + out, pSource + in, literalLength);
+				in += literalLength;
+				out += literalLength;
+
+				// The last sequence has no match
+				if (in == size)
+					return out == destinationSize;
+
+				if (size - in < 2)
+					return false;
+				const size_t offset{ size_t(pSource[in]) | size_t(pSource[in + 1]) << 8 };
+				in += 2;
+				size_t matchLength{ size_t(token & 15) };
+				if (matchLength == 15 && !readLength(matchLength))
+					return false;
+				matchLength += 4;
+				if (offset == 0 || offset > out || matchLength > destinationSize - out)
+					return false;
+
+				// Byte by byte, a match can overlap what it's copying
+				for (size_t i{}; i < matchLength; ++i, ++out)
+					pDestination[out] = pDestination[out - offset];
+			}
+			return false;
+		}
+
+		uint64_t HashTile(const uint32_t* pPixels, uint32_t stride, uint32_t width, uint32_t height)
+		{
+			uint64_t hash{ 0xcbf29ce484222325ull };
+			for (uint32_t y{}; y < height; ++y)
+			{
+				const uint32_t* pRow{ pPixels + size_t(y) * stride };
+				for (uint32_t x{}; x < width; ++x)
+				{
+					hash = (hash ^ pRow[x]) * 0x100000001b3ull;
+				}
+			}
+			return hash;
+		}
+	}
+
+	DeltaFrameEncoder::DeltaFrameEncoder(uint32_t tileSize) :
+		m_TileSize{ std::clamp(tileSize, 1u, 65535u) },
+		m_MatchTable(size_t(1) << MatchTableBits)
+	{
+	}
+
+	const std::vector<uint8_t>& DeltaFrameEncoder::Encode(const uint32_t* pPixels, uint32_t width, uint32_t height, const FrameWriter::PixelLayout& layout)
+	{
+		const uint32_t tilesX{ (width + m_TileSize - 1) / m_TileSize };
+		const uint32_t tilesY{ (height + m_TileSize - 1) / m_TileSize };
+		const uint32_t tileCount{ tilesX * tilesY };
+		const size_t maskSize{ (size_t(tileCount) + 7) / 8 };
+
+		// A viewer can't patch a frame of another size
+		const bool isKeyframe{ width != m_Width || height != m_Height };
+		if (isKeyframe)
+		{
+			m_Width = width;
+			m_Height = height;
+			m_TileHashes.assign(tileCount, 0);
+			m_ChangedRGB.resize(size_t(width) * height * 3);
+			m_Message.reserve(HeaderSize + maskSize + GetCompressBound(m_ChangedRGB.size()));
+		}
+
+		m_Message.assign(HeaderSize + maskSize, 0);
+		uint8_t* pMask{ m_Message.data() + HeaderSize };
+		uint32_t changedTileCount{};
+		size_t rawSize{};
+		for (uint32_t tileIndex{}; tileIndex < tileCount; ++tileIndex)
+		{
+			const uint32_t tileX{ tileIndex % tilesX * m_TileSize };
+			const uint32_t tileY{ tileIndex / tilesX * m_TileSize };
+			const uint32_t tileWidth{ std::min(m_TileSize, width - tileX) };
+			const uint32_t tileHeight{ std::min(m_TileSize, height - tileY) };
+			const uint32_t* pTile{ pPixels + size_t(tileY) * width + tileX };
+
+			const uint64_t hash{ HashTile(pTile, width, tileWidth, tileHeight) };
+			if (!isKeyframe && hash == m_TileHashes[tileIndex])
+				continue;
+
+			m_TileHashes[tileIndex] = hash;
+			pMask[tileIndex / 8] |= static_cast<uint8_t>(1 << (tileIndex % 8));
+			++changedTileCount;
+			for (uint32_t y{}; y < tileHeight; ++y)
+			{
+				const uint32_t* pRow{ pTile + size_t(y) * width };
+				for (uint32_t x{}; x < tileWidth; ++x)
+				{
+					m_ChangedRGB[rawSize++] = static_cast<uint8_t>(pRow[x] >> layout.redShift);
+					m_ChangedRGB[rawSize++] = static_cast<uint8_t>(pRow[x] >> layout.greenShift);
+					m_ChangedRGB[rawSize++] = static_cast<uint8_t>(pRow[x] >> layout.blueShift);
+				}
+			}
+		}
+
+		const size_t dataStart{ m_Message.size() };
+		m_Message.resize(dataStart + GetCompressBound(rawSize));
+		const size_t compressedSize{ CompressLZ4(m_ChangedRGB.data(), rawSize, m_Message.data() + dataStart, m_MatchTable) };
+		m_Message.resize(dataStart + compressedSize);
+
+		uint8_t* pHeader{ m_Message.data() };
+		std::memcpy(pHeader, "DFS1", 4);
+		Write32(pHeader + 4, width);
+		Write32(pHeader + 8, height);
+		pHeader[12] = static_cast<uint8_t>(m_TileSize);
+		pHeader[13] = static_cast<uint8_t>(m_TileSize >> 8);
+		pHeader[14] = isKeyframe ? KeyframeFlag : 0;
+		pHeader[15] = 0;
+		Write32(pHeader + 16, changedTileCount);
+		Write32(pHeader + 20, static_cast<uint32_t>(rawSize));
+		Write32(pHeader + 24, static_cast<uint32_t>(compressedSize));
+
+		m_Statistics = { changedTileCount, tileCount, rawSize, m_Message.size(), isKeyframe };
+		return m_Message;
+	}
+
+	bool DeltaFrameDecoder::Decode(const uint8_t* pMessage, size_t size)
+	{
+		if (size < HeaderSize || std::memcmp(pMessage, "DFS1", 4) != 0)
+			return false;
+
+		const uint32_t width{ ReadLittleEndian32(pMessage + 4) };
+		const uint32_t height{ ReadLittleEndian32(pMessage + 8) };
+		const uint32_t tileSize{ uint32_t{ pMessage[12] } | uint32_t{ pMessage[13] } << 8 };
+		const bool isKeyframe{ (pMessage[14] & KeyframeFlag) != 0 };
+		const uint32_t changedTileCount{ ReadLittleEndian32(pMessage + 16) };
+		const size_t rawSize{ ReadLittleEndian32(pMessage + 20) };
+		const size_t compressedSize{ ReadLittleEndian32(pMessage + 24) };
+		if (width == 0 || height == 0 || tileSize == 0 || (!isKeyframe && (width != m_Width || height != m_Height)))
+			return false;
+
+		const uint32_t tilesX{ (width + tileSize - 1) / tileSize };
+		const uint32_t tilesY{ (height + tileSize - 1) / tileSize };
+		const uint32_t tileCount{ tilesX * tilesY };
+		const size_t maskSize{ (size_t(tileCount) + 7) / 8 };
+		if (size != HeaderSize + maskSize + compressedSize)
+			return false;
+
+		// The mask has to agree with the counts before anything gets written
+		const uint8_t* pMask{ pMessage + HeaderSize };
+		const auto isChanged{ [pMask](uint32_t tileIndex) { return (pMask[tileIndex / 8] >> (tileIndex % 8) & 1) != 0; } };
+		uint32_t maskedCount{};
+		size_t maskedSize{};
+		for (uint32_t tileIndex{}; tileIndex < tileCount; ++tileIndex)
+		{
+			if (!isChanged(tileIndex))
+				continue;
+			++maskedCount;
+			maskedSize += size_t(std::min(tileSize, width - tileIndex % tilesX * tileSize)) * std::min(tileSize, height - tileIndex / tilesX * tileSize) * 3;
+		}
+		if (maskedCount != changedTileCount || maskedSize != rawSize)
+			return false;
+
+		m_ChangedRGB.resize(rawSize);
+		if (!DecompressLZ4(pMask + maskSize, compressedSize, m_ChangedRGB.data(), rawSize))
+			return false;
+
+		if (isKeyframe)
+		{
+			m_Width = width;
+			m_Height = height;
+			m_Pixels.assign(size_t(width) * height, 0);
+		}
+
+		const FrameWriter::PixelLayout layout{};
+		const uint8_t* pRGB{ m_ChangedRGB.data() };
+		for (uint32_t tileIndex{}; tileIndex < tileCount; ++tileIndex)
+		{
+			if (!isChanged(tileIndex))
+				continue;
+
+			const uint32_t tileX{ tileIndex % tilesX * tileSize };
+			const uint32_t tileY{ tileIndex / tilesX * tileSize };
+			const uint32_t tileWidth{ std::min(tileSize, width - tileX) };
+			const uint32_t tileHeight{ std::min(tileSize, height - tileY) };
+			for (uint32_t y{}; y < tileHeight; ++y)
+			{
+				uint32_t* pRow{ m_Pixels.data() + size_t(tileY + y) * width + tileX };
+				for (uint32_t x{}; x < tileWidth; ++x, pRGB += 3)
+				{
+					pRow[x] = uint32_t{ pRGB[0] } << layout.redShift | uint32_t{ pRGB[1] } << layout.greenShift | uint32_t{ pRGB[2] } << layout.blueShift;
+				}
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "FrameWriter.h"
+
+namespace dae
+{
+	// Frames for a viewer that keeps its own copy of the image: only the tiles that changed since the previous frame are sent.
+	// Every tile gets a 64 bit hash, the ones that differ from last time are packed as 8 bit RGB one after the other and
+	// compressed as one LZ4 block (the plain block format, liblz4's LZ4_decompress_safe reads it too).
+	//
+	// A message, little endian:
+	//   "DFS1", uint32 width, uint32 height, uint16 tileSize, uint8 flags (1 = keyframe), uint8 0,
+	//   uint32 changed tile count, uint32 RGB byte count, uint32 compressed byte count,
+	//   one bit per tile (row by row, bit i of byte i / 8 is tile i), the compressed RGB
+	// Border tiles are cropped to the image. A keyframe has every tile, the first frame and every size change are one
+	class DeltaFrameEncoder final
+	{
+	public:
+		struct Statistics
+		{
+			uint32_t changedTileCount{};
+			uint32_t tileCount{};
+			size_t rawSize{};      // RGB bytes of the changed tiles
+			size_t messageSize{};
+			bool isKeyframe{};
+		};
+
+		explicit DeltaFrameEncoder(uint32_t tileSize = 32);
+		~DeltaFrameEncoder() = default;
+
+		DeltaFrameEncoder(const DeltaFrameEncoder&) = delete;
+		DeltaFrameEncoder(DeltaFrameEncoder&&) noexcept = delete;
+		DeltaFrameEncoder& operator=(const DeltaFrameEncoder&) = delete;
+		DeltaFrameEncoder& operator=(DeltaFrameEncoder&&) noexcept = delete;
+
+		// The next frame is a keyframe, e.g. for a viewer that (re)connects
+		void Reset() { m_Width = 0; }
+
+		/**
+		 * \brief The message for this frame, valid until the next Encode. Once the size is known it doesn't allocate anymore
+		 * \param pPixels width * height packed pixels
+		 */
+		const std::vector<uint8_t>& Encode(const uint32_t* pPixels, uint32_t width, uint32_t height, const FrameWriter::PixelLayout& layout);
+
+		const Statistics& GetStatistics() const { return m_Statistics; }
+
+	private:
+		uint32_t m_TileSize{};
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		std::vector<uint64_t> m_TileHashes{};
+		std::vector<uint8_t> m_ChangedRGB{};
+		std::vector<uint32_t> m_MatchTable{};
+		std::vector<uint8_t> m_Message{};
+		Statistics m_Statistics{};
+	};
+
+	// The viewer's side: patches its frame with every message
+	class DeltaFrameDecoder final
+	{
+	public:
+		DeltaFrameDecoder() = default;
+		~DeltaFrameDecoder() = default;
+
+		DeltaFrameDecoder(const DeltaFrameDecoder&) = delete;
+		DeltaFrameDecoder(DeltaFrameDecoder&&) noexcept = delete;
+		DeltaFrameDecoder& operator=(const DeltaFrameDecoder&) = delete;
+		DeltaFrameDecoder& operator=(DeltaFrameDecoder&&) noexcept = delete;
+
+		// False for broken messages, and for a delta before any keyframe or of another size. The frame stays as it was then
+		bool Decode(const uint8_t* pMessage, size_t size);
+
+		// Packed in the default PixelLayout
+		const std::vector<uint32_t>& GetPixels() const { return m_Pixels; }
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+
+	private:
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		std::vector<uint32_t> m_Pixels{};
+		std::vector<uint8_t> m_ChangedRGB{};
+	};
+}
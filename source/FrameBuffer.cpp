@@ -0,0 +1,167 @@
+#include "FrameBuffer.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define FRAMEBUFFER_SSE
+#include <emmintrin.h>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		template<ToneMapping Mode>
+		uint32_t ToneMapPixel(float r, float g, float b, const FrameWriter::PixelLayout& layout)
+		{
+			if constexpr (Mode == ToneMapping::MaxToOne)
+			{
+				// ColorRGB::MaxToOne, as a multiplication so it rounds exactly like the SSE path
+				const float scale{ 1.f / std::max(std::max(r, std::max(g, b)), 1.f) };
+				r *= scale;
+				g *= scale;
+				b *= scale;
+			}
+			else if constexpr (Mode == ToneMapping::Reinhard)
+			{
+				r /= 1.f + r;
+				g /= 1.f + g;
+				b /= 1.f + b;
+			}
+			else
+			{
+				const auto aces{ [](float x) { return (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f); } };
+				r = aces(r);
+				g = aces(g);
+				b = aces(b);
+			}
+
+			const auto toByte{ [](float value) { return static_cast<uint32_t>(std::clamp(value, 0.f, 1.f) * 255.f); } };
+			return toByte(r) << layout.redShift | toByte(g) << layout.greenShift | toByte(b) << layout.blueShift | layout.alphaMask;
+		}
+
+#ifdef FRAMEBUFFER_SSE
+		template<ToneMapping Mode>
+		__m128i ToneMapPixels(__m128 r, __m128 g, __m128 b, const FrameWriter::PixelLayout& layout)
+		{
+			const __m128 zero{ _mm_setzero_ps() };
+			const __m128 one{ _mm_set1_ps(1.f) };
+
+			if constexpr (Mode == ToneMapping::MaxToOne)
+			{
+				// Dividing by max(largest channel, 1) leaves colors that are in range alone
+				const __m128 largest{ _mm_max_ps(r, _mm_max_ps(g, b)) };
+				const __m128 scale{ _mm_div_ps(one, _mm_max_ps(largest, one)) };
+				r = _mm_mul_ps(r, scale);
+				g = _mm_mul_ps(g, scale);
+				b = _mm_mul_ps(b, scale);
+			}
+			else if constexpr (Mode == ToneMapping::Reinhard)
+			{
+				r = _mm_div_ps(r, _mm_add_ps(one, r));
+				g = _mm_div_ps(g, _mm_add_ps(one, g));
+				b = _mm_div_ps(b, _mm_add_ps(one, b));
+			}
+			else
+			{
+				const auto aces{ [](__m128 x)
+					{
+						const __m128 numerator{ _mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.51f), x), _mm_set1_ps(0.03f))) };
+						const __m128 denominator{ _mm_add_ps(_mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.43f), x), _mm_set1_ps(0.59f))), _mm_set1_ps(0.14f)) };
+						return _mm_div_ps(numerator, denominator);
+					} };
+				r = aces(r);
+				g = aces(g);
+				b = aces(b);
+			}
+
+			// Clamp, scale & truncate, the same as the scalar path
+			const __m128 maxByte{ _mm_set1_ps(255.f) };
+			const __m128i red{ _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(r, zero), one), maxByte)) };
+			const __m128i green{ _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(g, zero), one), maxByte)) };
+			const __m128i blue{ _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(b, zero), one), maxByte)) };
+
+			__m128i packed{ _mm_set1_epi32(static_cast<int>(layout.alphaMask)) };
+			packed = _mm_or_si128(packed, _mm_sll_epi32(red, _mm_cvtsi32_si128(static_cast<int>(layout.redShift))));
+			packed = _mm_or_si128(packed, _mm_sll_epi32(green, _mm_cvtsi32_si128(static_cast<int>(layout.greenShift))));
+			packed = _mm_or_si128(packed, _mm_sll_epi32(blue, _mm_cvtsi32_si128(static_cast<int>(layout.blueShift))));
+			return packed;
+		}
+#endif
+
+		template<ToneMapping Mode>
+		void ToneMapAll(const float* pRed, const float* pGreen, const float* pBlue, uint32_t pixelCount, uint32_t* pDestination,
+			const FrameWriter::PixelLayout& layout, float exposure)
+		{
+			uint32_t i{};
+#ifdef FRAMEBUFFER_SSE
+			const __m128 exposures{ _mm_set1_ps(exposure) };
+			for (; i + 4 <= pixelCount; i += 4)
+			{
+				const __m128 r{ _mm_mul_ps(_mm_loadu_ps(pRed + i), exposures) };
+				const __m128 g{ _mm_mul_ps(_mm_loadu_ps(pGreen + i), exposures) };
+				const __m128 b{ _mm_mul_ps(_mm_loadu_ps(pBlue + i), exposures) };
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pDestination + i), ToneMapPixels<Mode>(r, g, b, layout));
+			}
+#endif
+			// Whatever doesn't fill a group of 4 (everything without SSE)
+			for (; i < pixelCount; ++i)
+			{
+				pDestination[i] = ToneMapPixel<Mode>(pRed[i] * exposure, pGreen[i] * exposure, pBlue[i] * exposure, layout);
+			}
+		}
+	}
+
+	void FrameBuffer::Resize(uint32_t width, uint32_t height)
+	{
+		m_Width = width;
+		m_Height = height;
+
+		const size_t pixelCount{ size_t(width) * height };
+		m_Red.assign(pixelCount, 0.f);
+		m_Green.assign(pixelCount, 0.f);
+		m_Blue.assign(pixelCount, 0.f);
+	}
+
+	void FrameBuffer::ToneMap(uint32_t* pDestination, const FrameWriter::PixelLayout& layout, ToneMapping toneMapping, float exposure) const
+	{
+		switch (toneMapping)
+		{
+		case ToneMapping::MaxToOne:
+			ToneMapAll<ToneMapping::MaxToOne>(m_Red.data(), m_Green.data(), m_Blue.data(), GetPixelCount(), pDestination, layout, exposure);
+			break;
+		case ToneMapping::Reinhard:
+			ToneMapAll<ToneMapping::Reinhard>(m_Red.data(), m_Green.data(), m_Blue.data(), GetPixelCount(), pDestination, layout, exposure);
+			break;
+		case ToneMapping::ACES:
+			ToneMapAll<ToneMapping::ACES>(m_Red.data(), m_Green.data(), m_Blue.data(), GetPixelCount(), pDestination, layout, exposure);
+			break;
+		}
+	}
+
+	bool FrameBuffer::SavePFM(const std::string& filename) const
+	{
+		std::FILE* pFile{ std::fopen(filename.c_str(), "wb") };
+		if (pFile == nullptr)
+			return false;
+
+		// A negative scale means little endian
+		std::fprintf(pFile, "PF\n%u %u\n-1.0\n", m_Width, m_Height);
+
+		std::vector<float> row(size_t(m_Width) * 3);
+		bool isWritten{ true };
+		for (uint32_t y{ m_Height }; y-- > 0 && isWritten;)
+		{
+			for (uint32_t x{}; x < m_Width; ++x)
+			{
+				const size_t index{ size_t(y) * m_Width + x };
+				row[x * 3] = m_Red[index];
+				row[x * 3 + 1] = m_Green[index];
+				row[x * 3 + 2] = m_Blue[index];
+			}
+			isWritten = std::fwrite(row.data(), sizeof(float), row.size(), pFile) == row.size();
+		}
+		return std::fclose(pFile) == 0 && isWritten;
+	}
+}
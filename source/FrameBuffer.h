@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ColorRGB.h"
+#include "FrameWriter.h"
+
+namespace dae
+{
+	enum class ToneMapping
+	{
+		MaxToOne,  // divide by the largest channel when it's above 1 (the original look, keeps the hue)
+		Reinhard,  // c / (1 + c) per channel
+		ACES       // Narkowicz' fit of the ACES filmic curve
+	};
+
+	// Linear float RGB render target, the renderer writes radiance here and nothing gets clamped or quantized
+	// until ToneMap packs it to the display format. Planar (a red, green & blue array) so 4 pixels load at once
+	class FrameBuffer final
+	{
+	public:
+		FrameBuffer() = default;
+		FrameBuffer(uint32_t width, uint32_t height) { Resize(width, height); }
+		~FrameBuffer() = default;
+
+		FrameBuffer(const FrameBuffer&) = delete;
+		FrameBuffer(FrameBuffer&&) noexcept = delete;
+		FrameBuffer& operator=(const FrameBuffer&) = delete;
+		FrameBuffer& operator=(FrameBuffer&&) noexcept = delete;
+
+		void Resize(uint32_t width, uint32_t height);
+
+		void SetPixel(uint32_t index, const ColorRGB& color)
+		{
+			m_Red[index] = color.r;
+			m_Green[index] = color.g;
+			m_Blue[index] = color.b;
+		}
+
+		ColorRGB GetPixel(uint32_t index) const { return { m_Red[index], m_Green[index], m_Blue[index] }; }
+
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+		uint32_t GetPixelCount() const { return m_Width * m_Height; }
+
+		/**
+		 * \brief Exposure, tone mapping & the conversion to 8 bit for width * height packed pixels, 4 pixels per step with SSE2.
+		 * Channels are truncated to 8 bit, like the renderer always did
+		 */
+		void ToneMap(uint32_t* pDestination, const FrameWriter::PixelLayout& layout, ToneMapping toneMapping, float exposure = 1.f) const;
+
+		// Portable float map: little endian float RGB, rows bottom to top. Values are written as is, no tone mapping
+		bool SavePFM(const std::string& filename) const;
+
+	private:
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+
+		std::vector<float> m_Red{};
+		std::vector<float> m_Green{};
+		std::vector<float> m_Blue{};
+	};
+}
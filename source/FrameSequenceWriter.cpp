@@ -0,0 +1,235 @@
+#include "FrameSequenceWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		constexpr size_t StreamBufferSize{ 4 * 1024 * 1024 };
+		constexpr char FrameHeader[]{ "FRAME\n" };
+
+		// BT.601, limited range (what players assume for Y4M unless told otherwise)
+		uint8_t ToY(int r, int g, int b) { return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16); }
+		uint8_t ToU(int r, int g, int b) { return static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128); }
+		uint8_t ToV(int r, int g, int b) { return static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128); }
+	}
+
+	FrameSequenceWriter::FrameSequenceWriter(uint32_t width, uint32_t height, const FrameWriter::PixelLayout& layout, SequenceFormat format, uint32_t framesPerSecond) :
+		m_Width{ width },
+		m_Height{ height },
+		m_Layout{ layout },
+		m_Format{ format },
+		m_FramesPerSecond{ framesPerSecond }
+	{
+		for (Buffer& buffer : m_Buffers)
+		{
+			buffer.pixels.resize(size_t(width) * height);
+		}
+	}
+
+	FrameSequenceWriter::~FrameSequenceWriter()
+	{
+		if (m_Thread.joinable())
+		{
+			{
+				std::lock_guard lock{ m_Mutex };
+				m_IsStopping = true;
+			}
+			m_BufferChanged.notify_all();
+			m_Thread.join();
+		}
+
+		if (m_pFile != nullptr)
+		{
+			if (m_IsStdout)
+				std::fflush(m_pFile);
+			else
+				std::fclose(m_pFile);
+		}
+	}
+
+	bool FrameSequenceWriter::Open(const std::string& path)
+	{
+		if (m_pFile != nullptr)
+			return false;
+
+		m_IsStdout = path == "-";
+		if (m_IsStdout)
+		{
+#if defined(_WIN32)
+			// Text mode would turn every 0x0A byte into 0x0D 0x0A
+			_setmode(_fileno(stdout), _O_BINARY);
+#endif
+			m_pFile = stdout;
+		}
+		else
+		{
+			m_pFile = std::fopen(path.c_str(), "wb");
+			if (m_pFile == nullptr)
+				return false;
+		}
+		std::setvbuf(m_pFile, nullptr, _IOFBF, StreamBufferSize);
+
+		if (m_Format == SequenceFormat::Y4M)
+		{
+			char header[128]{};
+			const int headerSize{ std::snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", m_Width, m_Height, m_FramesPerSecond) };
+			std::fwrite(header, 1, headerSize, m_pFile);
+		}
+
+		m_Thread = std::thread{ &FrameSequenceWriter::Run, this };
+		return true;
+	}
+
+	bool FrameSequenceWriter::Submit(const uint32_t* pPixels)
+	{
+		if (m_pFile == nullptr)
+			return false;
+
+		std::unique_lock lock{ m_Mutex };
+		Buffer& buffer{ m_Buffers[m_SubmitIndex] };
+		if (buffer.isFull && !m_HasFailed)
+		{
+			const auto waitStart{ std::chrono::steady_clock::now() };
+			m_BufferChanged.wait(lock, [&] { return !buffer.isFull || m_HasFailed; });
+			m_WaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+		}
+		if (m_HasFailed)
+			return false;
+		lock.unlock();
+
+		// The writer only reads full buffers, this one is ours until it's marked full
+		std::memcpy(buffer.pixels.data(), pPixels, buffer.pixels.size() * sizeof(uint32_t));
+
+		lock.lock();
+		buffer.isFull = true;
+		m_SubmitIndex ^= 1;
+		lock.unlock();
+
+		m_BufferChanged.notify_all();
+		return true;
+	}
+
+	uint64_t FrameSequenceWriter::GetWrittenCount() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return m_WrittenCount;
+	}
+
+	float FrameSequenceWriter::GetWaitSeconds() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return static_cast<float>(m_WaitSeconds);
+	}
+
+	void FrameSequenceWriter::Run()
+	{
+		std::vector<uint8_t> output{};
+		uint32_t writeIndex{};
+
+		std::unique_lock lock{ m_Mutex };
+		while (true)
+		{
+			Buffer& buffer{ m_Buffers[writeIndex] };
+			m_BufferChanged.wait(lock, [&] { return buffer.isFull || m_IsStopping; });
+			if (!buffer.isFull)
+				break;  // stopping, frames are written in order so the other buffer is empty too
+			lock.unlock();
+
+			const size_t size{ ConvertFrame(buffer.pixels.data(), output) };
+			const bool isWritten{ std::fwrite(output.data(), 1, size, m_pFile) == size };
+
+			lock.lock();
+			buffer.isFull = false;
+			writeIndex ^= 1;
+			if (isWritten)
+				++m_WrittenCount;
+			else
+				m_HasFailed = true;
+			m_BufferChanged.notify_all();
+
+			if (!isWritten)
+			{
+				std::cout << "Frame sequence: writing failed after " << m_WrittenCount << " frames\n";
+				break;
+			}
+		}
+		lock.unlock();
+		std::fflush(m_pFile);
+	}
+
+	size_t FrameSequenceWriter::ConvertFrame(const uint32_t* pPixels, std::vector<uint8_t>& output) const
+	{
+		const auto getChannels{ [this](uint32_t pixel, int& r, int& g, int& b)
+			{
+				r = static_cast<uint8_t>(pixel >> m_Layout.redShift);
+				g = static_cast<uint8_t>(pixel >> m_Layout.greenShift);
+				b = static_cast<uint8_t>(pixel >> m_Layout.blueShift);
+			} };
+
+		const size_t pixelCount{ size_t(m_Width) * m_Height };
+		if (m_Format == SequenceFormat::RawRGB)
+		{
+			output.resize(pixelCount * 3);
+			uint8_t* pOutput{ output.data() };
+			for (size_t i{}; i < pixelCount; ++i, pOutput += 3)
+			{
+				int r{}, g{}, b{};
+				getChannels(pPixels[i], r, g, b);
+				pOutput[0] = static_cast<uint8_t>(r);
+				pOutput[1] = static_cast<uint8_t>(g);
+				pOutput[2] = static_cast<uint8_t>(b);
+			}
+			return output.size();
+		}
+
+		// "FRAME\n", full resolution Y, then U & V at half resolution (each chroma sample averages up to 2x2 pixels)
+		const uint32_t chromaWidth{ (m_Width + 1) / 2 };
+		const uint32_t chromaHeight{ (m_Height + 1) / 2 };
+		const size_t chromaSize{ size_t(chromaWidth) * chromaHeight };
+		const size_t headerSize{ sizeof(FrameHeader) - 1 };
+		output.resize(headerSize + pixelCount + chromaSize * 2);
+
+		std::memcpy(output.data(), FrameHeader, headerSize);
+		uint8_t* pY{ output.data() + headerSize };
+		uint8_t* pU{ pY + pixelCount };
+		uint8_t* pV{ pU + chromaSize };
+
+		for (uint32_t chromaY{}; chromaY < chromaHeight; ++chromaY)
+		{
+			for (uint32_t chromaX{}; chromaX < chromaWidth; ++chromaX)
+			{
+				int sumR{}, sumG{}, sumB{}, count{};
+				for (uint32_t y{ chromaY * 2 }; y < std::min(chromaY * 2 + 2, m_Height); ++y)
+				{
+					for (uint32_t x{ chromaX * 2 }; x < std::min(chromaX * 2 + 2, m_Width); ++x)
+					{
+						int r{}, g{}, b{};
+						getChannels(pPixels[size_t(y) * m_Width + x], r, g, b);
+						pY[size_t(y) * m_Width + x] = ToY(r, g, b);
+						sumR += r;
+						sumG += g;
+						sumB += b;
+						++count;
+					}
+				}
+
+				const int r{ (sumR + count / 2) / count };
+				const int g{ (sumG + count / 2) / count };
+				const int b{ (sumB + count / 2) / count };
+				pU[size_t(chromaY) * chromaWidth + chromaX] = ToU(r, g, b);
+				pV[size_t(chromaY) * chromaWidth + chromaX] = ToV(r, g, b);
+			}
+		}
+		return output.size();
+	}
+}
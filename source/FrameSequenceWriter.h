@@ -0,0 +1,80 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameWriter.h"
+
+namespace dae
+{
+	enum class SequenceFormat
+	{
+		RawRGB,  // packed 8 bit RGB, nothing else: ffmpeg -f rawvideo -pix_fmt rgb24 -s WxH -r FPS -i <file>
+		Y4M      // YUV4MPEG2 4:2:0 with a header, encoders read the size & frame rate from the stream
+	};
+
+	// Streams every submitted frame into one file or stdout, for an external encoder to consume.
+	// Double buffered: the renderer copies into one buffer while the writer thread converts & writes the other
+	class FrameSequenceWriter final
+	{
+	public:
+		FrameSequenceWriter(uint32_t width, uint32_t height, const FrameWriter::PixelLayout& layout, SequenceFormat format, uint32_t framesPerSecond = 30);
+		// Writes the frame that's still pending and closes the output
+		~FrameSequenceWriter();
+
+		FrameSequenceWriter(const FrameSequenceWriter&) = delete;
+		FrameSequenceWriter(FrameSequenceWriter&&) noexcept = delete;
+		FrameSequenceWriter& operator=(const FrameSequenceWriter&) = delete;
+		FrameSequenceWriter& operator=(FrameSequenceWriter&&) noexcept = delete;
+
+		// "-" streams to stdout (switched to binary mode), anything else is a file that gets overwritten
+		bool Open(const std::string& path);
+
+		/**
+		 * \brief Copies the frame (width * height pixels) into the free buffer, waits when the writer still has both.
+		 * Doesn't allocate
+		 * \return false once writing failed (disk full, the encoder on the other end of the pipe quit, ...)
+		 */
+		bool Submit(const uint32_t* pPixels);
+
+		uint64_t GetWrittenCount() const;
+		// Total time Submit spent waiting for the writer
+		float GetWaitSeconds() const;
+
+	private:
+		struct Buffer
+		{
+			std::vector<uint32_t> pixels{};
+			bool isFull{};
+		};
+
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		FrameWriter::PixelLayout m_Layout{};
+		SequenceFormat m_Format{};
+		uint32_t m_FramesPerSecond{};
+
+		std::FILE* m_pFile{};
+		bool m_IsStdout{};
+
+		Buffer m_Buffers[2]{};
+		uint32_t m_SubmitIndex{};  // buffer the next Submit fills
+
+		uint64_t m_WrittenCount{};
+		double m_WaitSeconds{};
+		bool m_HasFailed{};
+		bool m_IsStopping{};
+
+		mutable std::mutex m_Mutex{};
+		std::condition_variable m_BufferChanged{};
+		std::thread m_Thread{};
+
+		void Run();
+		// Converts to the output format, returns the amount of bytes
+		size_t ConvertFrame(const uint32_t* pPixels, std::vector<uint8_t>& output) const;
+	};
+}
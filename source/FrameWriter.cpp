@@ -0,0 +1,394 @@
+#include "FrameWriter.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+
+namespace dae
+{
+	namespace
+	{
+		struct RGB
+		{
+			uint8_t r{};
+			uint8_t g{};
+			uint8_t b{};
+		};
+
+		RGB ToRGB(uint32_t pixel, const FrameWriter::PixelLayout& layout)
+		{
+			return {
+				static_cast<uint8_t>(pixel >> layout.redShift),
+				static_cast<uint8_t>(pixel >> layout.greenShift),
+				static_cast<uint8_t>(pixel >> layout.blueShift) };
+		}
+
+		void Append(std::vector<uint8_t>& output, const void* pData, size_t size)
+		{
+			const uint8_t* pBytes{ static_cast<const uint8_t*>(pData) };
+			output.insert(output.end(), pBytes, pBytes + size);
+		}
+
+		void AppendLittleEndian(std::vector<uint8_t>& output, uint32_t value, size_t byteCount)
+		{
+			for (size_t i{}; i < byteCount; ++i)
+			{
+				output.push_back(static_cast<uint8_t>(value >> (8 * i)));
+			}
+		}
+
+		void AppendBigEndian(std::vector<uint8_t>& output, uint32_t value)
+		{
+			for (int i{ 3 }; i >= 0; --i)
+			{
+				output.push_back(static_cast<uint8_t>(value >> (8 * i)));
+			}
+		}
+
+		void EncodePPM(const uint32_t* pPixels, uint32_t width, uint32_t height, const FrameWriter::PixelLayout& layout, std::vector<uint8_t>& output)
+		{
+			char header[64]{};
+			const int headerSize{ std::snprintf(header, sizeof(header), "P6\n%u %u\n255\n", width, height) };
+			Append(output, header, headerSize);
+
+			const size_t start{ output.size() };
+			output.resize(start + size_t(width) * height * 3);
+			uint8_t* pOutput{ output.data() + start };
+			for (size_t i{}; i < size_t(width) * height; ++i, pOutput += 3)
+			{
+				const RGB color{ ToRGB(pPixels[i], layout) };
+				pOutput[0] = color.r;
+				pOutput[1] = color.g;
+				pOutput[2] = color.b;
+			}
+		}
+
+		void EncodeBMP(const uint32_t* pPixels, uint32_t width, uint32_t height, const FrameWriter::PixelLayout& layout, std::vector<uint8_t>& output)
+		{
+			// Rows are BGR, bottom to top, padded to 4 bytes
+			const uint32_t rowSize{ (width * 3 + 3) & ~3u };
+			const uint32_t imageSize{ rowSize * height };
+			constexpr uint32_t headerSize{ 14 + 40 };
+
+			// BITMAPFILEHEADER
+			output.push_back('B');
+			output.push_back('M');
+			AppendLittleEndian(output, headerSize + imageSize, 4);
+			AppendLittleEndian(output, 0, 4);
+			AppendLittleEndian(output, headerSize, 4);
+
+			// BITMAPINFOHEADER
+			AppendLittleEndian(output, 40, 4);
+			AppendLittleEndian(output, width, 4);
+			AppendLittleEndian(output, height, 4);
+			AppendLittleEndian(output, 1, 2);   // planes
+			AppendLittleEndian(output, 24, 2);  // bits per pixel
+			AppendLittleEndian(output, 0, 4);   // BI_RGB
+			AppendLittleEndian(output, imageSize, 4);
+			AppendLittleEndian(output, 2835, 4);  // 72 DPI
+			AppendLittleEndian(output, 2835, 4);
+			AppendLittleEndian(output, 0, 4);
+			AppendLittleEndian(output, 0, 4);
+
+			const size_t start{ output.size() };
+			output.resize(start + imageSize, 0);
+			for (uint32_t y{}; y < height; ++y)
+			{
+				const uint32_t* pRow{ pPixels + size_t(height - 1 - y) * width };
+				uint8_t* pOutput{ output.data() + start + size_t(y) * rowSize };
+				for (uint32_t x{}; x < width; ++x, pOutput += 3)
+				{
+					const RGB color{ ToRGB(pRow[x], layout) };
+					pOutput[0] = color.b;
+					pOutput[1] = color.g;
+					pOutput[2] = color.r;
+				}
+			}
+		}
+
+		// https://qoiformat.org/qoi-specification.pdf, 3 channels, sRGB
+		void EncodeQOI(const uint32_t* pPixels, uint32_t width, uint32_t height, const FrameWriter::PixelLayout& layout, std::vector<uint8_t>& output)
+		{
+			constexpr uint8_t OpIndex{ 0x00 };
+			constexpr uint8_t OpDiff{ 0x40 };
+			constexpr uint8_t OpLuma{ 0x80 };
+			constexpr uint8_t OpRun{ 0xc0 };
+			constexpr uint8_t OpRGB{ 0xfe };
+
+			Append(output, "qoif", 4);
+			AppendBigEndian(output, width);
+			AppendBigEndian(output, height);
+			output.push_back(3);  // channels
+			output.push_back(0);  // sRGB
+
+			// Worst case every pixel is an OpRGB, writing through a pointer is a lot faster than push_back
+			const size_t start{ output.size() };
+			output.resize(start + size_t(width) * height * 4 + 8);
+			uint8_t* pOutput{ output.data() + start };
+
+			// Packed RGBA, the alpha of 0 keeps the unused slots from matching anything
+			uint32_t seen[64]{};
+			RGB previous{ 0, 0, 0 };
+			uint8_t run{};
+			const size_t pixelCount{ size_t(width) * height };
+			for (size_t i{}; i < pixelCount; ++i)
+			{
+				const RGB color{ ToRGB(pPixels[i], layout) };
+				const bool isSame{ color.r == previous.r && color.g == previous.g && color.b == previous.b };
+				if (isSame)
+				{
+					++run;
+					if (run == 62 || i + 1 == pixelCount)
+					{
+						*pOutput++ = OpRun | (run - 1);
+						run = 0;
+					}
+					continue;
+				}
+
+				if (run > 0)
+				{
+					*pOutput++ = OpRun | (run - 1);
+					run = 0;
+				}
+
+				// Alpha is always 255
+				const uint8_t hash{ static_cast<uint8_t>((color.r * 3 + color.g * 5 + color.b * 7 + 255 * 11) % 64) };
+				const uint32_t packed{ uint32_t(color.r) << 24 | uint32_t(color.g) << 16 | uint32_t(color.b) << 8 | 255u };
+				if (seen[hash] == packed)
+				{
+					*pOutput++ = OpIndex | hash;
+				}
+				else
+				{
+					seen[hash] = packed;
+
+					const int8_t differenceR{ static_cast<int8_t>(color.r - previous.r) };
+					const int8_t differenceG{ static_cast<int8_t>(color.g - previous.g) };
+					const int8_t differenceB{ static_cast<int8_t>(color.b - previous.b) };
+					const int8_t differenceRG{ static_cast<int8_t>(differenceR - differenceG) };
+					const int8_t differenceBG{ static_cast<int8_t>(differenceB - differenceG) };
+
+					if (differenceR >= -2 && differenceR <= 1 && differenceG >= -2 && differenceG <= 1 && differenceB >= -2 && differenceB <= 1)
+					{
+						*pOutput++ = static_cast<uint8_t>(OpDiff | (differenceR + 2) << 4 | (differenceG + 2) << 2 | (differenceB + 2));
+					}
+					else if (differenceG >= -32 && differenceG <= 31 && differenceRG >= -8 && differenceRG <= 7 && differenceBG >= -8 && differenceBG <= 7)
+					{
+						*pOutput++ = static_cast<uint8_t>(OpLuma | (differenceG + 32));
+						*pOutput++ = static_cast<uint8_t>((differenceRG + 8) << 4 | (differenceBG + 8));
+					}
+					else
+					{
+						*pOutput++ = OpRGB;
+						*pOutput++ = color.r;
+						*pOutput++ = color.g;
+						*pOutput++ = color.b;
+					}
+				}
+				previous = color;
+			}
+
+			// End marker
+			constexpr uint8_t padding[8]{ 0, 0, 0, 0, 0, 0, 0, 1 };
+			std::memcpy(pOutput, padding, sizeof(padding));
+			pOutput += sizeof(padding);
+			output.resize(pOutput - output.data());
+		}
+	}
+
+	FrameWriter::FrameWriter(uint32_t width, uint32_t height, const PixelLayout& layout, uint32_t bufferCount) :
+		m_Width{ width },
+		m_Height{ height },
+		m_Layout{ layout },
+		m_Frames(bufferCount),
+		m_Queue(bufferCount)
+	{
+		assert(bufferCount > 0 && "FrameWriter needs at least one buffer");
+
+		// Everything Submit touches is allocated here, so submitting a frame doesn't allocate
+		m_FreeFrames.reserve(bufferCount);
+		for (uint32_t i{}; i < bufferCount; ++i)
+		{
+			m_Frames[i].pixels.resize(size_t(width) * height);
+			m_FreeFrames.push_back(bufferCount - 1 - i);
+		}
+
+		m_Thread = std::thread{ &FrameWriter::Run, this };
+	}
+
+	FrameWriter::~FrameWriter()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_FrameQueued.notify_all();
+		m_Thread.join();
+	}
+
+	bool FrameWriter::Submit(const uint32_t* pPixels, ImageFormat format, const char* pFilename, bool waitWhenFull)
+	{
+		std::unique_lock lock{ m_Mutex };
+		if (m_FreeFrames.empty())
+		{
+			if (!waitWhenFull)
+			{
+				++m_DroppedCount;
+				return false;
+			}
+
+			const auto waitStart{ std::chrono::steady_clock::now() };
+			m_FrameFreed.wait(lock, [this] { return !m_FreeFrames.empty(); });
+			m_WaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+		}
+
+		const uint32_t frameIndex{ m_FreeFrames.back() };
+		m_FreeFrames.pop_back();
+		lock.unlock();
+
+		// The copy happens outside of the lock, the writer thread doesn't touch frames that aren't queued
+		Frame& frame{ m_Frames[frameIndex] };
+		std::memcpy(frame.pixels.data(), pPixels, frame.pixels.size() * sizeof(uint32_t));
+		frame.format = format;
+		std::snprintf(frame.filename, MaxFilenameLength, "%s", pFilename);
+
+		lock.lock();
+		m_Queue[(m_QueueStart + m_QueueSize) % m_Queue.size()] = frameIndex;
+		++m_QueueSize;
+		lock.unlock();
+
+		m_FrameQueued.notify_one();
+		return true;
+	}
+
+	void FrameWriter::Flush()
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_FrameFreed.wait(lock, [this] { return m_FreeFrames.size() == m_Frames.size(); });
+	}
+
+	uint64_t FrameWriter::GetWrittenCount() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return m_WrittenCount;
+	}
+
+	uint64_t FrameWriter::GetDroppedCount() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return m_DroppedCount;
+	}
+
+	uint64_t FrameWriter::GetFailedCount() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return m_FailedCount;
+	}
+
+	float FrameWriter::GetWaitSeconds() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return static_cast<float>(m_WaitSeconds);
+	}
+
+	const char* FrameWriter::GetExtension(ImageFormat format)
+	{
+		switch (format)
+		{
+		case ImageFormat::PPM: return ".ppm";
+		case ImageFormat::BMP: return ".bmp";
+		case ImageFormat::QOI: return ".qoi";
+		default: return "";
+		}
+	}
+
+	bool FrameWriter::GetFormat(const std::string& filename, ImageFormat& format)
+	{
+		const size_t extensionStart{ filename.rfind('.') };
+		const std::string extension{ extensionStart != std::string::npos ? filename.substr(extensionStart) : "" };
+		for (ImageFormat candidate : { ImageFormat::PPM, ImageFormat::BMP, ImageFormat::QOI })
+		{
+			if (extension == GetExtension(candidate))
+			{
+				format = candidate;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void FrameWriter::MakeTimestampedName(char* pBuffer, size_t bufferSize, const char* pPrefix, const char* pSuffix)
+	{
+		const auto now{ std::chrono::system_clock::now() };
+		const std::time_t time{ std::chrono::system_clock::to_time_t(now) };
+		const int milliseconds{ static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000) };
+
+		std::tm localTime{};
+#if defined(_WIN32)
+		localtime_s(&localTime, &time);
+#else
+		localtime_r(&time, &localTime);
+#endif
+
+		std::snprintf(pBuffer, bufferSize, "%s_%04d%02d%02d_%02d%02d%02d_%03d%s", pPrefix,
+			localTime.tm_year + 1900, localTime.tm_mon + 1, localTime.tm_mday,
+			localTime.tm_hour, localTime.tm_min, localTime.tm_sec, milliseconds, pSuffix);
+	}
+
+	void FrameWriter::Run()
+	{
+		// Reused for every frame, only grows the first few times
+		std::vector<uint8_t> encoded{};
+		encoded.reserve(size_t(m_Width) * m_Height * 4 + 64);
+
+		std::unique_lock lock{ m_Mutex };
+		while (true)
+		{
+			m_FrameQueued.wait(lock, [this] { return m_QueueSize > 0 || m_IsStopping; });
+			if (m_QueueSize == 0)
+				return;  // stopping, and everything is written
+
+			const uint32_t frameIndex{ m_Queue[m_QueueStart] };
+			m_QueueStart = (m_QueueStart + 1) % m_Queue.size();
+			--m_QueueSize;
+			lock.unlock();
+
+			const bool isWritten{ WriteFrame(m_Frames[frameIndex], encoded) };
+
+			lock.lock();
+			++(isWritten ? m_WrittenCount : m_FailedCount);
+			m_FreeFrames.push_back(frameIndex);
+			m_FrameFreed.notify_all();
+		}
+	}
+
+	void FrameWriter::Encode(const uint32_t* pPixels, uint32_t width, uint32_t height, const PixelLayout& layout, ImageFormat format, std::vector<uint8_t>& output)
+	{
+		output.clear();
+		switch (format)
+		{
+		case ImageFormat::PPM:
+			EncodePPM(pPixels, width, height, layout, output);
+			break;
+		case ImageFormat::BMP:
+			EncodeBMP(pPixels, width, height, layout, output);
+			break;
+		case ImageFormat::QOI:
+			EncodeQOI(pPixels, width, height, layout, output);
+			break;
+		}
+	}
+
+	bool FrameWriter::WriteFrame(const Frame& frame, std::vector<uint8_t>& encoded) const
+	{
+		Encode(frame.pixels.data(), m_Width, m_Height, m_Layout, frame.format, encoded);
+
+		std::ofstream file{ frame.filename, std::ios::binary };
+		file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+		return file.good();
+	}
+}
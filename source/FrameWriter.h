@@ -0,0 +1,100 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	enum class ImageFormat
+	{
+		PPM,  // binary P6, no compression
+		BMP,  // 24 bit, no compression
+		QOI   // "Quite OK Image" lossless, close to PNG sizes at a fraction of the encode time
+	};
+
+	// Writes frames to disk on a background thread. Submit only copies the pixels into one of a fixed amount of
+	// preallocated buffers, the encoding & file IO happen on the writer thread.
+	// When all buffers are in use the queue is full: Submit either waits for a buffer (backpressure) or drops the frame
+	class FrameWriter final
+	{
+	public:
+		static constexpr size_t MaxFilenameLength{ 256 };
+
+		// Where the 8 bit channels are in a pixel (SDL surface format shifts)
+		struct PixelLayout
+		{
+			uint32_t redShift{ 16 };
+			uint32_t greenShift{ 8 };
+			uint32_t blueShift{ 0 };
+			uint32_t alphaMask{ 0 };  // bits that are set on every pixel (opaque alpha), 0 without an alpha channel
+		};
+
+		FrameWriter(uint32_t width, uint32_t height, const PixelLayout& layout, uint32_t bufferCount = 4);
+		// Writes everything that's still queued
+		~FrameWriter();
+
+		FrameWriter(const FrameWriter&) = delete;
+		FrameWriter(FrameWriter&&) noexcept = delete;
+		FrameWriter& operator=(const FrameWriter&) = delete;
+		FrameWriter& operator=(FrameWriter&&) noexcept = delete;
+
+		/**
+		 * \brief Queues a copy of the pixels (width * height), doesn't allocate
+		 * \param waitWhenFull wait for a free buffer instead of dropping the frame when the queue is full
+		 * \return false when the frame got dropped
+		 */
+		bool Submit(const uint32_t* pPixels, ImageFormat format, const char* pFilename, bool waitWhenFull = true);
+		// Blocks until every queued frame is written
+		void Flush();
+
+		uint64_t GetWrittenCount() const;
+		uint64_t GetDroppedCount() const;
+		uint64_t GetFailedCount() const;
+		// Total time Submit spent waiting for a free buffer
+		float GetWaitSeconds() const;
+
+		static const char* GetExtension(ImageFormat format);
+		// The format that goes with the filename's extension, false when it's none of them
+		static bool GetFormat(const std::string& filename, ImageFormat& format);
+		// Encodes on the calling thread, output gets cleared first (keeps its capacity)
+		static void Encode(const uint32_t* pPixels, uint32_t width, uint32_t height, const PixelLayout& layout, ImageFormat format, std::vector<uint8_t>& output);
+
+		// "<prefix>_YYYYMMDD_HHMMSS_mmm<suffix>", formatted into the buffer so it doesn't allocate
+		static void MakeTimestampedName(char* pBuffer, size_t bufferSize, const char* pPrefix, const char* pSuffix);
+
+	private:
+		struct Frame
+		{
+			std::vector<uint32_t> pixels{};
+			ImageFormat format{};
+			char filename[MaxFilenameLength]{};
+		};
+
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		PixelLayout m_Layout{};
+
+		std::vector<Frame> m_Frames{};
+		std::vector<uint32_t> m_FreeFrames{};  // stack of frame indices
+		std::vector<uint32_t> m_Queue{};       // ring of frame indices, in submit order
+		size_t m_QueueStart{};
+		size_t m_QueueSize{};
+
+		uint64_t m_WrittenCount{};
+		uint64_t m_DroppedCount{};
+		uint64_t m_FailedCount{};
+		double m_WaitSeconds{};
+		bool m_IsStopping{};
+
+		mutable std::mutex m_Mutex{};
+		std::condition_variable m_FrameQueued{};
+		std::condition_variable m_FrameFreed{};
+		std::thread m_Thread{};
+
+		void Run();
+		bool WriteFrame(const Frame& frame, std::vector<uint8_t>& encoded) const;
+	};
+}
@@ -0,0 +1,697 @@
+#include "GLBParser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "DataTypes.h"
+#include "MappedFile.h"
+#include "MeshUtils.h"
+
+namespace dae
+{
+	namespace GLBParser
+	{
+		namespace
+		{
+			constexpr uint32_t Magic{ 0x46546C67 };      // "glTF"
+			constexpr uint32_t JsonChunkType{ 0x4E4F534A };  // "JSON"
+			constexpr uint32_t BinChunkType{ 0x004E4942 };   // "BIN\0"
+			constexpr int MaxNodeDepth{ 64 };
+
+			enum ComponentType
+			{
+				UnsignedByte = 5121,
+				UnsignedShort = 5123,
+				UnsignedInt = 5125,
+				Float = 5126
+			};
+
+			static_assert(sizeof(Vector3) == 3 * sizeof(float), "Accessor data gets copied straight into Vector3 arrays");
+
+			// Just enough JSON for the glTF chunk, which is small next to the binary data
+			struct JsonValue
+			{
+				enum class Type : uint8_t
+				{
+					Null, Boolean, Number, String, Array, Object
+				};
+
+				Type type{ Type::Null };
+				double number{};
+				std::string string{};
+				std::vector<JsonValue> values{};  // array items, or the values of an object's members
+				std::vector<std::string> keys{};  // object member names, same order as values
+
+				const JsonValue* Find(const char* pKey) const
+				{
+					for (size_t i{}; i < keys.size(); ++i)
+					{
+						if (keys[i] == pKey)
+							return &values[i];
+					}
+					return nullptr;
+				}
+
+				const JsonValue* At(size_t index) const
+				{
+					return type == Type::Array && index < values.size() ? &values[index] : nullptr;
+				}
+
+				double GetNumber(const char* pKey, double defaultValue) const
+				{
+					const JsonValue* pValue{ Find(pKey) };
+					return pValue != nullptr && pValue->type == Type::Number ? pValue->number : defaultValue;
+				}
+
+				// -1 when missing, for the indices glTF uses to refer to other objects
+				int GetIndex(const char* pKey) const
+				{
+					const double index{ GetNumber(pKey, -1.0) };
+					return index >= 0.0 ? static_cast<int>(index) : -1;
+				}
+			};
+
+			class JsonReader final
+			{
+			public:
+				// The text has to be null terminated (strtod)
+				explicit JsonReader(const std::string& text) :
+					m_pCurrent{ text.c_str() },
+					m_pEnd{ text.c_str() + text.size() }
+				{
+				}
+
+				bool Parse(JsonValue& value, int depth = 0)
+				{
+					SkipWhitespace();
+					if (m_pCurrent >= m_pEnd || depth > 128)
+						return false;
+
+					switch (*m_pCurrent)
+					{
+					case '{':
+						value.type = JsonValue::Type::Object;
+						++m_pCurrent;
+						if (Consume('}'))
+							return true;
+						do
+						{
+							value.keys.emplace_back();
+							value.values.emplace_back();
+							SkipWhitespace();
+							if (!ParseString(value.keys.back()) || !Consume(':') || !Parse(value.values.back(), depth + 1))
+								return false;
+						} while (Consume(','));
+						return Consume('}');
+					case '[':
+						value.type = JsonValue::Type::Array;
+						++m_pCurrent;
+						if (Consume(']'))
+							return true;
+						do
+						{
+							value.values.emplace_back();
+							if (!Parse(value.values.back(), depth + 1))
+								return false;
+						} while (Consume(','));
+						return Consume(']');
+					case '"':
+						value.type = JsonValue::Type::String;
+						return ParseString(value.string);
+					case 't':
+						value.type = JsonValue::Type::Boolean;
+						value.number = 1.0;
+						return ConsumeWord("true");
+					case 'f':
+						value.type = JsonValue::Type::Boolean;
+						return ConsumeWord("false");
+					case 'n':
+						return ConsumeWord("null");
+					default:
+					{
+						char* pNumberEnd{};
+						value.type = JsonValue::Type::Number;
+						value.number = std::strtod(m_pCurrent, &pNumberEnd);
+						if (pNumberEnd == m_pCurrent)
+							return false;
+						m_pCurrent = pNumberEnd;
+						return true;
+					}
+					}
+				}
+
+			private:
+				const char* m_pCurrent{};
+				const char* m_pEnd{};
+
+				void SkipWhitespace()
+				{
+					while (m_pCurrent < m_pEnd && (*m_pCurrent == ' ' || *m_pCurrent == '\t' || *m_pCurrent == '\n' || *m_pCurrent == '\r'))
+						++m_pCurrent;
+				}
+
+				bool Consume(char character)
+				{
+					SkipWhitespace();
+					if (m_pCurrent >= m_pEnd || *m_pCurrent != character)
+						return false;
+					++m_pCurrent;
+					return true;
+				}
+
+				bool ConsumeWord(const char* pWord)
+				{
+					const size_t length{ std::strlen(pWord) };
+					if (size_t(m_pEnd - m_pCurrent) < length || std::strncmp(m_pCurrent, pWord, length) != 0)
+						return false;
+					m_pCurrent += length;
+					return true;
+				}
+
+				bool ParseString(std::string& string)
+				{
+					if (m_pCurrent >= m_pEnd || *m_pCurrent != '"')
+						return false;
+					++m_pCurrent;
+
+					while (m_pCurrent < m_pEnd && *m_pCurrent != '"')
+					{
+						if (*m_pCurrent != '\\')
+						{
+							string += *m_pCurrent++;
+							continue;
+						}
+
+						if (++m_pCurrent >= m_pEnd)
+							return false;
+						switch (const char escaped{ *m_pCurrent++ })
+						{
+						case 'b': string += '\b'; break;
+						case 'f': string += '\f'; break;
+						case 'n': string += '\n'; break;
+						case 'r': string += '\r'; break;
+						case 't': string += '\t'; break;
+						case 'u':
+						{
+							// Names only, a code point of the basic plane to UTF-8 is plenty
+							if (m_pEnd - m_pCurrent < 4)
+								return false;
+							const std::string hex{ m_pCurrent, 4 };
+							const uint32_t codePoint{ static_cast<uint32_t>(std::strtoul(hex.c_str(), nullptr, 16)) };
+							m_pCurrent += 4;
+							if (codePoint < 0x80)
+								string += static_cast<char>(codePoint);
+							else if (codePoint < 0x800)
+							{
+								string += static_cast<char>(0xC0 | codePoint >> 6);
+								string += static_cast<char>(0x80 | (codePoint & 0x3F));
+							}
+							else
+							{
+								string += static_cast<char>(0xE0 | codePoint >> 12);
+								string += static_cast<char>(0x80 | (codePoint >> 6 & 0x3F));
+								string += static_cast<char>(0x80 | (codePoint & 0x3F));
+							}
+							break;
+						}
+						default: string += escaped; break;
+						}
+					}
+					return Consume('"');
+				}
+			};
+
+			// Affine node transform, glTF's column vector convention: p' = M * p
+			struct Transform
+			{
+				float m[3][4]{ { 1.f, 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f, 0.f }, { 0.f, 0.f, 1.f, 0.f } };
+
+				static Transform FromNode(const JsonValue& node)
+				{
+					Transform transform{};
+					const auto readFloats{ [&node](const char* pKey, float* pValues, size_t count)
+						{
+							const JsonValue* pArray{ node.Find(pKey) };
+							if (pArray == nullptr || pArray->type != JsonValue::Type::Array || pArray->values.size() != count)
+								return false;
+							for (size_t i{}; i < count; ++i)
+								pValues[i] = static_cast<float>(pArray->values[i].number);
+							return true;
+						} };
+
+					// Either a column major matrix, or translation, rotation (quaternion) & scale: T * R * S
+					float matrix[16]{};
+					if (readFloats("matrix", matrix, 16))
+					{
+						for (int row{}; row < 3; ++row)
+						{
+							for (int column{}; column < 4; ++column)
+								transform.m[row][column] = matrix[column * 4 + row];
+						}
+						return transform;
+					}
+
+					float translation[3]{};
+					float rotation[4]{ 0.f, 0.f, 0.f, 1.f };
+					float scale[3]{ 1.f, 1.f, 1.f };
+					readFloats("translation", translation, 3);
+					readFloats("rotation", rotation, 4);
+					readFloats("scale", scale, 3);
+
+					const float x{ rotation[0] }, y{ rotation[1] }, z{ rotation[2] }, w{ rotation[3] };
+					const float rotationMatrix[3][3]{
+						{ 1.f - 2.f * (y * y + z * z), 2.f * (x * y - z * w), 2.f * (x * z + y * w) },
+						{ 2.f * (x * y + z * w), 1.f - 2.f * (x * x + z * z), 2.f * (y * z - x * w) },
+						{ 2.f * (x * z - y * w), 2.f * (y * z + x * w), 1.f - 2.f * (x * x + y * y) } };
+					for (int row{}; row < 3; ++row)
+					{
+						for (int column{}; column < 3; ++column)
+							transform.m[row][column] = rotationMatrix[row][column] * scale[column];
+						transform.m[row][3] = translation[row];
+					}
+					return transform;
+				}
+
+				Transform operator*(const Transform& other) const
+				{
+					Transform result{};
+					for (int row{}; row < 3; ++row)
+					{
+						for (int column{}; column < 4; ++column)
+						{
+							result.m[row][column] = m[row][0] * other.m[0][column] + m[row][1] * other.m[1][column] + m[row][2] * other.m[2][column]
+								+ (column == 3 ? m[row][3] : 0.f);
+						}
+					}
+					return result;
+				}
+
+				bool IsIdentity() const
+				{
+					const Transform identity{};
+					return std::memcmp(m, identity.m, sizeof(m)) == 0;
+				}
+
+				float GetDeterminant() const
+				{
+					return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+						- m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+						+ m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+				}
+
+				Vector3 TransformPoint(const Vector3& p) const
+				{
+					return {
+						m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+						m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+						m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3] };
+				}
+
+				// Cofactor matrix (inverse transpose up to a scale), only the direction is used
+				Vector3 TransformNormal(const Vector3& n) const
+				{
+					const float c[3][3]{
+						{ m[1][1] * m[2][2] - m[1][2] * m[2][1], m[1][2] * m[2][0] - m[1][0] * m[2][2], m[1][0] * m[2][1] - m[1][1] * m[2][0] },
+						{ m[0][2] * m[2][1] - m[0][1] * m[2][2], m[0][0] * m[2][2] - m[0][2] * m[2][0], m[0][1] * m[2][0] - m[0][0] * m[2][1] },
+						{ m[0][1] * m[1][2] - m[0][2] * m[1][1], m[0][2] * m[1][0] - m[0][0] * m[1][2], m[0][0] * m[1][1] - m[0][1] * m[1][0] } };
+					const float sign{ GetDeterminant() < 0.f ? -1.f : 1.f };
+					return Vector3{
+						c[0][0] * n.x + c[0][1] * n.y + c[0][2] * n.z,
+						c[1][0] * n.x + c[1][1] * n.y + c[1][2] * n.z,
+						c[2][0] * n.x + c[2][1] * n.y + c[2][2] * n.z } * sign;
+				}
+			};
+
+			// Where an accessor's elements are in the BIN chunk
+			struct Accessor
+			{
+				const char* pData{};
+				size_t count{};
+				size_t stride{};
+				int componentType{};
+				size_t componentCount{};
+			};
+
+			class Document final
+			{
+			public:
+				Document(const JsonValue& root, const char* pBin, size_t binSize) :
+					m_Root{ root },
+					m_pBin{ pBin },
+					m_BinSize{ binSize }
+				{
+				}
+
+				const JsonValue* Get(const char* pArray, int index) const
+				{
+					const JsonValue* pValues{ m_Root.Find(pArray) };
+					return pValues != nullptr && index >= 0 ? pValues->At(index) : nullptr;
+				}
+
+				bool GetAccessor(int accessorIndex, Accessor& accessor) const
+				{
+					const JsonValue* pAccessor{ Get("accessors", accessorIndex) };
+					if (pAccessor == nullptr || pAccessor->Find("sparse") != nullptr)
+						return false;
+
+					const JsonValue* pView{ Get("bufferViews", pAccessor->GetIndex("bufferView")) };
+					const JsonValue* pType{ pAccessor->Find("type") };
+					if (pView == nullptr || pType == nullptr)
+						return false;
+
+					// Only the GLB's own buffer: the first one, without an uri
+					const JsonValue* pBuffer{ Get("buffers", pView->GetIndex("buffer")) };
+					if (pView->GetIndex("buffer") != 0 || pBuffer == nullptr || pBuffer->Find("uri") != nullptr)
+						return false;
+
+					const std::string& type{ pType->string };
+					accessor.componentCount = type == "SCALAR" ? 1 : type == "VEC2" ? 2 : type == "VEC3" ? 3 : type == "VEC4" ? 4 : 0;
+					accessor.componentType = pAccessor->GetIndex("componentType");
+					accessor.count = static_cast<size_t>(pAccessor->GetNumber("count", 0.0));
+
+					size_t componentSize{};
+					switch (accessor.componentType)
+					{
+					case UnsignedByte: componentSize = 1; break;
+					case UnsignedShort: componentSize = 2; break;
+					case UnsignedInt:
+					case Float: componentSize = 4; break;
+					default: return false;
+					}
+
+					const size_t elementSize{ componentSize * accessor.componentCount };
+					const size_t viewOffset{ static_cast<size_t>(pView->GetNumber("byteOffset", 0.0)) };
+					const size_t viewLength{ static_cast<size_t>(pView->GetNumber("byteLength", 0.0)) };
+					const size_t offset{ static_cast<size_t>(pAccessor->GetNumber("byteOffset", 0.0)) };
+					accessor.stride = static_cast<size_t>(pView->GetNumber("byteStride", 0.0));
+					if (accessor.stride == 0)
+						accessor.stride = elementSize;
+
+					if (elementSize == 0 || viewOffset + viewLength > m_BinSize
+						|| (accessor.count > 0 && offset + (accessor.count - 1) * accessor.stride + elementSize > viewLength))
+						return false;
+
+					accessor.pData = m_pBin + viewOffset + offset;
+					return true;
+				}
+
+				bool AddNode(int nodeIndex, const Transform& parentTransform, GLBData& data, ParseStats& stats, int depth) const
+				{
+					const JsonValue* pNode{ Get("nodes", nodeIndex) };
+					if (pNode == nullptr || depth > MaxNodeDepth)
+						return false;
+
+					const Transform transform{ parentTransform * Transform::FromNode(*pNode) };
+					if (const JsonValue* pMesh{ Get("meshes", pNode->GetIndex("mesh")) })
+					{
+						const JsonValue* pPrimitives{ pMesh->Find("primitives") };
+						for (size_t i{}; pPrimitives != nullptr && i < pPrimitives->values.size(); ++i)
+						{
+							if (!AddPrimitive(pPrimitives->values[i], transform, data))
+								return false;
+							++stats.primitiveCount;
+						}
+					}
+
+					if (const JsonValue* pChildren{ pNode->Find("children") })
+					{
+						for (const JsonValue& child : pChildren->values)
+						{
+							if (!AddNode(static_cast<int>(child.number), transform, data, stats, depth + 1))
+								return false;
+						}
+					}
+					return true;
+				}
+
+			private:
+				const JsonValue& m_Root;
+				const char* m_pBin{};
+				size_t m_BinSize{};
+
+				// Copies VEC3 floats into the end of the array, one memcpy when they're tightly packed
+				static void CopyVectors(const Accessor& accessor, std::vector<Vector3>& vectors)
+				{
+					const size_t first{ vectors.size() };
+					vectors.resize(first + accessor.count);
+					if (accessor.stride == sizeof(Vector3))
+					{
+						std::memcpy(&vectors[first], accessor.pData, accessor.count * sizeof(Vector3));
+						return;
+					}
+					for (size_t i{}; i < accessor.count; ++i)
+						std::memcpy(&vectors[first + i], accessor.pData + i * accessor.stride, sizeof(Vector3));
+				}
+
+				bool AddPrimitive(const JsonValue& primitive, const Transform& transform, GLBData& data) const
+				{
+					// Triangle lists only (points, lines & strips are skipped)
+					if (primitive.GetNumber("mode", 4.0) != 4.0)
+						return true;
+
+					const JsonValue* pAttributes{ primitive.Find("attributes") };
+					Accessor positions{};
+					if (pAttributes == nullptr || !GetAccessor(pAttributes->GetIndex("POSITION"), positions)
+						|| positions.componentType != Float || positions.componentCount != 3)
+						return false;
+
+					const size_t firstVertex{ data.positions.size() };
+					const size_t firstIndex{ data.indices.size() };
+					const bool isIdentity{ transform.IsIdentity() };
+					CopyVectors(positions, data.positions);
+					for (size_t i{ firstVertex }; i < data.positions.size(); ++i)
+					{
+						Vector3& position{ data.positions[i] };
+						if (!isIdentity)
+							position = transform.TransformPoint(position);
+						position.z = -position.z;
+					}
+
+					// Zero normals never flip a triangle, for primitives without normals next to ones with
+					Accessor normals{};
+					if (GetAccessor(pAttributes->GetIndex("NORMAL"), normals) && normals.componentType == Float && normals.componentCount == 3
+						&& normals.count == positions.count)
+					{
+						data.normals.resize(firstVertex);
+						CopyVectors(normals, data.normals);
+						for (size_t i{ firstVertex }; i < data.normals.size(); ++i)
+						{
+							Vector3& normal{ data.normals[i] };
+							if (!isIdentity)
+								normal = transform.TransformNormal(normal);
+							normal.z = -normal.z;
+						}
+					}
+
+					Accessor indices{};
+					const int indicesIndex{ primitive.GetIndex("indices") };
+					if (indicesIndex < 0)
+					{
+						// Not indexed: every 3 vertices are a triangle
+						data.indices.resize(firstIndex + positions.count / 3 * 3);
+						for (size_t i{ firstIndex }; i < data.indices.size(); ++i)
+							data.indices[i] = static_cast<int>(firstVertex + i - firstIndex);
+					}
+					else
+					{
+						if (!GetAccessor(indicesIndex, indices) || indices.componentCount != 1)
+							return false;
+
+						data.indices.resize(firstIndex + indices.count / 3 * 3);
+						const size_t indexCount{ data.indices.size() - firstIndex };
+						if (indices.componentType == UnsignedInt && indices.stride == sizeof(int))
+							std::memcpy(&data.indices[firstIndex], indices.pData, indexCount * sizeof(int));
+						else
+						{
+							for (size_t i{}; i < indexCount; ++i)
+							{
+								const char* pIndex{ indices.pData + i * indices.stride };
+								uint32_t index{};
+								if (indices.componentType == UnsignedByte)
+									index = static_cast<uint8_t>(*pIndex);
+								else if (indices.componentType == UnsignedShort)
+								{
+									uint16_t shortIndex{};
+									std::memcpy(&shortIndex, pIndex, sizeof(shortIndex));
+									index = shortIndex;
+								}
+								else
+									std::memcpy(&index, pIndex, sizeof(index));
+								data.indices[firstIndex + i] = static_cast<int>(index);
+							}
+						}
+
+						for (size_t i{ firstIndex }; i < data.indices.size(); ++i)
+						{
+							if (static_cast<uint32_t>(data.indices[i]) >= positions.count)
+								return false;
+							data.indices[i] += static_cast<int>(firstVertex);
+						}
+					}
+
+					// Mirroring z turns the winding around, which the face normals are calculated from.
+					// A mirroring node transform does the same, the two cancel out
+					if (transform.GetDeterminant() >= 0.f)
+					{
+						for (size_t i{ firstIndex }; i < data.indices.size(); i += 3)
+							std::swap(data.indices[i + 1], data.indices[i + 2]);
+					}
+
+					const int materialIndex{ primitive.GetIndex("material") };
+					const size_t materialCount{ data.materials.size() };
+					const size_t slot{ materialIndex >= 0 && size_t(materialIndex) < materialCount ? size_t(materialIndex) : materialCount };
+					data.triangleMaterials.resize(data.indices.size() / 3, static_cast<unsigned char>(slot));
+					return true;
+				}
+			};
+
+			GLBMaterial ReadMaterial(const JsonValue& material)
+			{
+				GLBMaterial result{};
+				if (const JsonValue* pName{ material.Find("name") })
+					result.name = pName->string;
+
+				const JsonValue* pPbr{ material.Find("pbrMetallicRoughness") };
+				if (pPbr == nullptr)
+					return result;
+
+				if (const JsonValue* pColor{ pPbr->Find("baseColorFactor") }; pColor != nullptr && pColor->values.size() >= 3)
+				{
+					result.baseColor = ColorRGB{ static_cast<float>(pColor->values[0].number),
+						static_cast<float>(pColor->values[1].number), static_cast<float>(pColor->values[2].number) };
+				}
+				result.metalness = static_cast<float>(pPbr->GetNumber("metallicFactor", 1.0));
+				result.roughness = static_cast<float>(pPbr->GetNumber("roughnessFactor", 1.0));
+				return result;
+			}
+		}
+
+		bool Parse(const std::string& filename, GLBData& data, ParseStats* pStats)
+		{
+			const auto startTime{ std::chrono::steady_clock::now() };
+
+			const MappedFile file{ filename };
+			if (!file.IsOpen() || file.GetSize() < 20)
+				return false;
+
+			const char* pFile{ file.GetData() };
+			const auto readUInt{ [pFile](size_t offset)
+				{
+					uint32_t value{};
+					std::memcpy(&value, pFile + offset, sizeof(value));
+					return value;
+				} };
+
+			// Header: magic, version, length. Then the JSON chunk & an optional BIN chunk, each length + type + data
+			const size_t length{ std::min<size_t>(readUInt(8), file.GetSize()) };
+			if (readUInt(0) != Magic || readUInt(4) != 2)
+			{
+				std::cout << filename << " isn't a glTF 2.0 binary\n";
+				return false;
+			}
+
+			const size_t jsonLength{ readUInt(12) };
+			if (readUInt(16) != JsonChunkType || 20 + jsonLength > length)
+				return false;
+
+			const char* pBin{};
+			size_t binLength{};
+			const size_t binChunk{ 20 + ((jsonLength + 3) & ~size_t{ 3 }) };
+			if (binChunk + 8 <= length && readUInt(binChunk + 4) == BinChunkType)
+			{
+				binLength = std::min<size_t>(readUInt(binChunk), length - binChunk - 8);
+				pBin = pFile + binChunk + 8;
+			}
+
+			JsonValue root{};
+			const std::string json{ pFile + 20, jsonLength };
+			JsonReader reader{ json };
+			if (!reader.Parse(root) || root.type != JsonValue::Type::Object)
+			{
+				std::cout << filename << ": invalid JSON chunk\n";
+				return false;
+			}
+
+			if (const JsonValue* pMaterials{ root.Find("materials") })
+			{
+				// Triangle materials are a byte, with the slot after the last material for primitives without one
+				if (pMaterials->values.size() > 255)
+				{
+					std::cout << filename << ": " << pMaterials->values.size() << " materials, at most 255 are supported\n";
+					return false;
+				}
+				for (const JsonValue& material : pMaterials->values)
+					data.materials.push_back(ReadMaterial(material));
+			}
+
+			// The default scene's root nodes, or every node that isn't a child when there are no scenes
+			std::vector<int> rootNodes{};
+			const Document document{ root, pBin, binLength };
+			if (const JsonValue* pScene{ document.Get("scenes", std::max(root.GetIndex("scene"), 0)) })
+			{
+				if (const JsonValue* pNodes{ pScene->Find("nodes") })
+				{
+					for (const JsonValue& node : pNodes->values)
+						rootNodes.push_back(static_cast<int>(node.number));
+				}
+			}
+			else if (const JsonValue* pNodes{ root.Find("nodes") })
+			{
+				std::vector<bool> isChild(pNodes->values.size());
+				for (const JsonValue& node : pNodes->values)
+				{
+					if (const JsonValue* pChildren{ node.Find("children") })
+					{
+						for (const JsonValue& child : pChildren->values)
+						{
+							if (child.number >= 0.0 && size_t(child.number) < isChild.size())
+								isChild[size_t(child.number)] = true;
+						}
+					}
+				}
+				for (size_t i{}; i < isChild.size(); ++i)
+				{
+					if (!isChild[i])
+						rootNodes.push_back(static_cast<int>(i));
+				}
+			}
+
+			ParseStats stats{};
+			for (int node : rootNodes)
+			{
+				if (!document.AddNode(node, Transform{}, data, stats, 0))
+				{
+					std::cout << filename << ": unsupported or broken node " << node << " (sparse/external buffers, non float positions, ...)\n";
+					return false;
+				}
+			}
+
+			// Only when at least one primitive had normals, the ones after the last of those get zero normals as well
+			if (!data.normals.empty())
+				data.normals.resize(data.positions.size());
+
+			if (pStats != nullptr)
+			{
+				*pStats = stats;
+				pStats->fileSize = file.GetSize();
+				pStats->seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+			}
+			return true;
+		}
+
+		void ToTriangleMesh(GLBData& data, TriangleMesh& mesh)
+		{
+			mesh.positions = std::move(data.positions);
+			mesh.indices = std::move(data.indices);
+			mesh.triangleMaterials = std::move(data.triangleMaterials);
+			mesh.CalculateNormals();
+
+			if (data.normals.size() == mesh.positions.size())
+				MeshUtils::MatchWinding(data.normals, mesh.normals, mesh.indices);
+		}
+	}
+}
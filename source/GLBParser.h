@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	struct TriangleMesh;
+
+	namespace GLBParser
+	{
+		// pbrMetallicRoughness factors, textures aren't used
+		struct GLBMaterial
+		{
+			std::string name{};
+			ColorRGB baseColor{ 1.f, 1.f, 1.f };
+			float metalness{ 1.f };
+			float roughness{ 1.f };
+		};
+
+		// Every triangle primitive of the default scene in one list, node transforms already applied
+		struct GLBData
+		{
+			std::vector<Vector3> positions{};
+			std::vector<Vector3> normals{};                  // per vertex, empty when a primitive has none
+			std::vector<int> indices{};
+			std::vector<unsigned char> triangleMaterials{};  // index in materials, materials.size() for primitives without a material
+			std::vector<GLBMaterial> materials{};
+		};
+
+		struct ParseStats
+		{
+			size_t fileSize{};
+			float seconds{};
+			size_t primitiveCount{};
+		};
+
+		/**
+		 * \brief Reads a binary glTF 2.0 file: the JSON chunk is parsed, the vertex & index data gets copied straight out of
+		 * the memory mapped BIN chunk (one memcpy per accessor when it's tightly packed).
+		 * glTF is right handed, positions & normals get their z mirrored into the left handed world of the renderer
+		 * Files with more than 255 materials fail, triangle materials are a byte
+		 * \param pStats timing info (optional)
+		 */
+		bool Parse(const std::string& filename, GLBData& data, ParseStats* pStats = nullptr);
+
+		/**
+		 * \brief Moves positions, indices & triangle materials into the mesh and calculates a normal per triangle,
+		 * flipped when the file's vertex normals point the other way
+		 */
+		void ToTriangleMesh(GLBData& data, TriangleMesh& mesh);
+	}
+}
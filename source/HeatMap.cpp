@@ -0,0 +1,84 @@
+#include "HeatMap.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace dae
+{
+	HeatMap::HeatMap(uint32_t width, uint32_t height) :
+		m_Width{ width },
+		m_Height{ height },
+		m_Costs(size_t(width) * height),
+		m_SortedCosts(m_Costs.size())
+	{
+	}
+
+	float HeatMap::GetAutoScale()
+	{
+		if (m_Costs.empty())
+			return 0.f;
+
+		std::copy(m_Costs.begin(), m_Costs.end(), m_SortedCosts.begin());
+		const auto percentile{ m_SortedCosts.begin() + m_SortedCosts.size() * 99 / 100 };
+		std::nth_element(m_SortedCosts.begin(), percentile, m_SortedCosts.end());
+		return *percentile;
+	}
+
+	std::vector<ColorRGB> HeatMap::GetRamp(Ramp ramp)
+	{
+		switch (ramp)
+		{
+		case Ramp::Heat:
+			return { colors::Black, { 0.5f, 0.f, 0.f }, colors::Red, { 1.f, 0.5f, 0.f }, colors::Yellow, colors::White };
+		case Ramp::Rainbow:
+			return { { 0.f, 0.f, 0.5f }, colors::Blue, colors::Cyan, colors::Green, colors::Yellow, colors::Red, { 0.5f, 0.f, 0.f } };
+		case Ramp::Grayscale:
+		default:
+			return { colors::Black, colors::White };
+		}
+	}
+
+	void HeatMap::Colorize(uint32_t* pDestination, const FrameWriter::PixelLayout& layout, const std::vector<ColorRGB>& ramp, float scale)
+	{
+		if (scale <= 0.f)
+			scale = GetAutoScale();
+		// Nothing cost anything (or there's no ramp): all of it is the first color
+		const float inverseScale{ scale > 0.f ? 1.f / scale : 0.f };
+		const float lastStop{ ramp.empty() ? 0.f : float(ramp.size() - 1) };
+
+		for (size_t i{}; i < m_Costs.size(); ++i)
+		{
+			ColorRGB color{};
+			if (!ramp.empty())
+			{
+				const float position{ std::clamp(m_Costs[i] * inverseScale, 0.f, 1.f) * lastStop };
+				const size_t stop{ std::min(static_cast<size_t>(position), ramp.size() - 1) };
+				const size_t nextStop{ std::min(stop + 1, ramp.size() - 1) };
+				const float t{ position - float(stop) };
+				color = ramp[stop] * (1.f - t) + ramp[nextStop] * t;
+			}
+
+			pDestination[i] = static_cast<uint32_t>(std::clamp(color.r, 0.f, 1.f) * 255.f) << layout.redShift
+				| static_cast<uint32_t>(std::clamp(color.g, 0.f, 1.f) * 255.f) << layout.greenShift
+				| static_cast<uint32_t>(std::clamp(color.b, 0.f, 1.f) * 255.f) << layout.blueShift
+				| layout.alphaMask;
+		}
+	}
+
+	bool HeatMap::SavePFM(const std::string& filename) const
+	{
+		std::FILE* pFile{ std::fopen(filename.c_str(), "wb") };
+		if (pFile == nullptr)
+			return false;
+
+		// A negative scale means little endian
+		std::fprintf(pFile, "Pf\n%u %u\n-1.0\n", m_Width, m_Height);
+
+		bool isWritten{ true };
+		for (uint32_t y{ m_Height }; y-- > 0 && isWritten;)
+		{
+			isWritten = std::fwrite(m_Costs.data() + size_t(y) * m_Width, sizeof(float), m_Width, pFile) == m_Width;
+		}
+		return std::fclose(pFile) == 0 && isWritten;
+	}
+}
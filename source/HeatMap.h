@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ColorRGB.h"
+#include "FrameWriter.h"
+
+namespace dae
+{
+	// What every pixel of a frame cost (tests, nodes, shadow rays or microseconds), shown through a color ramp instead of the
+	// shaded image. Cheap pixels are the ramp's first color, pixels at the scale or above its last
+	class HeatMap final
+	{
+	public:
+		enum class Ramp
+		{
+			Grayscale,  // black to white
+			Heat,       // black, red, yellow, white
+			Rainbow     // dark blue, cyan, green, yellow, red
+		};
+
+		HeatMap(uint32_t width, uint32_t height);
+		~HeatMap() = default;
+
+		HeatMap(const HeatMap&) = delete;
+		HeatMap(HeatMap&&) noexcept = delete;
+		HeatMap& operator=(const HeatMap&) = delete;
+		HeatMap& operator=(HeatMap&&) noexcept = delete;
+
+		void SetCost(uint32_t index, float cost) { m_Costs[index] = cost; }
+		// 99th percentile of the costs, so a few outliers (a cache miss, a thread getting preempted) don't wash out the rest
+		float GetAutoScale();
+
+		static std::vector<ColorRGB> GetRamp(Ramp ramp);
+
+		/**
+		 * \brief Colors width * height packed pixels
+		 * \param ramp at least one color, evenly spread from cost 0 to scale
+		 * \param scale cost at the end of the ramp, 0 is GetAutoScale
+		 */
+		void Colorize(uint32_t* pDestination, const FrameWriter::PixelLayout& layout, const std::vector<ColorRGB>& ramp, float scale);
+
+		// Single channel portable float map ("Pf"), little endian, rows bottom to top. The raw costs, without a ramp or scale
+		bool SavePFM(const std::string& filename) const;
+
+	private:
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		std::vector<float> m_Costs{};
+		std::vector<float> m_SortedCosts{};  // scratch for GetAutoScale, allocated once
+	};
+}
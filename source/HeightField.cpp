@@ -0,0 +1,316 @@
+#include "HeightField.h"
+
+#include <algorithm>
+
+#include "Utils.h"
+
+namespace dae
+{
+#pragma region Helpers
+	// Moller-Trumbore without culling, terrain can be hit from both sides
+	static bool IntersectTerrainTriangle(const Vector3& v0, const Vector3& v1, const Vector3& v2, const Ray& ray, float tMin, float tMax, float& t)
+	{
+		const Vector3 edge1{ v1 - v0 };
+		const Vector3 edge2{ v2 - v0 };
+		const Vector3 h{ Vector3::Cross(ray.direction, edge2) };
+		const float a{ Vector3::Dot(edge1, h) };
+		if (fabsf(a) < FLT_EPSILON)
+			return false;
+
+		const float f{ 1.0f / a };
+		const Vector3 s{ ray.origin - v0 };
+		const float u{ f * Vector3::Dot(s, h) };
+		if (u < 0.0f || u > 1.0f)
+			return false;
+
+		const Vector3 q{ Vector3::Cross(s, edge1) };
+		const float v{ f * Vector3::Dot(ray.direction, q) };
+		if (v < 0.0f || u + v > 1.0f)
+			return false;
+
+		t = f * Vector3::Dot(edge2, q);
+		return t >= tMin && t <= tMax;
+	}
+#pragma endregion
+
+	void HeightField::BuildMinMaxLevels()
+	{
+		minMaxLevels.clear();
+		levelWidths.clear();
+		levelDepths.clear();
+
+		if (width < 2 || depth < 2)
+			return;
+
+		const uint32_t cellsX{ width - 1 };
+		const uint32_t cellsZ{ depth - 1 };
+
+		// Level 0: height range of every leaf tile, including the samples on its far edges
+		uint32_t levelWidth{ (cellsX + LeafSize - 1) / LeafSize };
+		uint32_t levelDepth{ (cellsZ + LeafSize - 1) / LeafSize };
+		std::vector<MinMax> level(levelWidth * levelDepth);
+		for (uint32_t tz{}; tz < levelDepth; ++tz)
+		{
+			for (uint32_t tx{}; tx < levelWidth; ++tx)
+			{
+				MinMax range{ FLT_MAX, -FLT_MAX };
+				const uint32_t xEnd{ std::min((tx + 1) * LeafSize, cellsX) };
+				const uint32_t zEnd{ std::min((tz + 1) * LeafSize, cellsZ) };
+				for (uint32_t z{ tz * LeafSize }; z <= zEnd; ++z)
+				{
+					for (uint32_t x{ tx * LeafSize }; x <= xEnd; ++x)
+					{
+						range.min = std::min(range.min, GetHeight(x, z));
+						range.max = std::max(range.max, GetHeight(x, z));
+					}
+				}
+				level[tz * levelWidth + tx] = range;
+			}
+		}
+
+		minMaxLevels.push_back(std::move(level));
+		levelWidths.push_back(levelWidth);
+		levelDepths.push_back(levelDepth);
+
+		// Every next level merges 2x2 nodes of the previous one, until a single root is left
+		while (levelWidth > 1 || levelDepth > 1)
+		{
+			const std::vector<MinMax>& previous{ minMaxLevels.back() };
+			const uint32_t previousWidth{ levelWidth };
+			const uint32_t previousDepth{ levelDepth };
+			levelWidth = (levelWidth + 1) / 2;
+			levelDepth = (levelDepth + 1) / 2;
+
+			std::vector<MinMax> next(levelWidth * levelDepth, MinMax{ FLT_MAX, -FLT_MAX });
+			for (uint32_t z{}; z < previousDepth; ++z)
+			{
+				for (uint32_t x{}; x < previousWidth; ++x)
+				{
+					MinMax& parent{ next[(z / 2) * levelWidth + (x / 2)] };
+					const MinMax& child{ previous[z * previousWidth + x] };
+					parent.min = std::min(parent.min, child.min);
+					parent.max = std::max(parent.max, child.max);
+				}
+			}
+
+			minMaxLevels.push_back(std::move(next));
+			levelWidths.push_back(levelWidth);
+			levelDepths.push_back(levelDepth);
+		}
+
+		const MinMax& root{ minMaxLevels.back()[0] };
+		minAABB = { origin.x, origin.y + root.min, origin.z };
+		maxAABB = { origin.x + cellsX * cellSize, origin.y + root.max, origin.z + cellsZ * cellSize };
+	}
+
+	bool HeightField::Intersect(const Ray& ray, float& t, Vector3& normal, bool anyHit) const
+	{
+		if (minMaxLevels.empty())
+			return false;
+
+		const uint32_t cellsX{ width - 1 };
+		const uint32_t cellsZ{ depth - 1 };
+		const float invCellSize{ 1.f / cellSize };
+
+		float closestT{ ray.max };
+		uint32_t hitCellX{}, hitCellZ{};
+		bool didHit{ false };
+
+		// Depth first, front to back. Every pop pushes at most 4 nodes, so 4 per level is plenty
+		struct Node
+		{
+			uint32_t level{};
+			uint32_t x{};
+			uint32_t z{};
+		};
+		Node stack[128]{};
+		int stackSize{};
+		stack[stackSize++] = { static_cast<uint32_t>(minMaxLevels.size() - 1), 0, 0 };
+
+		// Children closest to the ray origin get pushed last so they're popped first
+		const uint32_t nearOffsetX{ ray.direction.x >= 0.f ? 0u : 1u };
+		const uint32_t nearOffsetZ{ ray.direction.z >= 0.f ? 0u : 1u };
+
+		while (stackSize > 0)
+		{
+			const Node node{ stack[--stackSize] };
+
+			const uint32_t nodeCells{ LeafSize << node.level };
+			const uint32_t x0{ node.x * nodeCells };
+			const uint32_t z0{ node.z * nodeCells };
+			const uint32_t x1{ std::min(x0 + nodeCells, cellsX) };
+			const uint32_t z1{ std::min(z0 + nodeCells, cellsZ) };
+
+			const MinMax& range{ minMaxLevels[node.level][node.z * levelWidths[node.level] + node.x] };
+			const Vector3 nodeMin{ origin.x + x0 * cellSize, origin.y + range.min, origin.z + z0 * cellSize };
+			const Vector3 nodeMax{ origin.x + x1 * cellSize, origin.y + range.max, origin.z + z1 * cellSize };
+
+			float tNear{}, tFar{};
+			int nearAxis{}, farAxis{};
+			if (!GeometryUtils::SlabTest_AABB(nodeMin, nodeMax, ray, tNear, tFar, nearAxis, farAxis) || tNear > closestT || tFar < ray.min)
+				continue;
+
+			if (node.level > 0)
+			{
+				const uint32_t childLevel{ node.level - 1 };
+				for (uint32_t i{}; i < 4; ++i)
+				{
+					// i == 0 is the far child, i == 3 the near one
+					const uint32_t childX{ node.x * 2 + ((i & 1) ? nearOffsetX : 1 - nearOffsetX) };
+					const uint32_t childZ{ node.z * 2 + ((i & 2) ? nearOffsetZ : 1 - nearOffsetZ) };
+					if (childX < levelWidths[childLevel] && childZ < levelDepths[childLevel])
+						stack[stackSize++] = { childLevel, childX, childZ };
+				}
+				continue;
+			}
+
+			// Leaf tile: 2D DDA over its cells, starting where the ray enters the tile
+			const float tStart{ std::max(tNear, ray.min) };
+			const float tEnd{ std::min(tFar, closestT) };
+			const Vector3 entry{ ray.origin + ray.direction * tStart };
+
+			int cellX{ std::clamp(static_cast<int>(floorf((entry.x - origin.x) * invCellSize)), static_cast<int>(x0), static_cast<int>(x1) - 1) };
+			int cellZ{ std::clamp(static_cast<int>(floorf((entry.z - origin.z) * invCellSize)), static_cast<int>(z0), static_cast<int>(z1) - 1) };
+
+			const int stepX{ ray.direction.x >= 0.f ? 1 : -1 };
+			const int stepZ{ ray.direction.z >= 0.f ? 1 : -1 };
+			const float tDeltaX{ ray.direction.x != 0.f ? cellSize / fabsf(ray.direction.x) : FLT_MAX };
+			const float tDeltaZ{ ray.direction.z != 0.f ? cellSize / fabsf(ray.direction.z) : FLT_MAX };
+			float tMaxX{ ray.direction.x != 0.f ? (origin.x + (cellX + (stepX > 0 ? 1 : 0)) * cellSize - ray.origin.x) / ray.direction.x : FLT_MAX };
+			float tMaxZ{ ray.direction.z != 0.f ? (origin.z + (cellZ + (stepZ > 0 ? 1 : 0)) * cellSize - ray.origin.z) / ray.direction.z : FLT_MAX };
+
+			while (true)
+			{
+				const float cx0{ origin.x + cellX * cellSize };
+				const float cz0{ origin.z + cellZ * cellSize };
+				const Vector3 v00{ cx0, origin.y + GetHeight(cellX, cellZ), cz0 };
+				const Vector3 v10{ cx0 + cellSize, origin.y + GetHeight(cellX + 1, cellZ), cz0 };
+				const Vector3 v01{ cx0, origin.y + GetHeight(cellX, cellZ + 1), cz0 + cellSize };
+				const Vector3 v11{ cx0 + cellSize, origin.y + GetHeight(cellX + 1, cellZ + 1), cz0 + cellSize };
+
+				// Same split as Triangulate
+				float triangleT{};
+				bool cellHit{ false };
+				if (IntersectTerrainTriangle(v00, v01, v11, ray, ray.min, closestT, triangleT))
+				{
+					closestT = triangleT;
+					cellHit = true;
+				}
+				if (IntersectTerrainTriangle(v00, v11, v10, ray, ray.min, closestT, triangleT))
+				{
+					closestT = triangleT;
+					cellHit = true;
+				}
+
+				if (cellHit)
+				{
+					// Cells are visited in order along the ray, nothing further in this tile can be closer
+					didHit = true;
+					hitCellX = cellX;
+					hitCellZ = cellZ;
+					if (anyHit)
+					{
+						t = closestT;
+						return true;
+					}
+					break;
+				}
+
+				if (tMaxX < tMaxZ)
+				{
+					if (tMaxX > tEnd)
+						break;
+					cellX += stepX;
+					if (cellX < static_cast<int>(x0) || cellX >= static_cast<int>(x1))
+						break;
+					tMaxX += tDeltaX;
+				}
+				else
+				{
+					if (tMaxZ > tEnd)
+						break;
+					cellZ += stepZ;
+					if (cellZ < static_cast<int>(z0) || cellZ >= static_cast<int>(z1))
+						break;
+					tMaxZ += tDeltaZ;
+				}
+			}
+		}
+
+		if (!didHit)
+			return false;
+
+		t = closestT;
+
+		// Bilinear blend of the finite difference normals at the 4 corners of the cell
+		const Vector3 hitPoint{ ray.origin + ray.direction * closestT };
+		const float fx{ std::clamp((hitPoint.x - origin.x) * invCellSize - hitCellX, 0.f, 1.f) };
+		const float fz{ std::clamp((hitPoint.z - origin.z) * invCellSize - hitCellZ, 0.f, 1.f) };
+		normal = GetSampleNormal(hitCellX, hitCellZ) * ((1.f - fx) * (1.f - fz))
+			+ GetSampleNormal(hitCellX + 1, hitCellZ) * (fx * (1.f - fz))
+			+ GetSampleNormal(hitCellX, hitCellZ + 1) * ((1.f - fx) * fz)
+			+ GetSampleNormal(hitCellX + 1, hitCellZ + 1) * (fx * fz);
+		normal.Normalize();
+
+		// Seen from below
+		if (Vector3::Dot(normal, ray.direction) > 0.f)
+			normal = -normal;
+
+		return true;
+	}
+
+	Vector3 HeightField::GetSampleNormal(uint32_t x, uint32_t z) const
+	{
+		// Central differences, one-sided at the borders
+		const uint32_t left{ x > 0 ? x - 1 : x };
+		const uint32_t right{ x + 1 < width ? x + 1 : x };
+		const uint32_t back{ z > 0 ? z - 1 : z };
+		const uint32_t front{ z + 1 < depth ? z + 1 : z };
+
+		const float slopeX{ (GetHeight(right, z) - GetHeight(left, z)) / ((right - left) * cellSize) };
+		const float slopeZ{ (GetHeight(x, front) - GetHeight(x, back)) / ((front - back) * cellSize) };
+		return Vector3{ -slopeX, 1.f, -slopeZ }.Normalized();
+	}
+
+	size_t HeightField::GetMemoryFootprint() const
+	{
+		size_t bytes{ heights.size() * sizeof(float) };
+		for (const std::vector<MinMax>& level : minMaxLevels)
+		{
+			bytes += level.size() * sizeof(MinMax);
+		}
+		return bytes + (levelWidths.size() + levelDepths.size()) * sizeof(uint32_t);
+	}
+
+	void HeightField::Triangulate(TriangleMesh& mesh) const
+	{
+		mesh.positions.clear();
+		mesh.indices.clear();
+		mesh.positions.reserve(heights.size());
+		mesh.indices.reserve(size_t(width - 1) * (depth - 1) * 6);
+
+		for (uint32_t z{}; z < depth; ++z)
+		{
+			for (uint32_t x{}; x < width; ++x)
+			{
+				mesh.positions.emplace_back(origin.x + x * cellSize, origin.y + GetHeight(x, z), origin.z + z * cellSize);
+			}
+		}
+
+		for (uint32_t z{}; z + 1 < depth; ++z)
+		{
+			for (uint32_t x{}; x + 1 < width; ++x)
+			{
+				const int i00{ static_cast<int>(z * width + x) };
+				const int i10{ i00 + 1 };
+				const int i01{ i00 + static_cast<int>(width) };
+				const int i11{ i01 + 1 };
+
+				mesh.indices.insert(mesh.indices.end(), { i00, i01, i11 });
+				mesh.indices.insert(mesh.indices.end(), { i00, i11, i10 });
+			}
+		}
+
+		mesh.CalculateNormals();
+	}
+}
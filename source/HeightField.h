@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	struct Ray;
+	struct TriangleMesh;
+
+	// Terrain stored as a grid of height samples instead of triangles.
+	// Every cell (square between 4 samples) is treated as 2 triangles when hit-testing, so it renders
+	// exactly like its triangulated version, but only 4 bytes per sample are kept around.
+	struct HeightField
+	{
+		// Amount of cells per side of a leaf tile, the tiles get walked with a 2D DDA
+		static constexpr uint32_t LeafSize{ 8 };
+
+		struct MinMax
+		{
+			float min{};
+			float max{};
+		};
+
+		// Position of sample (0, 0), samples are spaced cellSize apart along X and Z
+		Vector3 origin{};
+		float cellSize{ 1.f };
+
+		uint32_t width{};  // samples along X
+		uint32_t depth{};  // samples along Z
+		std::vector<float> heights{};  // width * depth, row by row (along X)
+
+		// Maximum mipmap: level 0 holds the height range of each leaf tile, every next level merges 2x2 tiles
+		std::vector<std::vector<MinMax>> minMaxLevels{};
+		std::vector<uint32_t> levelWidths{};
+		std::vector<uint32_t> levelDepths{};
+
+		Vector3 minAABB{};
+		Vector3 maxAABB{};
+
+		unsigned char materialIndex{ 0 };
+
+		float GetHeight(uint32_t x, uint32_t z) const { return heights[z * width + x]; }
+
+		// Has to be called after changing the heights
+		void BuildMinMaxLevels();
+
+		/**
+		 * \brief Walks the min-max quadtree front to back, and the cells of the leaf tiles it reaches with a 2D DDA
+		 * \param t closest hit distance (out)
+		 * \param normal normal at the hit (out), interpolated from finite differences
+		 * \param anyHit stop at the first hit (shadow rays)
+		 */
+		bool Intersect(const Ray& ray, float& t, Vector3& normal, bool anyHit = false) const;
+
+		// Central differences around a sample
+		Vector3 GetSampleNormal(uint32_t x, uint32_t z) const;
+
+		size_t GetMemoryFootprint() const;
+
+		// Builds the equivalent triangle mesh (2 triangles per cell), used to compare against
+		void Triangulate(TriangleMesh& mesh) const;
+	};
+}
@@ -0,0 +1,106 @@
+#include "InputSource.h"
+
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+
+#include <SDL_keyboard.h>
+#include <SDL_mouse.h>
+
+namespace dae
+{
+	namespace
+	{
+		// The bit of every button in a recording
+		constexpr bool CameraInput::* Buttons[]
+		{
+			&CameraInput::moveForward, &CameraInput::moveBackward, &CameraInput::moveRight, &CameraInput::moveLeft,
+			&CameraInput::moveUp, &CameraInput::moveDown, &CameraInput::pitchUp, &CameraInput::pitchDown,
+			&CameraInput::yawLeft, &CameraInput::yawRight, &CameraInput::isLeftMouseDown, &CameraInput::isRightMouseDown
+		};
+	}
+
+	CameraInput SDLInputSource::GetCameraInput()
+	{
+		CameraInput input{};
+
+		const uint8_t* pKeyboardState = SDL_GetKeyboardState(nullptr);
+		input.moveForward = pKeyboardState[SDL_SCANCODE_W];
+		input.moveBackward = pKeyboardState[SDL_SCANCODE_S];
+		input.moveRight = pKeyboardState[SDL_SCANCODE_D];
+		input.moveLeft = pKeyboardState[SDL_SCANCODE_A];
+		input.moveUp = pKeyboardState[SDL_SCANCODE_SPACE];
+		input.moveDown = pKeyboardState[SDL_SCANCODE_LSHIFT];
+		input.pitchUp = pKeyboardState[SDL_SCANCODE_UP];
+		input.pitchDown = pKeyboardState[SDL_SCANCODE_DOWN];
+		input.yawLeft = pKeyboardState[SDL_SCANCODE_LEFT];
+		input.yawRight = pKeyboardState[SDL_SCANCODE_RIGHT];
+
+		const uint32_t mouseState = SDL_GetRelativeMouseState(&input.mouseX, &input.mouseY);
+		input.isLeftMouseDown = mouseState & SDL_BUTTON(SDL_BUTTON_LEFT);
+		input.isRightMouseDown = mouseState & SDL_BUTTON(SDL_BUTTON_RIGHT);
+		return input;
+	}
+
+	InputRecorder::InputRecorder(InputSource* pSource, const std::string& filename) :
+		m_pSource{ pSource },
+		m_File{ filename }
+	{
+		m_File << "# RayTracer input recording: <buttons> <mouse x> <mouse y> per frame\n";
+	}
+
+	CameraInput InputRecorder::GetCameraInput()
+	{
+		const CameraInput input{ m_pSource->GetCameraInput() };
+
+		// Straight into the file's buffer, recording doesn't allocate
+		uint32_t buttons{};
+		for (uint32_t i{}; i < std::size(Buttons); ++i)
+		{
+			if (input.*Buttons[i])
+				buttons |= 1u << i;
+		}
+		char line[64];
+		const int lineSize{ std::snprintf(line, sizeof(line), "%x %d %d\n", buttons, input.mouseX, input.mouseY) };
+		m_File.write(line, lineSize);
+		return input;
+	}
+
+	RecordedInputSource::RecordedInputSource(const std::string& filename)
+	{
+		std::ifstream file{ filename };
+		if (!file)
+		{
+			std::cout << "Couldn't open input recording " << filename << '\n';
+			return;
+		}
+
+		std::string line{};
+		uint32_t lineNumber{};
+		while (std::getline(file, line))
+		{
+			++lineNumber;
+			if (line.empty() || line[0] == '#' || line[0] == '\r')
+				continue;
+
+			uint32_t buttons{};
+			CameraInput input{};
+			if (std::sscanf(line.c_str(), "%x %d %d", &buttons, &input.mouseX, &input.mouseY) != 3)
+			{
+				std::cout << filename << '(' << lineNumber << "): expected <buttons> <mouse x> <mouse y>\n";
+				return;
+			}
+			for (uint32_t i{}; i < std::size(Buttons); ++i)
+			{
+				input.*Buttons[i] = (buttons >> i & 1) != 0;
+			}
+			m_Frames.push_back(input);
+		}
+		m_IsLoaded = true;
+	}
+
+	CameraInput RecordedInputSource::GetCameraInput()
+	{
+		return m_Frame < m_Frames.size() ? m_Frames[m_Frame++] : CameraInput{};
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace dae
+{
+	// What the camera is told to do this frame, from the keyboard & mouse or from anything else that drives it
+	struct CameraInput
+	{
+		bool moveForward{};
+		bool moveBackward{};
+		bool moveRight{};
+		bool moveLeft{};
+		bool moveUp{};
+		bool moveDown{};
+		bool pitchUp{};
+		bool pitchDown{};
+		bool yawLeft{};
+		bool yawRight{};
+
+		int mouseX{};  // relative movement since the last frame
+		int mouseY{};
+		bool isLeftMouseDown{};
+		bool isRightMouseDown{};
+	};
+
+	// Where the scene gets its camera input from, a scene without one (headless) gets no input at all
+	class InputSource
+	{
+	public:
+		InputSource() = default;
+		virtual ~InputSource() = default;
+
+		InputSource(const InputSource&) = delete;
+		InputSource(InputSource&&) noexcept = delete;
+		InputSource& operator=(const InputSource&) = delete;
+		InputSource& operator=(InputSource&&) noexcept = delete;
+
+		// Called once per frame
+		virtual CameraInput GetCameraInput() = 0;
+	};
+
+	// Keyboard state & relative mouse movement of the SDL window
+	class SDLInputSource final : public InputSource
+	{
+	public:
+		CameraInput GetCameraInput() override;
+	};
+
+	// Passes another source's input through and writes every frame of it to a file, for RecordedInputSource.
+	// One line per frame: "<buttons> <mouse x> <mouse y>", buttons is a hex mask with a bit per bool of CameraInput, in order
+	class InputRecorder final : public InputSource
+	{
+	public:
+		// pSource isn't owned
+		InputRecorder(InputSource* pSource, const std::string& filename);
+
+		bool IsOpen() const { return m_File.is_open(); }
+		CameraInput GetCameraInput() override;
+
+	private:
+		InputSource* m_pSource{};
+		std::ofstream m_File{};
+	};
+
+	// Plays back what an InputRecorder wrote, one line per frame. After the last one there's no input anymore.
+	// The camera moves by the timer's elapsed time, with a fixed step every run gets the same frames
+	class RecordedInputSource final : public InputSource
+	{
+	public:
+		// Prints what's wrong with the file, IsLoaded says whether it worked
+		explicit RecordedInputSource(const std::string& filename);
+
+		bool IsLoaded() const { return m_IsLoaded; }
+		uint32_t GetFrameCount() const { return static_cast<uint32_t>(m_Frames.size()); }
+		CameraInput GetCameraInput() override;
+
+	private:
+		std::vector<CameraInput> m_Frames{};
+		size_t m_Frame{};
+		bool m_IsLoaded{};
+	};
+}
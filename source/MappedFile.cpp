@@ -0,0 +1,108 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dae
+{
+#if defined(_WIN32)
+	bool MappedFile::Open(const std::string& filename)
+	{
+		Close();
+
+		HANDLE file{ CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr) };
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size{};
+		// Empty files can't be mapped
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping{ CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+		if (mapping == nullptr)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		const void* pView{ MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) };
+		if (pView == nullptr)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		m_FileHandle = file;
+		m_MappingHandle = mapping;
+		m_pData = static_cast<const char*>(pView);
+		m_Size = static_cast<size_t>(size.QuadPart);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_pData != nullptr)
+			UnmapViewOfFile(m_pData);
+		if (m_MappingHandle != nullptr)
+			CloseHandle(m_MappingHandle);
+		if (m_FileHandle != nullptr)
+			CloseHandle(m_FileHandle);
+
+		m_pData = nullptr;
+		m_Size = 0;
+		m_MappingHandle = nullptr;
+		m_FileHandle = nullptr;
+	}
+#else
+	bool MappedFile::Open(const std::string& filename)
+	{
+		Close();
+
+		const int file{ open(filename.c_str(), O_RDONLY) };
+		if (file < 0)
+			return false;
+
+		struct stat info{};
+		// Empty files can't be mapped
+		if (fstat(file, &info) != 0 || info.st_size == 0)
+		{
+			close(file);
+			return false;
+		}
+
+		void* pView{ mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0) };
+		// The mapping keeps its own reference to the file
+		close(file);
+		if (pView == MAP_FAILED)
+			return false;
+
+		madvise(pView, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+
+		m_pData = static_cast<const char*>(pView);
+		m_Size = static_cast<size_t>(info.st_size);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_pData != nullptr)
+			munmap(const_cast<char*>(m_pData), m_Size);
+
+		m_pData = nullptr;
+		m_Size = 0;
+	}
+#endif
+}
@@ -171,7 +171,7 @@ namespace dae
 		return {
 			{ cosf(roll) , sinf(roll), 0, 0 },
 			{ -sinf(roll), cosf(roll), 0, 0 },
-			{ 0          , 0         , 0, 0 },
+			{ 0          , 0         , 1, 0 },
 			{ 0          , 0         , 0, 1 }
 		};
 	}
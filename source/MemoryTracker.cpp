@@ -0,0 +1,117 @@
+#include "MemoryTracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<uint64_t> g_AllocationCount{ 0 };
+	thread_local bool g_IsTracking{ false };
+
+	void CountAllocation()
+	{
+		if (g_IsTracking)
+			g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void* AlignedAllocate(size_t size, size_t alignment)
+	{
+#if defined(_WIN32)
+		return _aligned_malloc(size, alignment);
+#else
+		// aligned_alloc wants the size to be a multiple of the alignment
+		return std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+	}
+
+	void AlignedFree(void* pMemory)
+	{
+#if defined(_WIN32)
+		_aligned_free(pMemory);
+#else
+		std::free(pMemory);
+#endif
+	}
+}
+
+namespace dae
+{
+	namespace MemoryTracker
+	{
+		uint64_t GetAllocationCount()
+		{
+			return g_AllocationCount.load(std::memory_order_relaxed);
+		}
+
+		void ResetAllocationCount()
+		{
+			g_AllocationCount.store(0, std::memory_order_relaxed);
+		}
+
+		bool IsTracking()
+		{
+			return g_IsTracking;
+		}
+
+		ScopedTracking::ScopedTracking(bool isTracking) :
+			m_WasTracking{ g_IsTracking }
+		{
+			g_IsTracking = isTracking;
+		}
+
+		ScopedTracking::~ScopedTracking()
+		{
+			g_IsTracking = m_WasTracking;
+		}
+
+		ScopedPause::ScopedPause() :
+			m_WasTracking{ g_IsTracking }
+		{
+			g_IsTracking = false;
+		}
+
+		ScopedPause::~ScopedPause()
+		{
+			g_IsTracking = m_WasTracking;
+		}
+	}
+}
+
+#pragma region Global operator new/delete
+void* operator new(size_t size)
+{
+	CountAllocation();
+	if (void* pMemory{ std::malloc(size == 0 ? 1 : size) })
+		return pMemory;
+	throw std::bad_alloc{};
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	CountAllocation();
+	if (void* pMemory{ AlignedAllocate(size == 0 ? 1 : size, static_cast<size_t>(alignment)) })
+		return pMemory;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete(void* pMemory, size_t) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete(void* pMemory, std::align_val_t) noexcept
+{
+	AlignedFree(pMemory);
+}
+
+void operator delete(void* pMemory, size_t, std::align_val_t) noexcept
+{
+	AlignedFree(pMemory);
+}
+#pragma endregion
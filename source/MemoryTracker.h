@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+namespace dae
+{
+	// Counts heap allocations made through operator new, but only on threads that opted in with ScopedTracking.
+	// ThreadPool workers take it over from the thread that runs the loop. Used to check that steady-state frames (Update + Render) don't allocate.
+	namespace MemoryTracker
+	{
+		uint64_t GetAllocationCount();
+		void ResetAllocationCount();
+		// Whether allocations on the current thread count right now
+		bool IsTracking();
+
+		// Counts allocations made on the current thread while alive, or doesn't when isTracking is false
+		class ScopedTracking final
+		{
+		public:
+			explicit ScopedTracking(bool isTracking = true);
+			~ScopedTracking();
+
+			ScopedTracking(const ScopedTracking&) = delete;
+			ScopedTracking(ScopedTracking&&) noexcept = delete;
+			ScopedTracking& operator=(const ScopedTracking&) = delete;
+			ScopedTracking& operator=(ScopedTracking&&) noexcept = delete;
+
+		private:
+			bool m_WasTracking{};
+		};
+
+		// Stops counting on the current thread while alive (e.g. around a thread pool's own bookkeeping)
+		class ScopedPause final
+		{
+		public:
+			ScopedPause();
+			~ScopedPause();
+
+			ScopedPause(const ScopedPause&) = delete;
+			ScopedPause(ScopedPause&&) noexcept = delete;
+			ScopedPause& operator=(const ScopedPause&) = delete;
+			ScopedPause& operator=(ScopedPause&&) noexcept = delete;
+
+		private:
+			bool m_WasTracking{};
+		};
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	// Compact storage for a TriangleMesh, everything is stored in object space and decoded on the fly when hit-testing
+	struct CompressedMeshData
+	{
+		// 3 components per vertex, quantized to 16 bits inside the object space AABB
+		std::vector<uint16_t> positions{};
+		// 1 octahedral encoded normal per face (2x 16-bit snorm)
+		std::vector<uint32_t> normals{};
+
+		// Only one of these is filled in, 16-bit when the mesh has few enough vertices
+		std::vector<uint16_t> indices16{};
+		std::vector<uint32_t> indices32{};
+
+		// Decoded position = quantizationMin + quantized * quantizationScale
+		Vector3 quantizationMin{};
+		Vector3 quantizationScale{};
+
+		size_t GetIndexCount() const { return indices16.empty() ? indices32.size() : indices16.size(); }
+		uint32_t GetIndex(size_t i) const { return indices16.empty() ? indices32[i] : indices16[i]; }
+
+		size_t GetMemoryFootprint() const
+		{
+			return positions.size() * sizeof(uint16_t)
+				+ normals.size() * sizeof(uint32_t)
+				+ indices16.size() * sizeof(uint16_t)
+				+ indices32.size() * sizeof(uint32_t);
+		}
+	};
+
+	namespace MeshCompression
+	{
+		inline uint16_t QuantizeUnorm16(float value, float minValue, float invExtent)
+		{
+			const float normalized{ std::clamp((value - minValue) * invExtent, 0.f, 1.f) };
+			return static_cast<uint16_t>(normalized * 65535.f + 0.5f);
+		}
+
+		inline int16_t QuantizeSnorm16(float value)
+		{
+			return static_cast<int16_t>(roundf(std::clamp(value, -1.f, 1.f) * 32767.f));
+		}
+
+		inline Vector3 DecodePosition(const CompressedMeshData& data, uint32_t vertexIndex)
+		{
+			const uint16_t* pQuantized{ &data.positions[vertexIndex * 3] };
+			return {
+				data.quantizationMin.x + pQuantized[0] * data.quantizationScale.x,
+				data.quantizationMin.y + pQuantized[1] * data.quantizationScale.y,
+				data.quantizationMin.z + pQuantized[2] * data.quantizationScale.z
+			};
+		}
+
+		/**
+		 * \brief Octahedral normal encoding: project the unit sphere onto an octahedron, then unfold the lower half onto the square
+		 * \param n normalized direction
+		 * \return x in the low 16 bits, y in the high 16 bits (both snorm)
+		 */
+		inline uint32_t EncodeOctahedral(const Vector3& n)
+		{
+			const float invL1Norm{ 1.f / (fabsf(n.x) + fabsf(n.y) + fabsf(n.z)) };
+			float x{ n.x * invL1Norm };
+			float y{ n.y * invL1Norm };
+
+			if (n.z < 0.f)
+			{
+				// Fold the lower hemisphere over the diagonals
+				const float foldedX{ (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f) };
+				const float foldedY{ (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f) };
+				x = foldedX;
+				y = foldedY;
+			}
+
+			const uint16_t encodedX{ static_cast<uint16_t>(QuantizeSnorm16(x)) };
+			const uint16_t encodedY{ static_cast<uint16_t>(QuantizeSnorm16(y)) };
+			return static_cast<uint32_t>(encodedX) | (static_cast<uint32_t>(encodedY) << 16);
+		}
+
+		inline Vector3 DecodeOctahedral(uint32_t encoded)
+		{
+			const float x{ std::max(static_cast<int16_t>(encoded & 0xFFFF) / 32767.f, -1.f) };
+			const float y{ std::max(static_cast<int16_t>(encoded >> 16) / 32767.f, -1.f) };
+
+			Vector3 n{ x, y, 1.f - fabsf(x) - fabsf(y) };
+			const float t{ std::max(-n.z, 0.f) };
+			n.x += n.x >= 0.f ? -t : t;
+			n.y += n.y >= 0.f ? -t : t;
+			n.Normalize();
+			return n;
+		}
+	}
+}
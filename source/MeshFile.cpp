@@ -0,0 +1,181 @@
+#include "MeshFile.h"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "DataTypes.h"
+#include "MappedFile.h"
+#include "MeshUtils.h"
+#include "Utils.h"
+
+namespace dae
+{
+	namespace MeshFile
+	{
+		static_assert(sizeof(Vector3) == 3 * sizeof(float), "Vector3 gets copied as 3 floats");
+
+		namespace
+		{
+			size_t AlignUp(size_t offset)
+			{
+				return (offset + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+			}
+
+			Section PlaceSection(size_t& offset, size_t size)
+			{
+				if (size == 0)
+					return {};
+
+				offset = AlignUp(offset);
+				const Section section{ offset, size };
+				offset += size;
+				return section;
+			}
+
+			void WriteSection(std::ofstream& file, const Section& section, const void* pData)
+			{
+				if (section.size == 0)
+					return;
+
+				// Zero padding up to the section start
+				static constexpr char padding[SectionAlignment]{};
+				const size_t position{ static_cast<size_t>(file.tellp()) };
+				file.write(padding, section.offset - position);
+				file.write(static_cast<const char*>(pData), section.size);
+			}
+
+			bool IsInFile(const Section& section, size_t fileSize)
+			{
+				return section.offset <= fileSize && section.size <= fileSize - section.offset;
+			}
+
+			template<typename T>
+			void CopySection(const char* pFile, const Section& section, std::vector<T>& destination)
+			{
+				destination.resize(section.size / sizeof(T));
+				if (section.size > 0)
+					std::memcpy(destination.data(), pFile + section.offset, section.size);
+			}
+		}
+
+		bool Save(const std::string& filename, const TriangleMesh& mesh)
+		{
+			assert(!mesh.isCompressed && "Save the mesh before compressing it");
+
+			const size_t triangleCount{ mesh.indices.size() / 3 };
+			const bool hasMaterials{ mesh.triangleMaterials.size() == triangleCount && triangleCount > 0 };
+
+			Header header{};
+			std::memcpy(header.magic, Magic, sizeof(Magic));
+			header.version = Version;
+			header.headerSize = sizeof(Header);
+			header.vertexCount = static_cast<uint32_t>(mesh.positions.size());
+			header.triangleCount = static_cast<uint32_t>(triangleCount);
+			for (int axis{}; axis < 3; ++axis)
+			{
+				header.minAABB[axis] = mesh.minAABB[axis];
+				header.maxAABB[axis] = mesh.maxAABB[axis];
+			}
+
+			size_t offset{ sizeof(Header) };
+			header.positions = PlaceSection(offset, mesh.positions.size() * sizeof(Vector3));
+			header.normals = PlaceSection(offset, mesh.normals.size() == triangleCount ? triangleCount * sizeof(Vector3) : 0);
+			header.indices = PlaceSection(offset, mesh.indices.size() * sizeof(int));
+			header.materials = PlaceSection(offset, hasMaterials ? triangleCount : 0);
+
+			std::ofstream file{ filename, std::ios::binary };
+			if (!file)
+				return false;
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			WriteSection(file, header.positions, mesh.positions.data());
+			WriteSection(file, header.normals, mesh.normals.data());
+			WriteSection(file, header.indices, mesh.indices.data());
+			WriteSection(file, header.materials, mesh.triangleMaterials.data());
+			return file.good();
+		}
+
+		bool Load(const std::string& filename, TriangleMesh& mesh)
+		{
+			MappedFile file{ filename };
+			if (!file.IsOpen() || file.GetSize() < sizeof(Header))
+				return false;
+
+			Header header{};
+			std::memcpy(&header, file.GetData(), sizeof(Header));
+			if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version || header.headerSize < sizeof(Header))
+				return false;
+
+			// Sizes have to match the counts, and everything has to be inside the file
+			const size_t triangleCount{ header.triangleCount };
+			const bool isValid{
+				header.positions.size == size_t(header.vertexCount) * sizeof(Vector3) &&
+				(header.normals.size == 0 || header.normals.size == triangleCount * sizeof(Vector3)) &&
+				header.indices.size == triangleCount * 3 * sizeof(int) &&
+				(header.materials.size == 0 || header.materials.size == triangleCount) &&
+				IsInFile(header.positions, file.GetSize()) && IsInFile(header.normals, file.GetSize()) &&
+				IsInFile(header.indices, file.GetSize()) && IsInFile(header.materials, file.GetSize()) &&
+				IsInFile(header.bvh, file.GetSize()) };
+			if (!isValid)
+				return false;
+
+			CopySection(file.GetData(), header.positions, mesh.positions);
+			CopySection(file.GetData(), header.normals, mesh.normals);
+			CopySection(file.GetData(), header.indices, mesh.indices);
+			CopySection(file.GetData(), header.materials, mesh.triangleMaterials);
+
+			// A truncated or corrupt file would have the renderer read outside of the positions
+			for (int index : mesh.indices)
+			{
+				if (index < 0 || static_cast<uint32_t>(index) >= header.vertexCount)
+				{
+					std::cout << filename << ": index " << index << " outside of its " << header.vertexCount << " vertices, corrupt mesh file\n";
+					return false;
+				}
+			}
+
+			if (mesh.normals.empty())
+				mesh.CalculateNormals();
+
+			mesh.minAABB = { header.minAABB[0], header.minAABB[1], header.minAABB[2] };
+			mesh.maxAABB = { header.maxAABB[0], header.maxAABB[1], header.maxAABB[2] };
+			return true;
+		}
+
+		bool ConvertOBJ(const std::string& objFilename, const std::string& meshFilename, TriangleMesh& mesh, bool optimize)
+		{
+			OBJParser::OBJData data{};
+			if (!OBJParser::Parse(objFilename, data))
+				return false;
+
+			mesh.positions.clear();
+			mesh.normals.clear();
+			mesh.indices.clear();
+			mesh.triangleMaterials.clear();
+			OBJParser::ToTriangleMesh(data, mesh.positions, mesh.normals, mesh.indices, mesh.triangleMaterials);
+			if (!data.materialNames.empty())
+			{
+				std::cout << "Material slots in " << objFilename << ":";
+				for (size_t i{}; i < data.materialNames.size(); ++i)
+				{
+					std::cout << ' ' << i << '=' << data.materialNames[i];
+				}
+				std::cout << '\n';
+			}
+
+			// Once per file (the cache), so the reduction gets reported
+			if (optimize)
+				MeshUtils::OptimizeMesh(mesh, 1e-5f, true);
+			mesh.UpdateAABB();
+
+			if (!Save(meshFilename, mesh))
+			{
+				std::cout << "Couldn't write " << meshFilename << '\n';
+				return false;
+			}
+			return true;
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace dae
+{
+	struct TriangleMesh;
+
+	// Binary mesh format (.bmesh): a fixed header followed by the arrays TriangleMesh uses, byte for byte.
+	// Loading is a memory map + one copy per array, nothing gets parsed
+	namespace MeshFile
+	{
+		constexpr char Magic[8]{ 'D', 'A', 'E', 'M', 'E', 'S', 'H', '\0' };
+		constexpr uint32_t Version{ 1 };
+		constexpr size_t SectionAlignment{ 64 };  // every section starts on a cache line
+		constexpr const char* Extension{ ".bmesh" };
+
+		// Byte range in the file, size 0 when the section isn't there
+		struct Section
+		{
+			uint64_t offset{};
+			uint64_t size{};
+		};
+
+		// Little endian, 128 bytes
+		struct Header
+		{
+			char magic[8]{};
+			uint32_t version{};
+			uint32_t headerSize{};  // sizeof(Header) of the writer, newer versions can append fields
+			uint32_t vertexCount{};
+			uint32_t triangleCount{};
+			float minAABB[3]{};
+			float maxAABB[3]{};
+
+			Section positions{};  // vertexCount * 3 floats
+			Section normals{};    // triangleCount * 3 floats, one normal per triangle
+			Section indices{};    // triangleCount * 3 int32
+			Section materials{};  // triangleCount * uint8 material slots (optional)
+			Section bvh{};        // prebuilt acceleration structure (optional, reserved: meshes don't have one yet)
+		};
+		static_assert(sizeof(Header) == 128, "MeshFile::Header layout changed");
+
+		bool Save(const std::string& filename, const TriangleMesh& mesh);
+
+		// Fills positions, normals, indices, triangleMaterials & the object space AABB. Transforms are left alone
+		bool Load(const std::string& filename, TriangleMesh& mesh);
+
+		/**
+		 * \brief Parses an OBJ (usemtl names become material slots in order of first use) and writes it as a .bmesh
+		 * \param mesh receives the converted mesh, so it doesn't have to be loaded again
+		 * \param optimize weld & reorder the mesh first (MeshUtils::OptimizeMesh), so that work is done once instead of at every load
+		 */
+		bool ConvertOBJ(const std::string& objFilename, const std::string& meshFilename, TriangleMesh& mesh, bool optimize = true);
+	}
+}
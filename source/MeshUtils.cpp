@@ -0,0 +1,314 @@
+#include "MeshUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <unordered_map>
+
+#include "Utils.h"
+
+namespace dae
+{
+	namespace MeshUtils
+	{
+#pragma region Helpers
+		// Hashes the integer grid cell a position falls in, collisions are fine since every candidate gets a real distance check
+		static uint64_t HashCell(int64_t x, int64_t y, int64_t z)
+		{
+			uint64_t hash{ static_cast<uint64_t>(x) * 0x9E3779B97F4A7C15ull };
+			hash ^= static_cast<uint64_t>(y) * 0xC2B2AE3D27D4EB4Full + (hash << 6) + (hash >> 2);
+			hash ^= static_cast<uint64_t>(z) * 0x165667B19E3779F9ull + (hash << 6) + (hash >> 2);
+			return hash;
+		}
+
+		// Spreads the lower 10 bits of value so there are 2 zero bits between each of them
+		static uint32_t ExpandBits(uint32_t value)
+		{
+			value = (value * 0x00010001u) & 0xFF0000FFu;
+			value = (value * 0x00000101u) & 0x0F00F00Fu;
+			value = (value * 0x00000011u) & 0xC30C30C3u;
+			value = (value * 0x00000005u) & 0x49249249u;
+			return value;
+		}
+
+		// 30 bit Morton code for a point inside the unit cube
+		static uint32_t MortonCode(const Vector3& normalizedPoint)
+		{
+			const uint32_t x{ static_cast<uint32_t>(std::clamp(normalizedPoint.x * 1024.f, 0.f, 1023.f)) };
+			const uint32_t y{ static_cast<uint32_t>(std::clamp(normalizedPoint.y * 1024.f, 0.f, 1023.f)) };
+			const uint32_t z{ static_cast<uint32_t>(std::clamp(normalizedPoint.z * 1024.f, 0.f, 1023.f)) };
+			return (ExpandBits(x) << 2) | (ExpandBits(y) << 1) | ExpandBits(z);
+		}
+
+		// Rays per second through HitTest_TriangleMesh: a 64 x 64 grid of parallel, slightly tilted rays across the world space AABB
+		static float MeasureHitTestThroughput(const TriangleMesh& mesh)
+		{
+			constexpr int gridSize{ 64 };
+			const Vector3 direction{ Vector3{ 0.1f, 0.2f, 1.f }.Normalized() };
+			const Vector3 extent{ mesh.transformedMaxAABB - mesh.transformedMinAABB };
+
+			HitRecord hitRecord{};
+			const auto startTime{ std::chrono::steady_clock::now() };
+			for (int y{}; y < gridSize; ++y)
+			{
+				for (int x{}; x < gridSize; ++x)
+				{
+					Ray ray{};
+					ray.origin = mesh.transformedMinAABB + Vector3{ extent.x * (x + 0.5f) / gridSize, extent.y * (y + 0.5f) / gridSize, -1.f };
+					ray.direction = direction;
+					hitRecord.t = FLT_MAX;
+					GeometryUtils::HitTest_TriangleMesh(mesh, ray, hitRecord);
+				}
+			}
+			const float seconds{ std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count() };
+			return gridSize * gridSize / std::max(seconds, 1e-9f);
+		}
+#pragma endregion
+
+		size_t WeldVertices(std::vector<Vector3>& positions, std::vector<int>& indices, std::vector<Vector3>& normals, std::vector<unsigned char>& triangleMaterials, float epsilon)
+		{
+			const size_t vertexCount{ positions.size() };
+			if (vertexCount == 0)
+				return 0;
+
+			// A cell size of 0 would divide by zero, FLT_EPSILON still only merges (near) exact duplicates
+			epsilon = std::max(epsilon, FLT_EPSILON);
+			const float invCellSize{ 1.f / epsilon };
+			const float sqrEpsilon{ Square(epsilon) };
+
+			// Grid of cells the size of epsilon, each cell keeps a linked list of the unique vertices inside of it
+			// (head index in the map, next index in cellNext) so we don't need a vector per cell
+			std::unordered_map<uint64_t, int> cellHeads{};
+			cellHeads.reserve(vertexCount);
+			std::vector<int> cellNext{};
+			cellNext.reserve(vertexCount);
+
+			std::vector<Vector3> uniquePositions{};
+			uniquePositions.reserve(vertexCount);
+			std::vector<int> remap(vertexCount);
+
+			for (size_t i{}; i < vertexCount; ++i)
+			{
+				const Vector3& p{ positions[i] };
+				const int64_t cx{ static_cast<int64_t>(floorf(p.x * invCellSize)) };
+				const int64_t cy{ static_cast<int64_t>(floorf(p.y * invCellSize)) };
+				const int64_t cz{ static_cast<int64_t>(floorf(p.z * invCellSize)) };
+
+				// Vertices within epsilon can only be in this cell or one of its 26 neighbours
+				int match{ -1 };
+				for (int64_t dx{ -1 }; dx <= 1 && match < 0; ++dx)
+				{
+					for (int64_t dy{ -1 }; dy <= 1 && match < 0; ++dy)
+					{
+						for (int64_t dz{ -1 }; dz <= 1 && match < 0; ++dz)
+						{
+							const auto it{ cellHeads.find(HashCell(cx + dx, cy + dy, cz + dz)) };
+							if (it == cellHeads.end())
+								continue;
+
+							for (int candidate{ it->second }; candidate >= 0; candidate = cellNext[candidate])
+							{
+								if ((uniquePositions[candidate] - p).SqrMagnitude() <= sqrEpsilon)
+								{
+									match = candidate;
+									break;
+								}
+							}
+						}
+					}
+				}
+
+				if (match < 0)
+				{
+					match = static_cast<int>(uniquePositions.size());
+					uniquePositions.push_back(p);
+
+					auto [it, inserted] { cellHeads.try_emplace(HashCell(cx, cy, cz), match) };
+					cellNext.push_back(inserted ? -1 : it->second);
+					it->second = match;
+				}
+
+				remap[i] = match;
+			}
+
+			// Remap the indices & drop the triangles that collapsed into a line or point
+			const bool hasNormals{ normals.size() * 3 == indices.size() };
+			const bool hasMaterials{ triangleMaterials.size() * 3 == indices.size() };
+			size_t writeTriangle{};
+			for (size_t i{}; i + 2 < indices.size(); i += 3)
+			{
+				const int i0{ remap[indices[i]] };
+				const int i1{ remap[indices[i + 1]] };
+				const int i2{ remap[indices[i + 2]] };
+				if (i0 == i1 || i1 == i2 || i0 == i2)
+					continue;
+
+				indices[writeTriangle * 3] = i0;
+				indices[writeTriangle * 3 + 1] = i1;
+				indices[writeTriangle * 3 + 2] = i2;
+				if (hasNormals)
+					normals[writeTriangle] = normals[i / 3];
+				if (hasMaterials)
+					triangleMaterials[writeTriangle] = triangleMaterials[i / 3];
+				++writeTriangle;
+			}
+			indices.resize(writeTriangle * 3);
+			if (hasNormals)
+				normals.resize(writeTriangle);
+			if (hasMaterials)
+				triangleMaterials.resize(writeTriangle);
+
+			positions = std::move(uniquePositions);
+			return vertexCount - positions.size();
+		}
+
+		void ReorderForLocality(std::vector<Vector3>& positions, std::vector<int>& indices, std::vector<Vector3>& normals, std::vector<unsigned char>& triangleMaterials)
+		{
+			const size_t triangleCount{ indices.size() / 3 };
+			if (triangleCount == 0)
+				return;
+
+			// Bounds of the mesh, used to map the centroids into the unit cube
+			Vector3 minBounds{ FLT_MAX, FLT_MAX, FLT_MAX };
+			Vector3 maxBounds{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (const Vector3& p : positions)
+			{
+				minBounds = Vector3::Min(minBounds, p);
+				maxBounds = Vector3::Max(maxBounds, p);
+			}
+			const Vector3 extent{ maxBounds - minBounds };
+			const Vector3 invExtent{
+				extent.x > 0.f ? 1.f / extent.x : 0.f,
+				extent.y > 0.f ? 1.f / extent.y : 0.f,
+				extent.z > 0.f ? 1.f / extent.z : 0.f };
+
+			std::vector<uint32_t> codes(triangleCount);
+			for (size_t t{}; t < triangleCount; ++t)
+			{
+				const Vector3 centroid{ (positions[indices[t * 3]] + positions[indices[t * 3 + 1]] + positions[indices[t * 3 + 2]]) / 3.f };
+				const Vector3 offset{ centroid - minBounds };
+				codes[t] = MortonCode({ offset.x * invExtent.x, offset.y * invExtent.y, offset.z * invExtent.z });
+			}
+
+			// Stable so meshes that are already sorted (or have equal codes) keep their order
+			std::vector<uint32_t> triangleOrder(triangleCount);
+			std::iota(triangleOrder.begin(), triangleOrder.end(), 0u);
+			std::stable_sort(triangleOrder.begin(), triangleOrder.end(), [&codes](uint32_t a, uint32_t b)
+				{
+					return codes[a] < codes[b];
+				});
+
+			// Renumber the vertices in the order the sorted triangles first use them
+			const bool hasNormals{ normals.size() == triangleCount };
+			std::vector<int> vertexRemap(positions.size(), -1);
+			std::vector<Vector3> sortedPositions{};
+			sortedPositions.reserve(positions.size());
+			std::vector<int> sortedIndices{};
+			sortedIndices.reserve(indices.size());
+			std::vector<Vector3> sortedNormals{};
+			sortedNormals.reserve(normals.size());
+			const bool hasMaterials{ triangleMaterials.size() == triangleCount };
+			std::vector<unsigned char> sortedMaterials{};
+			sortedMaterials.reserve(triangleMaterials.size());
+
+			for (const uint32_t t : triangleOrder)
+			{
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					const int oldIndex{ indices[t * 3 + corner] };
+					if (vertexRemap[oldIndex] < 0)
+					{
+						vertexRemap[oldIndex] = static_cast<int>(sortedPositions.size());
+						sortedPositions.push_back(positions[oldIndex]);
+					}
+					sortedIndices.push_back(vertexRemap[oldIndex]);
+				}
+
+				if (hasNormals)
+					sortedNormals.push_back(normals[t]);
+				if (hasMaterials)
+					sortedMaterials.push_back(triangleMaterials[t]);
+			}
+
+			// Vertices that no triangle uses are dropped here as well
+			positions = std::move(sortedPositions);
+			indices = std::move(sortedIndices);
+			if (hasNormals)
+				normals = std::move(sortedNormals);
+			if (hasMaterials)
+				triangleMaterials = std::move(sortedMaterials);
+		}
+
+		void MatchWinding(const Vector3& fileNormal, Vector3& faceNormal, int* pTriangleIndices)
+		{
+			if (Vector3::Dot(fileNormal, faceNormal) >= 0.f)
+				return;
+
+			faceNormal = -faceNormal;
+			std::swap(pTriangleIndices[1], pTriangleIndices[2]);
+		}
+
+		void MatchWinding(const std::vector<Vector3>& vertexNormals, std::vector<Vector3>& faceNormals, std::vector<int>& indices)
+		{
+			for (size_t i{}; i < faceNormals.size(); ++i)
+			{
+				int* pTriangleIndices{ indices.data() + i * 3 };
+				const Vector3 fileNormal{ vertexNormals[pTriangleIndices[0]] + vertexNormals[pTriangleIndices[1]] + vertexNormals[pTriangleIndices[2]] };
+				MatchWinding(fileNormal, faceNormals[i], pTriangleIndices);
+			}
+		}
+
+		size_t CalculateMeshMemory(size_t vertexCount, size_t triangleCount, int indexWidth)
+		{
+			// positions + transformedPositions, per face normals + transformedNormals, 3 indices per triangle
+			return vertexCount * sizeof(Vector3) * 2
+				+ triangleCount * sizeof(Vector3) * 2
+				+ triangleCount * 3 * indexWidth;
+		}
+
+		MeshOptimizationStats OptimizeMesh(TriangleMesh& mesh, float weldEpsilon, bool printStats)
+		{
+			MeshOptimizationStats stats{};
+			stats.verticesBefore = mesh.positions.size();
+			stats.trianglesBefore = mesh.indices.size() / 3;
+			stats.bytesBefore = CalculateMeshMemory(stats.verticesBefore, stats.trianglesBefore, sizeof(int));
+
+			WeldVertices(mesh.positions, mesh.indices, mesh.normals, mesh.triangleMaterials, weldEpsilon);
+			ReorderForLocality(mesh.positions, mesh.indices, mesh.normals, mesh.triangleMaterials);
+
+			stats.verticesAfter = mesh.positions.size();
+			stats.trianglesAfter = mesh.indices.size() / 3;
+			stats.bytesAfter = CalculateMeshMemory(stats.verticesAfter, stats.trianglesAfter, sizeof(int));
+
+			if (printStats)
+			{
+				std::cout << "Mesh optimized: vertices " << stats.verticesBefore << " > " << stats.verticesAfter
+					<< ", triangles " << stats.trianglesBefore << " > " << stats.trianglesAfter
+					<< ", memory " << stats.bytesBefore << "B > " << stats.bytesAfter << "B\n";
+			}
+
+			return stats;
+		}
+
+		size_t CompressMesh(TriangleMesh& mesh, bool printStats)
+		{
+			const size_t bytesBefore{ mesh.GetMemoryFootprint() };
+			// Decoding on the fly costs time per hit test, the report has both sides of the trade
+			const float raysPerSecondBefore{ printStats ? MeasureHitTestThroughput(mesh) : 0.f };
+			mesh.Compress();
+			mesh.UpdateTransforms();
+			const size_t bytesAfter{ mesh.GetMemoryFootprint() };
+
+			if (printStats)
+			{
+				const float raysPerSecondAfter{ MeasureHitTestThroughput(mesh) };
+				std::cout << "Mesh compressed: memory " << bytesBefore << "B > " << bytesAfter << "B ("
+					<< (mesh.compressed.indices16.empty() ? 32 : 16) << "-bit indices), hit tests "
+					<< raysPerSecondBefore / 1e6f << " > " << raysPerSecondAfter / 1e6f << " Mrays/s\n";
+			}
+
+			return bytesAfter;
+		}
+	}
+}
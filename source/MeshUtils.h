@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+#include "DataTypes.h"
+
+namespace dae
+{
+	namespace MeshUtils
+	{
+		struct MeshOptimizationStats
+		{
+			size_t verticesBefore{};
+			size_t verticesAfter{};
+			size_t trianglesBefore{};
+			size_t trianglesAfter{};
+
+			// Bytes used by positions, normals, indices & their transformed copies
+			size_t bytesBefore{};
+			size_t bytesAfter{};
+		};
+
+		/**
+		 * \brief Merges all vertices that lie within epsilon of each other and removes the triangles that collapse because of it
+		 * \param positions vertex positions, compacted in place
+		 * \param indices triangle indices, remapped in place
+		 * \param normals per face normals, kept in sync with removed triangles (can be empty)
+		 * \param triangleMaterials per triangle materials, kept in sync like the normals (can be empty)
+		 * \param epsilon max distance between 2 vertices to be considered the same
+		 * \return amount of vertices that were removed
+		 */
+		size_t WeldVertices(std::vector<Vector3>& positions, std::vector<int>& indices, std::vector<Vector3>& normals, std::vector<unsigned char>& triangleMaterials, float epsilon);
+
+		/**
+		 * \brief Sorts the triangles along a Morton (Z-order) curve of their centroids, then renumbers the vertices in order of first use.
+		 * Triangles that are close in space end up close in memory, which keeps the transform & hit test loops cache friendly.
+		 */
+		void ReorderForLocality(std::vector<Vector3>& positions, std::vector<int>& indices, std::vector<Vector3>& normals, std::vector<unsigned char>& triangleMaterials);
+
+		/**
+		 * \brief Turns a triangle around when its winding disagrees with the normal the file has for it: the face normal gets
+		 * negated and the 2nd & 3rd index swapped, so culling (by winding) & shading (by normal) agree on which side is the front
+		 * \param pTriangleIndices the triangle's 3 indices
+		 */
+		void MatchWinding(const Vector3& fileNormal, Vector3& faceNormal, int* pTriangleIndices);
+		// Every triangle against the file's per vertex normals (indexed like the positions)
+		void MatchWinding(const std::vector<Vector3>& vertexNormals, std::vector<Vector3>& faceNormals, std::vector<int>& indices);
+
+		// Memory used by a mesh with these counts, including the transformed copies the mesh keeps every frame
+		size_t CalculateMeshMemory(size_t vertexCount, size_t triangleCount, int indexWidth);
+
+		/**
+		 * \brief Import time optimization pass: weld & reorder. The index width gets picked by CompressMesh (16-bit when it fits).
+		 * Call this after filling positions/indices, before UpdateAABB & UpdateTransforms.
+		 */
+		MeshOptimizationStats OptimizeMesh(TriangleMesh& mesh, float weldEpsilon = 1e-5f, bool printStats = false);
+
+		/**
+		 * \brief Switches the mesh to the compressed representation (16-bit positions, octahedral normals, 16-bit indices when possible)
+		 * \param printStats also times the same rays against the mesh before & after, the hit test throughput goes next to the memory
+		 * \return memory used by the mesh afterwards, in bytes
+		 */
+		size_t CompressMesh(TriangleMesh& mesh, bool printStats = true);
+	}
+}
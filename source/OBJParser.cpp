@@ -0,0 +1,498 @@
+#include "OBJParser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <chrono>
+#include <future>
+#include <string_view>
+#include <unordered_map>
+#include <thread>
+
+#include "MappedFile.h"
+#include "MeshUtils.h"
+
+namespace dae
+{
+	namespace OBJParser
+	{
+		namespace
+		{
+			constexpr int InheritedMaterial{ -1 };
+
+			// Everything one chunk of lines produced. Negative indices can point into earlier chunks,
+			// they're stored relative to the start of this chunk and fixed up while merging
+			struct Chunk
+			{
+				std::vector<Vector3> positions{};
+				std::vector<Vector3> normals{};
+				std::vector<TexCoord> texCoords{};
+
+				std::vector<int> positionIndices{};
+				std::vector<int> texCoordIndices{};
+				std::vector<int> normalIndices{};
+
+				// Per corner, only filled once the chunk runs into its first negative index
+				std::vector<unsigned char> relativeFlags{};
+
+				// usemtl names this chunk used, per triangle an index into them. Triangles before the chunk's first usemtl
+				// continue whatever material the previous chunk ended with (InheritedMaterial)
+				std::vector<std::string> materialNames{};
+				std::vector<int> triangleMaterials{};
+				int currentMaterial{ InheritedMaterial };
+			};
+
+			enum RelativeFlag : unsigned char
+			{
+				RelativePosition = 1 << 0,
+				RelativeTexCoord = 1 << 1,
+				RelativeNormal = 1 << 2
+			};
+
+			struct Corner
+			{
+				int position{ -1 };
+				int texCoord{ -1 };
+				int normal{ -1 };
+				unsigned char relativeFlags{};
+			};
+
+			bool IsBlank(char c)
+			{
+				return c == ' ' || c == '\t' || c == '\r';
+			}
+
+			const char* SkipBlanks(const char* pCurrent, const char* pEnd)
+			{
+				while (pCurrent < pEnd && IsBlank(*pCurrent))
+					++pCurrent;
+				return pCurrent;
+			}
+
+			const char* ParseFloat(const char* pCurrent, const char* pEnd, float& value)
+			{
+				pCurrent = SkipBlanks(pCurrent, pEnd);
+				if (pCurrent < pEnd && *pCurrent == '+')
+					++pCurrent;
+
+				const auto [pNext, error] { std::from_chars(pCurrent, pEnd, value) };
+				return error == std::errc{} ? pNext : nullptr;
+			}
+
+			const char* ParseInt(const char* pCurrent, const char* pEnd, int& value)
+			{
+				const auto [pNext, error] { std::from_chars(pCurrent, pEnd, value) };
+				return error == std::errc{} ? pNext : nullptr;
+			}
+
+			// OBJ indices are 1-based, negative ones count back from the last element read so far
+			bool ResolveIndex(int index, int localCount, int& resolved, bool& isRelative)
+			{
+				if (index > 0)
+				{
+					resolved = index - 1;
+					isRelative = false;
+					return true;
+				}
+				if (index < 0)
+				{
+					resolved = localCount + index;
+					isRelative = true;
+					return true;
+				}
+				return false;
+			}
+
+			// v, v/vt, v//vn or v/vt/vn
+			const char* ParseCorner(const char* pCurrent, const char* pEnd, const Chunk& chunk, Corner& corner)
+			{
+				int index{};
+				bool isRelative{};
+				pCurrent = ParseInt(pCurrent, pEnd, index);
+				if (pCurrent == nullptr || !ResolveIndex(index, static_cast<int>(chunk.positions.size()), corner.position, isRelative))
+					return nullptr;
+				if (isRelative)
+					corner.relativeFlags |= RelativePosition;
+
+				if (pCurrent >= pEnd || *pCurrent != '/')
+					return pCurrent;
+
+				// Texture coordinate, can be left out (v//vn)
+				++pCurrent;
+				if (pCurrent < pEnd && *pCurrent != '/')
+				{
+					pCurrent = ParseInt(pCurrent, pEnd, index);
+					if (pCurrent == nullptr || !ResolveIndex(index, static_cast<int>(chunk.texCoords.size()), corner.texCoord, isRelative))
+						return nullptr;
+					if (isRelative)
+						corner.relativeFlags |= RelativeTexCoord;
+				}
+
+				if (pCurrent >= pEnd || *pCurrent != '/')
+					return pCurrent;
+
+				pCurrent = ParseInt(pCurrent + 1, pEnd, index);
+				if (pCurrent == nullptr || !ResolveIndex(index, static_cast<int>(chunk.normals.size()), corner.normal, isRelative))
+					return nullptr;
+				if (isRelative)
+					corner.relativeFlags |= RelativeNormal;
+
+				return pCurrent;
+			}
+
+			void AddCorner(Chunk& chunk, const Corner& corner)
+			{
+				if (corner.relativeFlags != 0 || !chunk.relativeFlags.empty())
+				{
+					chunk.relativeFlags.resize(chunk.positionIndices.size(), 0);
+					chunk.relativeFlags.push_back(corner.relativeFlags);
+				}
+
+				chunk.positionIndices.push_back(corner.position);
+				chunk.texCoordIndices.push_back(corner.texCoord);
+				chunk.normalIndices.push_back(corner.normal);
+			}
+
+			void ParseFace(const char* pCurrent, const char* pEnd, Chunk& chunk, std::vector<Corner>& corners)
+			{
+				corners.clear();
+				while (true)
+				{
+					pCurrent = SkipBlanks(pCurrent, pEnd);
+					if (pCurrent >= pEnd)
+						break;
+
+					Corner corner{};
+					pCurrent = ParseCorner(pCurrent, pEnd, chunk, corner);
+					// Malformed faces get dropped as a whole
+					if (pCurrent == nullptr)
+						return;
+					corners.push_back(corner);
+				}
+
+				// Polygons become a fan around the first corner
+				for (size_t i{ 2 }; i < corners.size(); ++i)
+				{
+					AddCorner(chunk, corners[0]);
+					AddCorner(chunk, corners[i - 1]);
+					AddCorner(chunk, corners[i]);
+
+					if (chunk.currentMaterial != InheritedMaterial)
+					{
+						chunk.triangleMaterials.resize(chunk.positionIndices.size() / 3 - 1, InheritedMaterial);
+						chunk.triangleMaterials.push_back(chunk.currentMaterial);
+					}
+				}
+			}
+
+			void ParseUseMaterial(const char* pCurrent, const char* pEnd, Chunk& chunk)
+			{
+				pCurrent = SkipBlanks(pCurrent, pEnd);
+				while (pEnd > pCurrent && IsBlank(pEnd[-1]))
+					--pEnd;
+
+				const std::string_view name{ pCurrent, static_cast<size_t>(pEnd - pCurrent) };
+				const auto it{ std::find(chunk.materialNames.begin(), chunk.materialNames.end(), name) };
+				chunk.currentMaterial = static_cast<int>(it - chunk.materialNames.begin());
+				if (it == chunk.materialNames.end())
+					chunk.materialNames.emplace_back(name);
+			}
+
+			void ParseChunk(const char* pBegin, const char* pEnd, Chunk& chunk)
+			{
+				// Rough guess (~30 bytes a line) so the vectors don't regrow too often
+				const size_t lineEstimate{ static_cast<size_t>(pEnd - pBegin) / 30 };
+				chunk.positions.reserve(lineEstimate / 2);
+				chunk.positionIndices.reserve(lineEstimate * 3);
+
+				std::vector<Corner> corners{};
+				corners.reserve(16);
+
+				const char* pLine{ pBegin };
+				while (pLine < pEnd)
+				{
+					const char* pLineEnd{ static_cast<const char*>(memchr(pLine, '\n', pEnd - pLine)) };
+					if (pLineEnd == nullptr)
+						pLineEnd = pEnd;
+
+					const char* pCurrent{ SkipBlanks(pLine, pLineEnd) };
+					if (pLineEnd - pCurrent >= 2)
+					{
+						const char command{ pCurrent[0] };
+						const char next{ pCurrent[1] };
+						if (command == 'v' && IsBlank(next))
+						{
+							Vector3 position{};
+							if ((pCurrent = ParseFloat(pCurrent + 1, pLineEnd, position.x)) &&
+								(pCurrent = ParseFloat(pCurrent, pLineEnd, position.y)) &&
+								(pCurrent = ParseFloat(pCurrent, pLineEnd, position.z)))
+								chunk.positions.push_back(position);
+						}
+						else if (command == 'v' && next == 'n' && pLineEnd - pCurrent > 2 && IsBlank(pCurrent[2]))
+						{
+							Vector3 normal{};
+							if ((pCurrent = ParseFloat(pCurrent + 2, pLineEnd, normal.x)) &&
+								(pCurrent = ParseFloat(pCurrent, pLineEnd, normal.y)) &&
+								(pCurrent = ParseFloat(pCurrent, pLineEnd, normal.z)))
+								chunk.normals.push_back(normal);
+						}
+						else if (command == 'v' && next == 't' && pLineEnd - pCurrent > 2 && IsBlank(pCurrent[2]))
+						{
+							// A third (w) coordinate is allowed but not used
+							TexCoord texCoord{};
+							if ((pCurrent = ParseFloat(pCurrent + 2, pLineEnd, texCoord.u)) &&
+								(pCurrent = ParseFloat(pCurrent, pLineEnd, texCoord.v)))
+								chunk.texCoords.push_back(texCoord);
+						}
+						else if (command == 'f' && IsBlank(next))
+						{
+							ParseFace(pCurrent + 1, pLineEnd, chunk, corners);
+						}
+						else if (command == 'u' && pLineEnd - pCurrent > 6 && std::string_view{ pCurrent, 6 } == "usemtl" && IsBlank(pCurrent[6]))
+						{
+							ParseUseMaterial(pCurrent + 6, pLineEnd, chunk);
+						}
+						// Comments, groups, materials, ... are skipped
+					}
+
+					pLine = pLineEnd + 1;
+				}
+			}
+
+			// How the material ids of a chunk map onto OBJData::materialNames
+			struct ChunkMaterials
+			{
+				std::vector<int> localToGlobal{};
+				int inherited{ -1 };  // material the previous chunks ended with
+			};
+
+			// Moves a chunk into its slot of the output, indices become absolute
+			bool MergeChunk(Chunk& chunk, OBJData& data, size_t positionOffset, size_t texCoordOffset, size_t normalOffset, size_t cornerOffset, const ChunkMaterials* pMaterials)
+			{
+				std::copy(chunk.positions.begin(), chunk.positions.end(), data.positions.begin() + positionOffset);
+				std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), data.texCoords.begin() + texCoordOffset);
+				std::copy(chunk.normals.begin(), chunk.normals.end(), data.normals.begin() + normalOffset);
+
+				const int positionCount{ static_cast<int>(data.positions.size()) };
+				const int texCoordCount{ static_cast<int>(data.texCoords.size()) };
+				const int normalCount{ static_cast<int>(data.normals.size()) };
+
+				bool isValid{ true };
+				const size_t cornerCount{ chunk.positionIndices.size() };
+				for (size_t i{}; i < cornerCount; ++i)
+				{
+					const unsigned char flags{ i < chunk.relativeFlags.size() ? chunk.relativeFlags[i] : static_cast<unsigned char>(0) };
+
+					int position{ chunk.positionIndices[i] };
+					int texCoord{ chunk.texCoordIndices[i] };
+					int normal{ chunk.normalIndices[i] };
+					if (flags & RelativePosition)
+						position += static_cast<int>(positionOffset);
+					if (flags & RelativeTexCoord)
+						texCoord += static_cast<int>(texCoordOffset);
+					if (flags & RelativeNormal)
+						normal += static_cast<int>(normalOffset);
+
+					isValid &= position >= 0 && position < positionCount;
+					isValid &= texCoord >= -1 && texCoord < texCoordCount && (texCoord >= 0 || !(flags & RelativeTexCoord));
+					isValid &= normal >= -1 && normal < normalCount && (normal >= 0 || !(flags & RelativeNormal));
+
+					data.positionIndices[cornerOffset + i] = position;
+					data.texCoordIndices[cornerOffset + i] = texCoord;
+					data.normalIndices[cornerOffset + i] = normal;
+				}
+
+				if (pMaterials != nullptr)
+				{
+					const size_t triangleCount{ cornerCount / 3 };
+					for (size_t i{}; i < triangleCount; ++i)
+					{
+						const int material{ i < chunk.triangleMaterials.size() ? chunk.triangleMaterials[i] : InheritedMaterial };
+						data.triangleMaterials[cornerOffset / 3 + i] = material == InheritedMaterial ? pMaterials->inherited : pMaterials->localToGlobal[material];
+					}
+				}
+
+				// Free the chunk's memory as soon as possible, it's a full copy of its part of the file
+				chunk = Chunk{};
+				return isValid;
+			}
+
+			// At least 1MB per chunk, smaller ones aren't worth a thread
+			int GetChunkCount(size_t size)
+			{
+				constexpr size_t minChunkSize{ 1 << 20 };
+				return static_cast<int>(std::clamp<size_t>(size / minChunkSize, 1, std::max(1u, std::thread::hardware_concurrency())));
+			}
+		}
+
+		bool Parse(const char* pText, size_t size, OBJData& data, int chunkCount)
+		{
+			data = OBJData{};
+
+			if (chunkCount <= 0)
+				chunkCount = GetChunkCount(size);
+
+			// Split at the first line break after every even split point
+			std::vector<const char*> boundaries{ pText };
+			for (int i{ 1 }; i < chunkCount; ++i)
+			{
+				const char* pSplit{ std::max(pText + size * i / chunkCount, boundaries.back()) };
+				const char* pLineEnd{ std::find(pSplit, pText + size, '\n') };
+				boundaries.push_back(pLineEnd == pText + size ? pLineEnd : pLineEnd + 1);
+			}
+			boundaries.push_back(pText + size);
+
+			std::vector<Chunk> chunks(chunkCount);
+			{
+				std::vector<std::future<void>> futures{};
+				futures.reserve(chunkCount);
+				for (int i{}; i < chunkCount; ++i)
+				{
+					futures.push_back(std::async(std::launch::async, [&, i] { ParseChunk(boundaries[i], boundaries[i + 1], chunks[i]); }));
+				}
+				for (std::future<void>& future : futures)
+				{
+					future.wait();
+				}
+			}
+
+			// Offsets of every chunk in the merged arrays, in file order
+			std::vector<size_t> positionOffsets(chunkCount + 1), texCoordOffsets(chunkCount + 1), normalOffsets(chunkCount + 1), cornerOffsets(chunkCount + 1);
+			for (int i{}; i < chunkCount; ++i)
+			{
+				positionOffsets[i + 1] = positionOffsets[i] + chunks[i].positions.size();
+				texCoordOffsets[i + 1] = texCoordOffsets[i] + chunks[i].texCoords.size();
+				normalOffsets[i + 1] = normalOffsets[i] + chunks[i].normals.size();
+				cornerOffsets[i + 1] = cornerOffsets[i] + chunks[i].positionIndices.size();
+			}
+
+			data.positions.resize(positionOffsets.back());
+			data.texCoords.resize(texCoordOffsets.back());
+			data.normals.resize(normalOffsets.back());
+			data.positionIndices.resize(cornerOffsets.back());
+			data.texCoordIndices.resize(cornerOffsets.back());
+			data.normalIndices.resize(cornerOffsets.back());
+
+			// Material names get merged in file order, every chunk continues with the material the one before it ended with
+			const bool hasMaterials{ std::any_of(chunks.begin(), chunks.end(), [](const Chunk& chunk) { return !chunk.materialNames.empty(); }) };
+			std::vector<ChunkMaterials> chunkMaterials(hasMaterials ? chunkCount : 0);
+			if (hasMaterials)
+			{
+				std::unordered_map<std::string, int> materialIds{};
+				int currentMaterial{ -1 };
+				for (int i{}; i < chunkCount; ++i)
+				{
+					chunkMaterials[i].inherited = currentMaterial;
+					for (const std::string& name : chunks[i].materialNames)
+					{
+						const auto [it, isNew] { materialIds.try_emplace(name, static_cast<int>(data.materialNames.size())) };
+						if (isNew)
+							data.materialNames.push_back(name);
+						chunkMaterials[i].localToGlobal.push_back(it->second);
+					}
+
+					if (chunks[i].currentMaterial != InheritedMaterial)
+						currentMaterial = chunkMaterials[i].localToGlobal[chunks[i].currentMaterial];
+				}
+				data.triangleMaterials.resize(cornerOffsets.back() / 3);
+			}
+
+			// Every chunk writes its own slice, so merging can be parallel too
+			std::vector<std::future<bool>> merges{};
+			merges.reserve(chunkCount);
+			for (int i{}; i < chunkCount; ++i)
+			{
+				merges.push_back(std::async(std::launch::async, [&, i]
+					{
+						return MergeChunk(chunks[i], data, positionOffsets[i], texCoordOffsets[i], normalOffsets[i], cornerOffsets[i], hasMaterials ? &chunkMaterials[i] : nullptr);
+					}));
+			}
+
+			bool isValid{ true };
+			for (std::future<bool>& merge : merges)
+			{
+				isValid &= merge.get();
+			}
+
+			if (!isValid)
+				data = OBJData{};
+			return isValid;
+		}
+
+		bool Parse(const std::string& filename, OBJData& data, ParseStats* pStats)
+		{
+			const auto startTime{ std::chrono::steady_clock::now() };
+
+			MappedFile file{ filename };
+			if (!file.IsOpen())
+				return false;
+
+			const int chunkCount{ GetChunkCount(file.GetSize()) };
+			const bool isValid{ Parse(file.GetData(), file.GetSize(), data, chunkCount) };
+
+			if (pStats != nullptr)
+			{
+				pStats->fileSize = file.GetSize();
+				pStats->chunkCount = chunkCount;
+				pStats->seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+			}
+			return isValid;
+		}
+
+		void ToTriangleMesh(const OBJData& data, std::vector<Vector3>& positions, std::vector<Vector3>& normals, std::vector<int>& indices)
+		{
+			const size_t firstNormal{ normals.size() };
+			const size_t firstIndex{ indices.size() };
+			const int indexOffset{ static_cast<int>(positions.size()) };
+
+			positions.insert(positions.end(), data.positions.begin(), data.positions.end());
+			indices.reserve(indices.size() + data.positionIndices.size());
+			for (int index : data.positionIndices)
+			{
+				indices.push_back(index + indexOffset);
+			}
+
+			const size_t triangleCount{ data.positionIndices.size() / 3 };
+			normals.resize(firstNormal + triangleCount);
+			for (size_t i{}; i < triangleCount; ++i)
+			{
+				const Vector3& v0{ data.positions[data.positionIndices[i * 3]] };
+				const Vector3& v1{ data.positions[data.positionIndices[i * 3 + 1]] };
+				const Vector3& v2{ data.positions[data.positionIndices[i * 3 + 2]] };
+				Vector3 normal{ Vector3::Cross(v1 - v0, v2 - v0) };
+				normal.Normalize();
+
+				Vector3 fileNormal{};
+				bool hasFileNormals{ true };
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					const int normalIndex{ data.normalIndices[i * 3 + corner] };
+					hasFileNormals &= normalIndex >= 0;
+					if (normalIndex >= 0)
+						fileNormal += data.normals[normalIndex];
+				}
+				if (hasFileNormals)
+					MeshUtils::MatchWinding(fileNormal, normal, indices.data() + firstIndex + i * 3);
+
+				normals[firstNormal + i] = normal;
+			}
+		}
+
+		void ToTriangleMesh(const OBJData& data, std::vector<Vector3>& positions, std::vector<Vector3>& normals, std::vector<int>& indices, std::vector<unsigned char>& triangleMaterials)
+		{
+			const size_t firstTriangle{ indices.size() / 3 };
+			ToTriangleMesh(data, positions, normals, indices);
+
+			if (data.triangleMaterials.empty())
+				return;
+
+			// Triangles that were already there keep slot 0
+			triangleMaterials.resize(firstTriangle, 0);
+			triangleMaterials.reserve(firstTriangle + data.triangleMaterials.size());
+			for (int material : data.triangleMaterials)
+			{
+				triangleMaterials.push_back(static_cast<unsigned char>(std::clamp(material, 0, 255)));
+			}
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	namespace OBJParser
+	{
+		struct TexCoord
+		{
+			float u{};
+			float v{};
+		};
+
+		// Everything the loader understands, faces already triangulated (fan) into 3 corners per triangle.
+		// Corner indices are 0-based, texcoord/normal indices are -1 when a corner didn't specify one
+		struct OBJData
+		{
+			std::vector<Vector3> positions{};
+			std::vector<Vector3> normals{};
+			std::vector<TexCoord> texCoords{};
+
+			std::vector<int> positionIndices{};
+			std::vector<int> texCoordIndices{};
+			std::vector<int> normalIndices{};
+
+			// usemtl names in order of first use, and per triangle an index into them (-1 before the first usemtl).
+			// Both stay empty when the file doesn't use materials
+			std::vector<std::string> materialNames{};
+			std::vector<int> triangleMaterials{};
+		};
+
+		struct ParseStats
+		{
+			size_t fileSize{};
+			int chunkCount{};
+			float seconds{};
+		};
+
+		/**
+		 * \brief Memory maps the file and parses line aligned chunks of it in parallel, the chunks get merged in file order
+		 * so the result doesn't depend on the amount of threads. Supports v/vt/vn, f with any corner syntax
+		 * (v, v/vt, v//vn, v/vt/vn), polygons, negative (relative) indices and usemtl
+		 * \param pStats timing and size info (optional)
+		 */
+		bool Parse(const std::string& filename, OBJData& data, ParseStats* pStats = nullptr);
+
+		// Parses the text directly, what Parse does after mapping the file
+		bool Parse(const char* pText, size_t size, OBJData& data, int chunkCount = 0);
+
+		/**
+		 * \brief Flattens the data to the layout TriangleMesh uses: positions, indices and a normal per triangle.
+		 * Face normals come from the positions, and get flipped when the file's vertex normals point the other way
+		 */
+		void ToTriangleMesh(const OBJData& data, std::vector<Vector3>& positions, std::vector<Vector3>& normals, std::vector<int>& indices);
+
+		// Same, plus a material slot per triangle (the index of its usemtl name, 0 before the first one). Left empty without usemtl
+		void ToTriangleMesh(const OBJData& data, std::vector<Vector3>& positions, std::vector<Vector3>& normals, std::vector<int>& indices, std::vector<unsigned char>& triangleMaterials);
+	}
+}
@@ -0,0 +1,521 @@
+#include "PLYParser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "DataTypes.h"
+#include "MeshUtils.h"
+
+namespace dae
+{
+	namespace PLYParser
+	{
+		namespace
+		{
+			constexpr size_t ReadBufferSize{ 4 * 1024 * 1024 };
+
+			enum class PropertyType : uint8_t
+			{
+				Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64, Invalid
+			};
+
+			struct Property
+			{
+				std::string name{};
+				PropertyType type{ PropertyType::Invalid };
+				bool isList{};
+				PropertyType countType{ PropertyType::Invalid };  // lists only
+				size_t offset{};                                  // in the element, fixed size elements only
+			};
+
+			struct Element
+			{
+				std::string name{};
+				size_t count{};
+				std::vector<Property> properties{};
+				size_t stride{};  // 0 when the element has a list, its size then differs per item
+
+				const Property* FindProperty(const std::string& propertyName) const
+				{
+					for (const Property& property : properties)
+					{
+						if (property.name == propertyName)
+							return &property;
+					}
+					return nullptr;
+				}
+			};
+
+			PropertyType ToPropertyType(const std::string& name)
+			{
+				if (name == "char" || name == "int8") return PropertyType::Int8;
+				if (name == "uchar" || name == "uint8") return PropertyType::UInt8;
+				if (name == "short" || name == "int16") return PropertyType::Int16;
+				if (name == "ushort" || name == "uint16") return PropertyType::UInt16;
+				if (name == "int" || name == "int32") return PropertyType::Int32;
+				if (name == "uint" || name == "uint32") return PropertyType::UInt32;
+				if (name == "float" || name == "float32") return PropertyType::Float32;
+				if (name == "double" || name == "float64") return PropertyType::Float64;
+				return PropertyType::Invalid;
+			}
+
+			size_t GetSize(PropertyType type)
+			{
+				switch (type)
+				{
+				case PropertyType::Int8:
+				case PropertyType::UInt8:
+					return 1;
+				case PropertyType::Int16:
+				case PropertyType::UInt16:
+					return 2;
+				case PropertyType::Int32:
+				case PropertyType::UInt32:
+				case PropertyType::Float32:
+					return 4;
+				case PropertyType::Float64:
+					return 8;
+				default:
+					return 0;
+				}
+			}
+
+			// The file is little endian and so is every platform we build for, values get copied as is
+			template<typename T>
+			T ReadValue(const char* pData)
+			{
+				T value{};
+				std::memcpy(&value, pData, sizeof(T));
+				return value;
+			}
+
+			double ReadAsDouble(const char* pData, PropertyType type)
+			{
+				switch (type)
+				{
+				case PropertyType::Int8: return ReadValue<int8_t>(pData);
+				case PropertyType::UInt8: return ReadValue<uint8_t>(pData);
+				case PropertyType::Int16: return ReadValue<int16_t>(pData);
+				case PropertyType::UInt16: return ReadValue<uint16_t>(pData);
+				case PropertyType::Int32: return ReadValue<int32_t>(pData);
+				case PropertyType::UInt32: return ReadValue<uint32_t>(pData);
+				case PropertyType::Float32: return ReadValue<float>(pData);
+				case PropertyType::Float64: return ReadValue<double>(pData);
+				default: return 0.0;
+				}
+			}
+
+			int64_t ReadAsInteger(const char* pData, PropertyType type)
+			{
+				switch (type)
+				{
+				case PropertyType::Int8: return ReadValue<int8_t>(pData);
+				case PropertyType::UInt8: return ReadValue<uint8_t>(pData);
+				case PropertyType::Int16: return ReadValue<int16_t>(pData);
+				case PropertyType::UInt16: return ReadValue<uint16_t>(pData);
+				case PropertyType::Int32: return ReadValue<int32_t>(pData);
+				case PropertyType::UInt32: return ReadValue<uint32_t>(pData);
+				case PropertyType::Float32: return static_cast<int64_t>(ReadValue<float>(pData));
+				case PropertyType::Float64: return static_cast<int64_t>(ReadValue<double>(pData));
+				default: return 0;
+				}
+			}
+
+			// Reads the file in big blocks, the parser asks for the amount of bytes it needs next
+			class ChunkReader final
+			{
+			public:
+				explicit ChunkReader(std::ifstream& file) :
+					m_File{ file },
+					m_Buffer(ReadBufferSize)
+				{
+				}
+
+				~ChunkReader() = default;
+
+				ChunkReader(const ChunkReader&) = delete;
+				ChunkReader(ChunkReader&&) noexcept = delete;
+				ChunkReader& operator=(const ChunkReader&) = delete;
+				ChunkReader& operator=(ChunkReader&&) noexcept = delete;
+
+				// Makes sure size bytes can be read from GetData, false at the end of the file
+				bool Ensure(size_t size)
+				{
+					if (m_End - m_Position >= size)
+						return true;
+
+					// Move the leftover to the front and fill up the rest
+					const size_t leftover{ m_End - m_Position };
+					std::memmove(m_Buffer.data(), m_Buffer.data() + m_Position, leftover);
+					m_Position = 0;
+					m_End = leftover;
+
+					if (size > m_Buffer.size())
+						m_Buffer.resize(size);
+
+					m_File.read(m_Buffer.data() + m_End, m_Buffer.size() - m_End);
+					m_End += static_cast<size_t>(m_File.gcount());
+					return m_End >= size;
+				}
+
+				// Copies size bytes to the destination, the part that isn't buffered yet goes from the file straight to the destination
+				bool Read(char* pDestination, size_t size)
+				{
+					const size_t buffered{ std::min(size, GetAvailable()) };
+					std::memcpy(pDestination, GetData(), buffered);
+					Advance(buffered);
+
+					const size_t remaining{ size - buffered };
+					if (remaining == 0)
+						return true;
+
+					m_File.read(pDestination + buffered, remaining);
+					return static_cast<size_t>(m_File.gcount()) == remaining;
+				}
+
+				const char* GetData() const { return m_Buffer.data() + m_Position; }
+				size_t GetAvailable() const { return m_End - m_Position; }
+				size_t GetBufferSize() const { return m_Buffer.capacity(); }
+				void Advance(size_t size) { m_Position += size; }
+
+			private:
+				std::ifstream& m_File;
+				std::vector<char> m_Buffer{};
+				size_t m_Position{};
+				size_t m_End{};
+			};
+
+			bool ParseHeader(std::ifstream& file, std::vector<Element>& elements)
+			{
+				std::string line{};
+				if (!std::getline(file, line) || line.compare(0, 3, "ply") != 0)
+					return false;
+
+				bool hasFormat{};
+				while (std::getline(file, line))
+				{
+					if (!line.empty() && line.back() == '\r')
+						line.pop_back();
+
+					std::istringstream stream{ line };
+					std::string keyword{};
+					stream >> keyword;
+
+					if (keyword == "end_header")
+						return hasFormat && !elements.empty();
+
+					if (keyword == "format")
+					{
+						std::string format{};
+						stream >> format;
+						if (format != "binary_little_endian")
+						{
+							std::cout << "PLY format " << format << " isn't supported, only binary_little_endian\n";
+							return false;
+						}
+						hasFormat = true;
+					}
+					else if (keyword == "element")
+					{
+						Element element{};
+						stream >> element.name >> element.count;
+						if (!stream)
+							return false;
+						elements.push_back(std::move(element));
+					}
+					else if (keyword == "property")
+					{
+						if (elements.empty())
+							return false;
+
+						Property property{};
+						std::string typeName{};
+						stream >> typeName;
+						if (typeName == "list")
+						{
+							std::string countTypeName{};
+							stream >> countTypeName >> typeName;
+							property.isList = true;
+							property.countType = ToPropertyType(countTypeName);
+							if (property.countType == PropertyType::Invalid)
+								return false;
+						}
+						property.type = ToPropertyType(typeName);
+						stream >> property.name;
+						if (!stream || property.type == PropertyType::Invalid)
+							return false;
+
+						elements.back().properties.push_back(std::move(property));
+					}
+					// comment, obj_info & unknown keywords are ignored
+				}
+				return false;
+			}
+
+			void CalculateLayouts(std::vector<Element>& elements)
+			{
+				for (Element& element : elements)
+				{
+					size_t offset{};
+					for (Property& property : element.properties)
+					{
+						if (property.isList)
+						{
+							offset = 0;
+							break;
+						}
+						property.offset = offset;
+						offset += GetSize(property.type);
+					}
+					element.stride = offset;
+				}
+			}
+
+			// Elements the parser doesn't use
+			bool SkipElement(ChunkReader& reader, const Element& element)
+			{
+				for (size_t i{}; i < element.count; ++i)
+				{
+					if (element.stride > 0)
+					{
+						if (!reader.Ensure(element.stride))
+							return false;
+						reader.Advance(element.stride);
+						continue;
+					}
+
+					for (const Property& property : element.properties)
+					{
+						size_t size{ GetSize(property.type) };
+						if (property.isList)
+						{
+							const size_t countSize{ GetSize(property.countType) };
+							if (!reader.Ensure(countSize))
+								return false;
+							size *= static_cast<size_t>(ReadAsInteger(reader.GetData(), property.countType));
+							reader.Advance(countSize);
+						}
+						if (!reader.Ensure(size))
+							return false;
+						reader.Advance(size);
+					}
+				}
+				return true;
+			}
+
+			bool ReadVertices(ChunkReader& reader, const Element& element, PLYData& data)
+			{
+				const Property* pX{ element.FindProperty("x") };
+				const Property* pY{ element.FindProperty("y") };
+				const Property* pZ{ element.FindProperty("z") };
+				if (element.stride == 0 || pX == nullptr || pY == nullptr || pZ == nullptr)
+					return false;
+
+				data.positions.resize(element.count);
+
+				// Plain xyz floats have the exact layout of Vector3, the whole block gets copied at once
+				const bool isPacked{
+					element.stride == sizeof(Vector3) &&
+					pX->type == PropertyType::Float32 && pX->offset == 0 &&
+					pY->type == PropertyType::Float32 && pY->offset == 4 &&
+					pZ->type == PropertyType::Float32 && pZ->offset == 8 };
+				if (isPacked)
+					return reader.Read(reinterpret_cast<char*>(data.positions.data()), element.count * sizeof(Vector3));
+
+				const Property* pNormalX{ element.FindProperty("nx") };
+				const Property* pNormalY{ element.FindProperty("ny") };
+				const Property* pNormalZ{ element.FindProperty("nz") };
+				const bool hasNormals{ pNormalX != nullptr && pNormalY != nullptr && pNormalZ != nullptr };
+				if (hasNormals)
+					data.normals.resize(element.count);
+
+				const Property* pRed{ element.FindProperty("red") };
+				const Property* pGreen{ element.FindProperty("green") };
+				const Property* pBlue{ element.FindProperty("blue") };
+				const bool hasColors{ pRed != nullptr && pGreen != nullptr && pBlue != nullptr };
+				if (hasColors)
+					data.colors.resize(element.count);
+
+				// 8 bit colors are 0-255, float colors are 0-1 already
+				const float colorScale{ pRed != nullptr && GetSize(pRed->type) <= 2 ? 1.f / ((1 << (8 * GetSize(pRed->type))) - 1) : 1.f };
+
+				const auto readFloat{ [](const char* pVertex, const Property* pProperty)
+					{
+						return pProperty->type == PropertyType::Float32 ?
+							ReadValue<float>(pVertex + pProperty->offset) :
+							static_cast<float>(ReadAsDouble(pVertex + pProperty->offset, pProperty->type));
+					} };
+
+				size_t vertex{};
+				while (vertex < element.count)
+				{
+					if (!reader.Ensure(element.stride))
+						return false;
+
+					// Everything that's buffered in one go
+					const size_t vertexEnd{ std::min(element.count, vertex + reader.GetAvailable() / element.stride) };
+					const char* pVertex{ reader.GetData() };
+					for (; vertex < vertexEnd; ++vertex, pVertex += element.stride)
+					{
+						data.positions[vertex] = { readFloat(pVertex, pX), readFloat(pVertex, pY), readFloat(pVertex, pZ) };
+						if (hasNormals)
+							data.normals[vertex] = { readFloat(pVertex, pNormalX), readFloat(pVertex, pNormalY), readFloat(pVertex, pNormalZ) };
+						if (hasColors)
+							data.colors[vertex] = { readFloat(pVertex, pRed) * colorScale, readFloat(pVertex, pGreen) * colorScale, readFloat(pVertex, pBlue) * colorScale };
+					}
+					reader.Advance(pVertex - reader.GetData());
+				}
+				return true;
+			}
+
+			bool ReadFaces(ChunkReader& reader, const Element& element, PLYData& data)
+			{
+				const Property* pIndices{ element.FindProperty("vertex_indices") };
+				if (pIndices == nullptr)
+					pIndices = element.FindProperty("vertex_index");
+				if (pIndices == nullptr || !pIndices->isList)
+					return false;
+
+				// Most files are triangles, this is a guess that only costs a reallocation for quads
+				data.indices.reserve(data.indices.size() + element.count * 3);
+
+				const size_t countSize{ GetSize(pIndices->countType) };
+				const size_t indexSize{ GetSize(pIndices->type) };
+				const bool isInt32{ pIndices->type == PropertyType::Int32 || pIndices->type == PropertyType::UInt32 };
+
+				int polygon[256]{};
+				for (size_t face{}; face < element.count; ++face)
+				{
+					for (const Property& property : element.properties)
+					{
+						if (!property.isList)
+						{
+							// Per face values (flags, ...) aren't used
+							const size_t size{ GetSize(property.type) };
+							if (!reader.Ensure(size))
+								return false;
+							reader.Advance(size);
+							continue;
+						}
+
+						if (!reader.Ensure(countSize))
+							return false;
+						const int64_t count{ ReadAsInteger(reader.GetData(), property.countType) };
+						reader.Advance(countSize);
+
+						const size_t listSize{ static_cast<size_t>(count) * GetSize(property.type) };
+						if (count < 0 || !reader.Ensure(listSize))
+							return false;
+
+						if (&property != pIndices)
+						{
+							reader.Advance(listSize);
+							continue;
+						}
+
+						const char* pList{ reader.GetData() };
+						if (count == 3 && isInt32)
+						{
+							const size_t first{ data.indices.size() };
+							data.indices.resize(first + 3);
+							std::memcpy(&data.indices[first], pList, 3 * sizeof(int));
+						}
+						else if (count >= 3 && count <= 256)
+						{
+							for (int64_t corner{}; corner < count; ++corner)
+							{
+								polygon[corner] = static_cast<int>(ReadAsInteger(pList + corner * indexSize, pIndices->type));
+							}
+
+							// Fan triangulation, same as the OBJ parser
+							for (int64_t corner{ 1 }; corner + 1 < count; ++corner)
+							{
+								data.indices.push_back(polygon[0]);
+								data.indices.push_back(polygon[corner]);
+								data.indices.push_back(polygon[corner + 1]);
+							}
+						}
+						// Points, lines & absurdly big polygons get dropped
+						reader.Advance(listSize);
+					}
+				}
+				return true;
+			}
+		}
+
+		bool Parse(const std::string& filename, PLYData& data, ParseStats* pStats)
+		{
+			const auto startTime{ std::chrono::steady_clock::now() };
+
+			std::ifstream file{ filename, std::ios::binary };
+			if (!file)
+				return false;
+
+			std::vector<Element> elements{};
+			if (!ParseHeader(file, elements))
+				return false;
+			CalculateLayouts(elements);
+
+			data = PLYData{};
+			ChunkReader reader{ file };
+
+			bool isValid{ true };
+			bool hasVertices{};
+			for (const Element& element : elements)
+			{
+				if (element.name == "vertex" && !hasVertices)
+				{
+					isValid = ReadVertices(reader, element, data);
+					hasVertices = true;
+				}
+				else if (element.name == "face")
+					isValid = ReadFaces(reader, element, data);
+				else
+					isValid = SkipElement(reader, element);
+
+				if (!isValid)
+					break;
+			}
+
+			// Indices straight from the file, they have to point to a vertex
+			const int vertexCount{ static_cast<int>(data.positions.size()) };
+			for (size_t i{}; isValid && i < data.indices.size(); ++i)
+			{
+				isValid = data.indices[i] >= 0 && data.indices[i] < vertexCount;
+			}
+
+			if (pStats != nullptr)
+			{
+				file.clear();
+				file.seekg(0, std::ios::end);
+				pStats->fileSize = static_cast<size_t>(file.tellg());
+				pStats->seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+				pStats->peakBytes = reader.GetBufferSize() +
+					data.positions.capacity() * sizeof(Vector3) +
+					data.normals.capacity() * sizeof(Vector3) +
+					data.colors.capacity() * sizeof(ColorRGB) +
+					data.indices.capacity() * sizeof(int);
+			}
+
+			if (!isValid)
+				data = PLYData{};
+			return isValid;
+		}
+
+		void ToTriangleMesh(PLYData& data, TriangleMesh& mesh)
+		{
+			mesh.positions = std::move(data.positions);
+			mesh.indices = std::move(data.indices);
+			mesh.triangleMaterials.clear();
+			mesh.CalculateNormals();
+
+			if (data.normals.size() == mesh.positions.size())
+				MeshUtils::MatchWinding(data.normals, mesh.normals, mesh.indices);
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	struct TriangleMesh;
+
+	namespace PLYParser
+	{
+		// Vertex attributes are per vertex, faces are already triangulated (fan) into 3 indices per triangle
+		struct PLYData
+		{
+			std::vector<Vector3> positions{};
+			std::vector<Vector3> normals{};  // nx/ny/nz, empty when the file has none
+			std::vector<ColorRGB> colors{};  // red/green/blue in [0, 1], empty when the file has none
+			std::vector<int> indices{};
+		};
+
+		struct ParseStats
+		{
+			size_t fileSize{};
+			float seconds{};
+			size_t peakBytes{};  // read buffer + capacity of the output arrays, at the end of parsing
+		};
+
+		/**
+		 * \brief Streams a binary little endian PLY: the header gets parsed once, after that the vertex and face
+		 * blocks are read in big chunks and copied into the arrays (a single memcpy per chunk when the vertices are plain xyz floats).
+		 * Elements other than vertex and face are skipped
+		 * \param pStats timing and memory info (optional)
+		 */
+		bool Parse(const std::string& filename, PLYData& data, ParseStats* pStats = nullptr);
+
+		/**
+		 * \brief Moves positions & indices into the mesh and calculates a normal per triangle,
+		 * flipped when the file's vertex normals point the other way
+		 */
+		void ToTriangleMesh(PLYData& data, TriangleMesh& mesh);
+	}
+}
@@ -0,0 +1,449 @@
+#include "PointCloud.h"
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include "DataTypes.h"
+#include "RenderStatistics.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define POINTCLOUD_SSE
+#include <emmintrin.h>
+#endif
+
+namespace dae
+{
+#pragma region Points
+	void PointCloud::Reserve(size_t count)
+	{
+		positionsX.reserve(count);
+		positionsY.reserve(count);
+		positionsZ.reserve(count);
+	}
+
+	void PointCloud::AddPoint(const Vector3& position)
+	{
+		assert(radii.empty() && "Mixing shared and per point radii");
+		positionsX.push_back(position.x);
+		positionsY.push_back(position.y);
+		positionsZ.push_back(position.z);
+	}
+
+	void PointCloud::AddPoint(const Vector3& position, float radius)
+	{
+		assert(radii.size() == positionsX.size() && "Mixing shared and per point radii");
+		positionsX.push_back(position.x);
+		positionsY.push_back(position.y);
+		positionsZ.push_back(position.z);
+		radii.push_back(radius);
+	}
+
+	size_t PointCloud::GetMemoryFootprint() const
+	{
+		return (positionsX.size() + positionsY.size() + positionsZ.size() + radii.size()) * sizeof(float)
+			+ nodes.size() * sizeof(Node);
+	}
+#pragma endregion
+
+#pragma region BVH Build
+	namespace
+	{
+		// Points get partitioned as packed copies, going through an index list misses the cache on every compare
+		struct BuildPoint
+		{
+			float position[3]{};
+			float radius{};
+		};
+
+		void FitNode(PointCloud::Node& node, const std::vector<BuildPoint>& points, uint32_t first, uint32_t count)
+		{
+			node.minX = node.minY = node.minZ = FLT_MAX;
+			node.maxX = node.maxY = node.maxZ = -FLT_MAX;
+			for (uint32_t i{ first }; i < first + count; ++i)
+			{
+				const BuildPoint& point{ points[i] };
+				node.minX = std::min(node.minX, point.position[0] - point.radius);
+				node.minY = std::min(node.minY, point.position[1] - point.radius);
+				node.minZ = std::min(node.minZ, point.position[2] - point.radius);
+				node.maxX = std::max(node.maxX, point.position[0] + point.radius);
+				node.maxY = std::max(node.maxY, point.position[1] + point.radius);
+				node.maxZ = std::max(node.maxZ, point.position[2] + point.radius);
+			}
+		}
+
+		void Subdivide(std::vector<PointCloud::Node>& nodes, std::vector<BuildPoint>& points, uint32_t nodeIndex, uint32_t first, uint32_t count)
+		{
+			FitNode(nodes[nodeIndex], points, first, count);
+
+			if (count <= PointCloud::LeafSize)
+			{
+				nodes[nodeIndex].offset = first;
+				nodes[nodeIndex].count = count;
+				return;
+			}
+
+			// Median split on the longest axis. The split is rounded up to a multiple of 4,
+			// so (nearly) every leaf fills whole SIMD groups
+			const PointCloud::Node& node{ nodes[nodeIndex] };
+			const float extents[3]{ node.maxX - node.minX, node.maxY - node.minY, node.maxZ - node.minZ };
+			const int axis{ extents[0] > extents[1] ? (extents[0] > extents[2] ? 0 : 2) : (extents[1] > extents[2] ? 1 : 2) };
+
+			const uint32_t leftCount{ (count / 2 + 3) / 4 * 4 };
+			const auto begin{ points.begin() + first };
+			std::nth_element(begin, begin + leftCount, begin + count,
+				[axis](const BuildPoint& a, const BuildPoint& b) { return a.position[axis] < b.position[axis]; });
+
+			const uint32_t leftIndex{ static_cast<uint32_t>(nodes.size()) };
+			nodes.emplace_back();
+			nodes.emplace_back();
+			nodes[nodeIndex].offset = leftIndex;
+			nodes[nodeIndex].count = 0;
+
+			Subdivide(nodes, points, leftIndex, first, leftCount);
+			Subdivide(nodes, points, leftIndex + 1, first + leftCount, count - leftCount);
+		}
+	}
+
+	void PointCloud::Build()
+	{
+		nodes.clear();
+		const uint32_t pointCount{ static_cast<uint32_t>(GetPointCount()) };
+		if (pointCount == 0)
+			return;
+
+		std::vector<BuildPoint> points(pointCount);
+		for (uint32_t i{}; i < pointCount; ++i)
+		{
+			points[i] = { { positionsX[i], positionsY[i], positionsZ[i] }, GetRadius(i) };
+		}
+
+		// Binary tree with leaves of at least 4 points, so this never reallocates (Subdivide holds on to node references)
+		nodes.reserve(2 * (pointCount / 4 + 1));
+		nodes.emplace_back();
+		Subdivide(nodes, points, 0, 0, pointCount);
+
+		// Store the points in leaf order, every leaf is a contiguous range.
+		// Rebuilding the arrays also drops whatever capacity was reserved while loading
+		std::vector<float>{}.swap(positionsX);
+		std::vector<float>{}.swap(positionsY);
+		std::vector<float>{}.swap(positionsZ);
+		const bool hasRadii{ !radii.empty() };
+		std::vector<float>{}.swap(radii);
+		Reserve(pointCount);
+		if (hasRadii)
+			radii.reserve(pointCount);
+
+		for (const BuildPoint& point : points)
+		{
+			positionsX.push_back(point.position[0]);
+			positionsY.push_back(point.position[1]);
+			positionsZ.push_back(point.position[2]);
+			if (hasRadii)
+				radii.push_back(point.radius);
+		}
+
+		const Node& root{ nodes[0] };
+		minAABB = { root.minX, root.minY, root.minZ };
+		maxAABB = { root.maxX, root.maxY, root.maxZ };
+	}
+#pragma endregion
+
+#pragma region Intersection
+	namespace
+	{
+		struct RayData
+		{
+			float originX, originY, originZ;
+			float directionX, directionY, directionZ;
+			float invDirectionX, invDirectionY, invDirectionZ;
+		};
+
+		bool SlabTest(const PointCloud::Node& node, const RayData& ray, float tMin, float tMax, float& tNear)
+		{
+			RENDER_STAT(SlabTests);
+			const float tx1{ (node.minX - ray.originX) * ray.invDirectionX };
+			const float tx2{ (node.maxX - ray.originX) * ray.invDirectionX };
+			const float ty1{ (node.minY - ray.originY) * ray.invDirectionY };
+			const float ty2{ (node.maxY - ray.originY) * ray.invDirectionY };
+			const float tz1{ (node.minZ - ray.originZ) * ray.invDirectionZ };
+			const float tz2{ (node.maxZ - ray.originZ) * ray.invDirectionZ };
+
+			tNear = std::max({ std::min(tx1, tx2), std::min(ty1, ty2), std::min(tz1, tz2), tMin });
+			const float tFar{ std::min({ std::max(tx1, tx2), std::max(ty1, ty2), std::max(tz1, tz2), tMax }) };
+			return tNear <= tFar;
+		}
+
+		// Same math as HitTest_Sphere (geometric, normalized direction, entering hit only)
+		bool IntersectPoint(const PointCloud& cloud, uint32_t index, const RayData& ray, float tMin, float tMax, float& t)
+		{
+			const float tcX{ cloud.positionsX[index] - ray.originX };
+			const float tcY{ cloud.positionsY[index] - ray.originY };
+			const float tcZ{ cloud.positionsZ[index] - ray.originZ };
+			const float dp{ tcX * ray.directionX + tcY * ray.directionY + tcZ * ray.directionZ };
+			const float odSqr{ tcX * tcX + tcY * tcY + tcZ * tcZ - dp * dp };
+			const float radiusSqr{ Square(cloud.GetRadius(index)) };
+			if (odSqr > radiusSqr)
+				return false;
+
+			t = dp - sqrtf(radiusSqr - odSqr);
+			return t >= tMin && t <= tMax;
+		}
+
+		// Tests the points of a leaf, shrinks tMax to the closest hit
+		bool IntersectLeaf(const PointCloud& cloud, const PointCloud::Node& leaf, const RayData& ray, float tMin, float& tMax, uint32_t& hitIndex)
+		{
+			bool didHit{ false };
+			uint32_t i{ leaf.offset };
+			const uint32_t end{ leaf.offset + leaf.count };
+
+#ifdef POINTCLOUD_SSE
+			const __m128 originX{ _mm_set1_ps(ray.originX) };
+			const __m128 originY{ _mm_set1_ps(ray.originY) };
+			const __m128 originZ{ _mm_set1_ps(ray.originZ) };
+			const __m128 directionX{ _mm_set1_ps(ray.directionX) };
+			const __m128 directionY{ _mm_set1_ps(ray.directionY) };
+			const __m128 directionZ{ _mm_set1_ps(ray.directionZ) };
+			const __m128 minT{ _mm_set1_ps(tMin) };
+			const __m128 sharedRadiusSqr{ _mm_set1_ps(Square(cloud.sharedRadius)) };
+
+			for (; i + 4 <= end; i += 4)
+			{
+				const __m128 tcX{ _mm_sub_ps(_mm_loadu_ps(&cloud.positionsX[i]), originX) };
+				const __m128 tcY{ _mm_sub_ps(_mm_loadu_ps(&cloud.positionsY[i]), originY) };
+				const __m128 tcZ{ _mm_sub_ps(_mm_loadu_ps(&cloud.positionsZ[i]), originZ) };
+				const __m128 dp{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(tcX, directionX), _mm_mul_ps(tcY, directionY)), _mm_mul_ps(tcZ, directionZ)) };
+				const __m128 tcSqr{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(tcX, tcX), _mm_mul_ps(tcY, tcY)), _mm_mul_ps(tcZ, tcZ)) };
+				const __m128 odSqr{ _mm_sub_ps(tcSqr, _mm_mul_ps(dp, dp)) };
+
+				__m128 radiusSqr{ sharedRadiusSqr };
+				if (!cloud.radii.empty())
+				{
+					const __m128 radius{ _mm_loadu_ps(&cloud.radii[i]) };
+					radiusSqr = _mm_mul_ps(radius, radius);
+				}
+
+				const __m128 discriminant{ _mm_sub_ps(radiusSqr, odSqr) };
+				const __m128 t{ _mm_sub_ps(dp, _mm_sqrt_ps(_mm_max_ps(discriminant, _mm_setzero_ps()))) };
+				const __m128 hitMask{ _mm_and_ps(_mm_cmpge_ps(discriminant, _mm_setzero_ps()),
+					_mm_and_ps(_mm_cmpge_ps(t, minT), _mm_cmple_ps(t, _mm_set1_ps(tMax)))) };
+
+				int mask{ _mm_movemask_ps(hitMask) };
+				if (mask == 0)
+					continue;
+
+				alignas(16) float lanes[4];
+				_mm_store_ps(lanes, t);
+				while (mask != 0)
+				{
+					const int lane{ mask & 1 ? 0 : mask & 2 ? 1 : mask & 4 ? 2 : 3 };
+					mask &= mask - 1;
+					if (lanes[lane] <= tMax)
+					{
+						tMax = lanes[lane];
+						hitIndex = i + lane;
+						didHit = true;
+					}
+				}
+			}
+#endif
+			// Remainder (or everything without SSE)
+			for (; i < end; ++i)
+			{
+				float t{};
+				if (IntersectPoint(cloud, i, ray, tMin, tMax, t))
+				{
+					tMax = t;
+					hitIndex = i;
+					didHit = true;
+				}
+			}
+
+			return didHit;
+		}
+	}
+
+	bool PointCloud::Intersect(const Ray& ray, float& t, uint32_t& hitIndex, bool anyHit) const
+	{
+		if (nodes.empty())
+			return false;
+
+		const RayData rayData{
+			ray.origin.x, ray.origin.y, ray.origin.z,
+			ray.direction.x, ray.direction.y, ray.direction.z,
+			1.f / ray.direction.x, 1.f / ray.direction.y, 1.f / ray.direction.z };
+
+		float closestT{ ray.max };
+		bool didHit{ false };
+
+		float tNear{};
+		if (!SlabTest(nodes[0], rayData, ray.min, closestT, tNear))
+			return false;
+
+		uint32_t stack[64]{};
+		int stackSize{};
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const Node& node{ nodes[stack[--stackSize]] };
+
+			if (node.count > 0)
+			{
+				if (IntersectLeaf(*this, node, rayData, ray.min, closestT, hitIndex))
+				{
+					didHit = true;
+					if (anyHit)
+						break;
+				}
+				continue;
+			}
+
+			// Children get tested here, so only nodes the ray actually enters end up on the stack
+			float tLeft{}, tRight{};
+			const bool hitLeft{ SlabTest(nodes[node.offset], rayData, ray.min, closestT, tLeft) };
+			const bool hitRight{ SlabTest(nodes[node.offset + 1], rayData, ray.min, closestT, tRight) };
+
+			// Nearest child goes on top
+			if (hitLeft && hitRight)
+			{
+				const bool leftFirst{ tLeft <= tRight };
+				stack[stackSize++] = leftFirst ? node.offset + 1 : node.offset;
+				stack[stackSize++] = leftFirst ? node.offset : node.offset + 1;
+			}
+			else if (hitLeft)
+			{
+				stack[stackSize++] = node.offset;
+			}
+			else if (hitRight)
+			{
+				stack[stackSize++] = node.offset + 1;
+			}
+		}
+
+		if (didHit)
+			t = closestT;
+		return didHit;
+	}
+#pragma endregion
+
+#pragma region Loading
+	namespace PointCloudUtils
+	{
+		namespace
+		{
+			bool IsSeparator(char c)
+			{
+				return c == ' ' || c == '\t' || c == ',' || c == '\r';
+			}
+
+			// Parses up to 4 floats from a line, returns how many were found
+			int ParseLine(const char* pBegin, const char* pEnd, float (&values)[4])
+			{
+				int count{};
+				const char* pCurrent{ pBegin };
+				while (count < 4)
+				{
+					while (pCurrent < pEnd && IsSeparator(*pCurrent))
+						++pCurrent;
+					if (pCurrent >= pEnd)
+						break;
+
+					const auto [pNext, error] { std::from_chars(pCurrent, pEnd, values[count]) };
+					if (error != std::errc{})
+						break;
+
+					++count;
+					pCurrent = pNext;
+				}
+				return count;
+			}
+		}
+
+		bool LoadPointCloud(const std::string& filename, PointCloud& pointCloud, bool printStats)
+		{
+			std::ifstream file{ filename, std::ios::binary };
+			if (!file)
+				return false;
+
+			const auto startTime{ std::chrono::steady_clock::now() };
+
+			// Guess the point count from the file size (~30 bytes per line) to avoid regrowing 10M+ element arrays
+			file.seekg(0, std::ios::end);
+			const size_t fileSize{ static_cast<size_t>(file.tellg()) };
+			file.seekg(0, std::ios::beg);
+			pointCloud.Reserve(pointCloud.GetPointCount() + fileSize / 30);
+
+			constexpr size_t chunkSize{ 1 << 20 };
+			std::vector<char> buffer(chunkSize);
+			size_t carry{};  // bytes of an incomplete line, moved to the start of the buffer
+			int valuesPerLine{ -1 };
+
+			while (file)
+			{
+				file.read(buffer.data() + carry, buffer.size() - carry);
+				const size_t bytesRead{ static_cast<size_t>(file.gcount()) };
+				const size_t available{ carry + bytesRead };
+				if (available == 0)
+					break;
+
+				const char* pLine{ buffer.data() };
+				const char* const pEnd{ buffer.data() + available };
+				const bool isLastChunk{ !file };
+				while (pLine < pEnd)
+				{
+					const char* pLineEnd{ std::find(pLine, pEnd, '\n') };
+					if (pLineEnd == pEnd && !isLastChunk)
+						break;
+
+					float values[4]{};
+					if (*pLine != '#')
+					{
+						const int count{ ParseLine(pLine, pLineEnd, values) };
+						if (valuesPerLine < 0 && count >= 3)
+						{
+							// The first point decides whether the file has radii
+							valuesPerLine = count;
+							if (count == 4)
+								pointCloud.radii.reserve(pointCloud.positionsX.capacity());
+						}
+
+						if (count >= 3)
+						{
+							if (valuesPerLine == 4)
+								pointCloud.AddPoint({ values[0], values[1], values[2] }, count == 4 ? values[3] : pointCloud.sharedRadius);
+							else
+								pointCloud.AddPoint({ values[0], values[1], values[2] });
+						}
+					}
+
+					pLine = pLineEnd + 1;
+				}
+
+				carry = pLine < pEnd ? static_cast<size_t>(pEnd - pLine) : 0;
+				if (carry > 0)
+				{
+					// A single line longer than the buffer can't be a point
+					if (carry == buffer.size())
+						return false;
+					std::copy(pLine, pEnd, buffer.data());
+				}
+			}
+
+			pointCloud.Build();
+
+			if (printStats)
+			{
+				const float seconds{ std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count() };
+				std::cout << "Point cloud loaded: " << pointCloud.GetPointCount() << " points, "
+					<< pointCloud.GetMemoryFootprint() / (1024 * 1024) << "MB, " << pointCloud.nodes.size() << " nodes in "
+					<< seconds << "s (" << fileSize / (1024.f * 1024.f) / seconds << " MB/s)\n";
+			}
+			return true;
+		}
+	}
+#pragma endregion
+}
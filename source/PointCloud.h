@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	struct Ray;
+
+	// Millions of spheres (scans, particles) in one primitive.
+	// Positions and radii are kept as separate arrays (SoA) so leaves can be tested 4 points at a time,
+	// and when every point has the same size no per point radius is stored at all.
+	struct PointCloud
+	{
+		// Max points per BVH leaf
+		static constexpr uint32_t LeafSize{ 8 };
+
+		// 32 bytes, two nodes per cache line
+		struct Node
+		{
+			float minX{}, minY{}, minZ{};
+			float maxX{}, maxY{}, maxZ{};
+			uint32_t offset{};  // first point (leaf) or index of the left child, the right one follows it (interior)
+			uint32_t count{};   // amount of points, 0 for interior nodes
+		};
+
+		std::vector<float> positionsX{};
+		std::vector<float> positionsY{};
+		std::vector<float> positionsZ{};
+		std::vector<float> radii{};  // empty when all points use sharedRadius
+		float sharedRadius{ 0.05f };
+
+		std::vector<Node> nodes{};
+
+		Vector3 minAABB{};
+		Vector3 maxAABB{};
+
+		unsigned char materialIndex{ 0 };
+
+		void Reserve(size_t count);
+		void AddPoint(const Vector3& position);
+		void AddPoint(const Vector3& position, float radius);
+
+		size_t GetPointCount() const { return positionsX.size(); }
+		float GetRadius(uint32_t index) const { return radii.empty() ? sharedRadius : radii[index]; }
+
+		// Reorders the points and builds the BVH, has to be called after adding points
+		void Build();
+
+		/**
+		 * \brief Closest (or any) hit with the spheres, only the entering intersection like HitTest_Sphere
+		 * \param t hit distance (out)
+		 * \param hitIndex index of the point that was hit (out)
+		 * \param anyHit stop at the first hit (shadow rays)
+		 */
+		bool Intersect(const Ray& ray, float& t, uint32_t& hitIndex, bool anyHit = false) const;
+
+		size_t GetMemoryFootprint() const;
+	};
+
+	namespace PointCloudUtils
+	{
+		// Text file with one point per line: "x y z" or "x y z radius" (lines starting with # are skipped).
+		// Read in fixed size chunks, so the file never has to fit in memory next to the points.
+		bool LoadPointCloud(const std::string& filename, PointCloud& pointCloud, bool printStats = true);
+	}
+}
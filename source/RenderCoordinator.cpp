@@ -0,0 +1,352 @@
+#include "RenderCoordinator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace dae
+{
+	namespace
+	{
+		// Answers from a worker: header lines with a block of bytes after each
+		class SocketReader final
+		{
+		public:
+			explicit SocketReader(Socket& socket) :
+				m_Socket{ socket },
+				m_Buffer(64 * 1024)
+			{
+			}
+
+			bool ReadLine(std::string& line)
+			{
+				while (true)
+				{
+					const auto lineEnd{ std::find(m_Buffer.begin() + m_Start, m_Buffer.begin() + m_End, '\n') };
+					if (lineEnd != m_Buffer.begin() + m_End)
+					{
+						line.assign(m_Buffer.begin() + m_Start, lineEnd);
+						m_Start = lineEnd - m_Buffer.begin() + 1;
+						return true;
+					}
+					if (!Fill())
+						return false;
+				}
+			}
+
+			bool ReadBytes(uint8_t* pData, size_t size)
+			{
+				const size_t bufferedSize{ std::min(size, m_End - m_Start) };
+				std::copy(m_Buffer.begin() + m_Start, m_Buffer.begin() + m_Start + bufferedSize, pData);
+				m_Start += bufferedSize;
+
+				// The rest straight from the socket
+				for (size_t position{ bufferedSize }; position < size;)
+				{
+					const int64_t receivedSize{ m_Socket.Receive(pData + position, size - position) };
+					if (receivedSize <= 0)
+						return false;
+					position += static_cast<size_t>(receivedSize);
+				}
+				return true;
+			}
+
+		private:
+			Socket& m_Socket;
+			std::vector<char> m_Buffer;
+			size_t m_Start{};
+			size_t m_End{};
+
+			bool Fill()
+			{
+				if (m_Start > 0)
+				{
+					std::copy(m_Buffer.begin() + m_Start, m_Buffer.begin() + m_End, m_Buffer.begin());
+					m_End -= m_Start;
+					m_Start = 0;
+				}
+				if (m_End == m_Buffer.size())
+					return false;  // a line that doesn't fit isn't an answer
+
+				const int64_t receivedSize{ m_Socket.Receive(m_Buffer.data() + m_End, m_Buffer.size() - m_End) };
+				if (receivedSize <= 0)
+					return false;
+				m_End += static_cast<size_t>(receivedSize);
+				return true;
+			}
+		};
+	}
+
+	RenderCoordinator::RenderCoordinator(uint32_t width, uint32_t height, uint32_t tileSize) :
+		m_Width{ width },
+		m_Height{ height },
+		m_TileSize{ std::max(1u, tileSize) },
+		m_Pixels(size_t(width) * height)
+	{
+		for (uint32_t y{}; y < height; y += m_TileSize)
+		{
+			for (uint32_t x{}; x < width; x += m_TileSize)
+			{
+				Tile tile{};
+				tile.x = x;
+				tile.y = y;
+				tile.width = std::min(m_TileSize, width - x);
+				tile.height = std::min(m_TileSize, height - y);
+				m_Tiles.push_back(tile);
+			}
+		}
+	}
+
+	RenderCoordinator::~RenderCoordinator()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+			m_WorkAvailable.notify_all();
+		}
+
+		// Wakes up the threads that wait for an answer
+		for (const std::unique_ptr<Worker>& pWorker : m_Workers)
+		{
+			pWorker->socket.Shutdown();
+			pWorker->thread.join();
+		}
+	}
+
+	bool RenderCoordinator::Connect(const std::vector<Endpoint>& endpoints)
+	{
+		for (const Endpoint& endpoint : endpoints)
+		{
+			if (m_Workers.size() == MaxWorkerCount)
+			{
+				std::cout << "Only the first " << MaxWorkerCount << " workers are used\n";
+				break;
+			}
+
+			std::unique_ptr<Worker> pWorker{ std::make_unique<Worker>() };
+			pWorker->endpoint = endpoint;
+			if (pWorker->socket.Connect(endpoint.host, endpoint.port))
+				m_Workers.push_back(std::move(pWorker));
+			else
+				std::cout << "Couldn't connect to worker " << endpoint.host << ":" << endpoint.port << "\n";
+		}
+
+		for (uint32_t i{}; i < m_Workers.size(); ++i)
+		{
+			m_Workers[i]->thread = std::thread{ [this, i] { RunWorker(i); } };
+		}
+		return !m_Workers.empty();
+	}
+
+	bool RenderCoordinator::RenderFrame(const std::string& options, uint32_t workerCount)
+	{
+		std::unique_lock lock{ m_Mutex };
+		++m_FrameIndex;
+		m_Options = options;
+		m_ActiveWorkerCount = workerCount == 0 ? GetWorkerCount() : std::min(workerCount, GetWorkerCount());
+		for (Tile& tile : m_Tiles)
+		{
+			tile.isDone = false;
+			tile.copyCount = 0;
+			tile.workerMask = 0;
+		}
+		m_PendingTiles.clear();
+		for (uint32_t i{}; i < m_Tiles.size(); ++i)
+		{
+			m_PendingTiles.push_back(i);
+		}
+		m_DoneCount = 0;
+		m_TileSeconds = 0.0;
+		for (const std::unique_ptr<Worker>& pWorker : m_Workers)
+		{
+			pWorker->tileCount = 0;
+		}
+		m_WorkAvailable.notify_all();
+
+		m_FrameChanged.wait(lock, [this] { return m_DoneCount == m_Tiles.size() || IsFrameStuck(); });
+		const bool isComplete{ m_DoneCount == m_Tiles.size() };
+
+		// Copies that are still out get thrown away when they arrive
+		m_ActiveWorkerCount = 0;
+		m_PendingTiles.clear();
+		return isComplete;
+	}
+
+	std::vector<uint32_t> RenderCoordinator::GetTilesPerWorker() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		std::vector<uint32_t> tileCounts{};
+		for (const std::unique_ptr<Worker>& pWorker : m_Workers)
+		{
+			tileCounts.push_back(pWorker->tileCount);
+		}
+		return tileCounts;
+	}
+
+	uint64_t RenderCoordinator::GetReassignedCount() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return m_ReassignedCount;
+	}
+
+	void RenderCoordinator::RunWorker(uint32_t workerIndex)
+	{
+		Worker& worker{ *m_Workers[workerIndex] };
+		SocketReader reader{ worker.socket };
+		std::deque<Request> requests{};
+		std::string line{};
+		std::vector<uint8_t> rgb{};
+
+		std::unique_lock lock{ m_Mutex };
+		while (!m_IsStopping)
+		{
+			// Keep the worker busy: the next tiles wait in its queue while it renders this one
+			uint32_t tileIndex{};
+			if (requests.size() < PipelineDepth && TakeTile(workerIndex, tileIndex))
+			{
+				const Tile& tile{ m_Tiles[tileIndex] };
+				char request[128];
+				std::snprintf(request, sizeof(request), "render id=%llu.%u size=%ux%u region=%u,%u,%ux%u format=rgb ",
+					static_cast<unsigned long long>(m_FrameIndex), tileIndex, m_Width, m_Height, tile.x, tile.y, m_TileSize, m_TileSize);
+				const std::string message{ request + m_Options + "\n" };
+				requests.push_back({ m_FrameIndex, tileIndex });
+
+				lock.unlock();
+				const bool isSent{ worker.socket.SendAll(message.data(), message.size()) };
+				lock.lock();
+				if (!isSent)
+				{
+					Disconnect(workerIndex, requests);
+					return;
+				}
+				continue;
+			}
+
+			// Nothing to answer: wait for a frame, or until one of its tiles is late enough for a backup copy
+			if (requests.empty())
+			{
+				m_WorkAvailable.wait_for(lock, std::chrono::milliseconds(20));
+				continue;
+			}
+
+			lock.unlock();
+			unsigned long long frameIndex{};
+			uint32_t answeredTile{};
+			uint32_t width{};
+			uint32_t height{};
+			size_t byteCount{};
+			bool isAnswered{ reader.ReadLine(line)
+				&& std::sscanf(line.c_str(), "frame %llu.%u rgb %u %u %zu", &frameIndex, &answeredTile, &width, &height, &byteCount) == 5
+				&& frameIndex == requests.front().frameIndex && answeredTile == requests.front().tileIndex
+				&& width == m_TileSize && height == m_TileSize && byteCount == size_t(width) * height * 3 };
+			if (isAnswered)
+			{
+				rgb.resize(byteCount);
+				isAnswered = reader.ReadBytes(rgb.data(), rgb.size());
+			}
+			lock.lock();
+
+			if (!isAnswered)
+			{
+				if (!m_IsStopping)
+					std::cout << "Lost worker " << worker.endpoint.host << ":" << worker.endpoint.port << (line.rfind("error", 0) == 0 ? ", " + line : "") << "\n";
+				Disconnect(workerIndex, requests);
+				return;
+			}
+			requests.pop_front();
+
+			// Stale answers (an earlier frame, or a copy that came in second) are dropped
+			Tile& tile{ m_Tiles[answeredTile] };
+			if (frameIndex != m_FrameIndex || tile.isDone)
+				continue;
+
+			CopyTile(tile, rgb);
+			tile.isDone = true;
+			m_TileSeconds += std::chrono::duration<double>(Clock::now() - tile.sendTime).count();
+			++worker.tileCount;
+			if (++m_DoneCount == m_Tiles.size())
+				m_FrameChanged.notify_all();
+		}
+	}
+
+	bool RenderCoordinator::TakeTile(uint32_t workerIndex, uint32_t& tileIndex)
+	{
+		if (workerIndex >= m_ActiveWorkerCount)
+			return false;
+
+		const uint64_t workerBit{ uint64_t{ 1 } << workerIndex };
+		const Clock::time_point now{ Clock::now() };
+		const auto handOut{ [&](uint32_t index)
+			{
+				Tile& tile{ m_Tiles[index] };
+				if (tile.copyCount++ > 0)
+					++m_ReassignedCount;
+				tile.workerMask |= workerBit;
+				tile.sendTime = now;
+				tileIndex = index;
+				return true;
+			} };
+
+		while (!m_PendingTiles.empty())
+		{
+			const uint32_t index{ m_PendingTiles.front() };
+			m_PendingTiles.pop_front();
+			if (!m_Tiles[index].isDone && (m_Tiles[index].workerMask & workerBit) == 0)
+				return handOut(index);
+		}
+
+		// Backup copy of the tile that's out the longest, if it's late. Before any tile is in there's nothing to compare with
+		if (m_DoneCount == 0)
+			return false;
+
+		const double lateSeconds{ BackupDelayFactor * m_TileSeconds / m_DoneCount };
+		uint32_t oldestIndex{ UINT32_MAX };
+		for (uint32_t i{}; i < m_Tiles.size(); ++i)
+		{
+			const Tile& tile{ m_Tiles[i] };
+			if (!tile.isDone && tile.copyCount < MaxTileCopies && (tile.workerMask & workerBit) == 0
+				&& std::chrono::duration<double>(now - tile.sendTime).count() > lateSeconds
+				&& (oldestIndex == UINT32_MAX || tile.sendTime < m_Tiles[oldestIndex].sendTime))
+				oldestIndex = i;
+		}
+		return oldestIndex != UINT32_MAX && handOut(oldestIndex);
+	}
+
+	void RenderCoordinator::Disconnect(uint32_t workerIndex, const std::deque<Request>& requests)
+	{
+		m_Workers[workerIndex]->isConnected = false;
+		for (const Request& request : requests)
+		{
+			if (request.frameIndex == m_FrameIndex && !m_Tiles[request.tileIndex].isDone)
+				m_PendingTiles.push_front(request.tileIndex);
+		}
+		m_WorkAvailable.notify_all();
+		m_FrameChanged.notify_all();
+	}
+
+	void RenderCoordinator::CopyTile(const Tile& tile, const std::vector<uint8_t>& rgb)
+	{
+		// The answer is always a full tile, border tiles only use part of it
+		const FrameWriter::PixelLayout layout{};
+		for (uint32_t y{}; y < tile.height; ++y)
+		{
+			const uint8_t* pSource{ rgb.data() + size_t(y) * m_TileSize * 3 };
+			uint32_t* pDestination{ m_Pixels.data() + size_t(tile.y + y) * m_Width + tile.x };
+			for (uint32_t x{}; x < tile.width; ++x)
+			{
+				pDestination[x] = uint32_t{ pSource[x * 3] } << layout.redShift | uint32_t{ pSource[x * 3 + 1] } << layout.greenShift
+					| uint32_t{ pSource[x * 3 + 2] } << layout.blueShift;
+			}
+		}
+	}
+
+	bool RenderCoordinator::IsFrameStuck() const
+	{
+		for (uint32_t i{}; i < m_ActiveWorkerCount; ++i)
+		{
+			if (m_Workers[i]->isConnected)
+				return false;
+		}
+		return true;
+	}
+}
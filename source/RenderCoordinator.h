@@ -0,0 +1,132 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameWriter.h"
+#include "Socket.h"
+
+namespace dae
+{
+	// Spreads frames over render server processes (RayTracer <scene> --server <port>), every one with the same scene loaded.
+	// A frame is cut in tiles that the workers take as soon as they have room, a few at a time so they never wait for the network.
+	// When a worker's connection breaks its tiles go back in the queue. Once nothing is left to hand out, idle workers get a copy
+	// of tiles that have been out much longer than a tile usually takes, so one slow (or stuck) worker doesn't hold up the frame:
+	// whichever copy arrives first counts
+	class RenderCoordinator final
+	{
+	public:
+		struct Endpoint
+		{
+			std::string host{};
+			uint16_t port{};
+		};
+
+		// Tiles are tileSize x tileSize, the ones at the right & bottom edge get cropped
+		RenderCoordinator(uint32_t width, uint32_t height, uint32_t tileSize = 64);
+		// Disconnects from every worker
+		~RenderCoordinator();
+
+		RenderCoordinator(const RenderCoordinator&) = delete;
+		RenderCoordinator(RenderCoordinator&&) noexcept = delete;
+		RenderCoordinator& operator=(const RenderCoordinator&) = delete;
+		RenderCoordinator& operator=(RenderCoordinator&&) noexcept = delete;
+
+		// Connects to the workers that answer, false if none did
+		bool Connect(const std::vector<Endpoint>& endpoints);
+
+		/**
+		 * \brief Renders one frame on the workers and blocks until every tile is in
+		 * \param options added to every tile's request, e.g. "time=0.5 shadows=off" (see RenderServer.h)
+		 * \param workerCount uses only the first workerCount workers, 0 = all of them
+		 * \return false when every worker that was used is gone before the frame is complete
+		 */
+		bool RenderFrame(const std::string& options, uint32_t workerCount = 0);
+
+		// The last frame, width * height pixels in the default PixelLayout
+		const std::vector<uint32_t>& GetPixels() const { return m_Pixels; }
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+
+		uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+		// Tiles each worker delivered for the last frame (copies that arrived second don't count)
+		std::vector<uint32_t> GetTilesPerWorker() const;
+		// Tiles that were handed out more than once since the start, for broken connections & stragglers
+		uint64_t GetReassignedCount() const;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		// Tiles a worker has requested at once, the next ones are queued on its side while it renders
+		static constexpr uint32_t PipelineDepth{ 3 };
+		// A tile gets a backup copy when it's out this many times longer than the average tile
+		static constexpr float BackupDelayFactor{ 3.f };
+		static constexpr uint32_t MaxTileCopies{ 3 };
+		static constexpr size_t MaxWorkerCount{ 64 };  // bits in Tile::workerMask
+
+		struct Tile
+		{
+			uint32_t x{};
+			uint32_t y{};
+			uint32_t width{};
+			uint32_t height{};
+			bool isDone{};
+			uint32_t copyCount{};   // times it got handed out this frame
+			uint64_t workerMask{};  // workers that have (had) it
+			Clock::time_point sendTime{};
+		};
+
+		// A tile request a worker hasn't answered yet
+		struct Request
+		{
+			uint64_t frameIndex{};
+			uint32_t tileIndex{};
+		};
+
+		struct Worker
+		{
+			Endpoint endpoint{};
+			Socket socket{};
+			std::thread thread{};
+			bool isConnected{ true };
+			uint32_t tileCount{};
+		};
+
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		uint32_t m_TileSize{};
+		std::vector<uint32_t> m_Pixels{};
+
+		std::vector<std::unique_ptr<Worker>> m_Workers{};
+
+		// The current frame, everything below is guarded by m_Mutex
+		std::vector<Tile> m_Tiles{};
+		std::deque<uint32_t> m_PendingTiles{};
+		uint32_t m_DoneCount{};
+		uint64_t m_FrameIndex{};
+		std::string m_Options{};
+		uint32_t m_ActiveWorkerCount{};
+		uint64_t m_ReassignedCount{};
+		double m_TileSeconds{};  // send to receive, summed over the tiles of this frame
+		bool m_IsStopping{};
+
+		mutable std::mutex m_Mutex{};
+		std::condition_variable m_WorkAvailable{};
+		std::condition_variable m_FrameChanged{};
+
+		void RunWorker(uint32_t workerIndex);
+		// Next tile for this worker in the current frame, false if there's nothing it could do (yet)
+		bool TakeTile(uint32_t workerIndex, uint32_t& tileIndex);
+		// Puts the unfinished tiles of a worker that's gone back in the queue
+		void Disconnect(uint32_t workerIndex, const std::deque<Request>& requests);
+		void CopyTile(const Tile& tile, const std::vector<uint8_t>& rgb);
+		// No worker of this frame is connected anymore
+		bool IsFrameStuck() const;
+	};
+}
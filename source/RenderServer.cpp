@@ -0,0 +1,382 @@
+#include "RenderServer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+#include "RenderTarget.h"
+#include "Scene.h"
+
+namespace dae
+{
+	namespace
+	{
+		constexpr uint32_t MaxImageSize{ 8192 };
+		// A client that sends this much without a newline isn't speaking the protocol
+		constexpr size_t MaxLineLength{ 4096 };
+		constexpr size_t MaxIdLength{ 64 };
+
+		bool ParseFloat(const std::string& value, float& result)
+		{
+			char end{};
+			return std::sscanf(value.c_str(), "%f%c", &result, &end) == 1;
+		}
+	}
+
+	RenderServer::RenderServer(Scene* pScene, uint32_t threadCount, uint32_t queueCapacity) :
+		m_pScene{ pScene },
+		m_ThreadCount{ threadCount },
+		m_QueueCapacity{ std::max(1u, queueCapacity) }
+	{
+		const Camera& camera{ pScene->GetCamera() };
+		m_DefaultPosition = camera.origin;
+		m_DefaultYaw = camera.totalYaw;
+		m_DefaultPitch = camera.totalPitch;
+		m_DefaultFov = camera.fovAngle;
+	}
+
+	RenderServer::~RenderServer() = default;
+
+	bool RenderServer::Run(uint16_t port, const std::string& address)
+	{
+		if (!Socket::Startup())
+			return false;
+
+		Socket listener{};
+		if (!listener.Listen(address, port))
+		{
+			std::cout << "Couldn't listen on " << address << ":" << port << "\n";
+			Socket::Cleanup();
+			return false;
+		}
+		std::cout << "Render server on " << address << ":" << port << "\n";
+
+		std::thread renderThread{ [this] { RenderJobs(); } };
+		while (true)
+		{
+			{
+				std::lock_guard lock{ m_Mutex };
+				if (m_IsStopping)
+					break;
+			}
+
+			// Clients that hung up
+			for (size_t i{}; i < m_Readers.size();)
+			{
+				if (m_Readers[i].pConnection->isReading)
+				{
+					++i;
+					continue;
+				}
+				m_Readers[i].thread.join();
+				m_Readers.erase(m_Readers.begin() + i);
+			}
+
+			// Wakes up now and then to see whether a client asked to shut down
+			std::shared_ptr<Connection> pConnection{ std::make_shared<Connection>() };
+			if (listener.Accept(pConnection->socket, 100))
+			{
+				// A client that stops reading would otherwise block the render thread (and every other client, and shutdown) forever
+				pConnection->socket.SetSendTimeout(SendTimeoutMilliseconds);
+				m_Readers.push_back({ pConnection, std::thread{ [this, pConnection] { ReadRequests(pConnection); } } });
+			}
+		}
+		listener.Close();
+
+		// The render thread answers everything that's still queued first, a client that doesn't read holds it up for the send timeout at most
+		renderThread.join();
+		for (Reader& reader : m_Readers)
+		{
+			reader.pConnection->socket.Shutdown();
+			reader.thread.join();
+		}
+		m_Readers.clear();
+
+		Socket::Cleanup();
+		std::cout << "Render server stopped after " << m_RenderedCount << " frames\n";
+		return true;
+	}
+
+	void RenderServer::ReadRequests(const std::shared_ptr<Connection>& pConnection)
+	{
+		std::string pending{};
+		char buffer[4096];
+		uint64_t requestCount{};
+		bool isReading{ true };
+		while (isReading)
+		{
+			const int64_t receivedSize{ pConnection->socket.Receive(buffer, sizeof(buffer)) };
+			if (receivedSize <= 0)
+				break;
+			pending.append(buffer, static_cast<size_t>(receivedSize));
+
+			size_t lineStart{};
+			for (size_t lineEnd{ pending.find('\n') }; isReading && lineEnd != std::string::npos; lineEnd = pending.find('\n', lineStart))
+			{
+				std::string line{ pending.substr(lineStart, lineEnd - lineStart) };
+				lineStart = lineEnd + 1;
+				if (!line.empty() && line.back() == '\r')
+					line.pop_back();
+				if (line.empty())
+					continue;
+
+				if (line == "shutdown")
+				{
+					Stop();
+					isReading = false;
+					break;
+				}
+
+				Job job{};
+				job.pConnection = pConnection;
+				job.id = std::to_string(requestCount++);
+				job.receiveTime = Clock::now();
+				ParseRequest(line, job);
+
+				// Full queue: this connection stops reading until the render thread catches up
+				std::unique_lock lock{ m_Mutex };
+				m_JobTaken.wait(lock, [this] { return m_Jobs.size() < m_QueueCapacity || m_IsStopping; });
+				if (m_IsStopping)
+				{
+					isReading = false;
+					break;
+				}
+				m_Jobs.push_back(std::move(job));
+				m_JobQueued.notify_one();
+			}
+			pending.erase(0, lineStart);
+
+			if (pending.size() > MaxLineLength)
+				break;
+		}
+		pConnection->isReading = false;
+	}
+
+	void RenderServer::ParseRequest(const std::string& line, Job& job) const
+	{
+		job.position = m_DefaultPosition;
+		job.yaw = m_DefaultYaw;
+		job.pitch = m_DefaultPitch;
+		job.fov = m_DefaultFov;
+
+		std::istringstream stream{ line };
+		std::string command{};
+		stream >> command;
+		if (command != "render")
+		{
+			job.error = "unknown command " + command;
+			return;
+		}
+
+		std::string option{};
+		while (stream >> option)
+		{
+			const size_t separator{ option.find('=') };
+			if (separator == std::string::npos)
+			{
+				job.error = "expected key=value instead of " + option;
+				return;
+			}
+			const std::string key{ option.substr(0, separator) };
+			const std::string value{ option.substr(separator + 1) };
+
+			bool isValid{ true };
+			if (key == "id")
+			{
+				isValid = !value.empty() && value.size() <= MaxIdLength;
+				if (isValid)
+					job.id = value;
+			}
+			else if (key == "size")
+			{
+				char end{};
+				isValid = std::sscanf(value.c_str(), "%ux%u%c", &job.width, &job.height, &end) == 2
+					&& job.width > 0 && job.height > 0 && job.width <= MaxImageSize && job.height <= MaxImageSize;
+			}
+			else if (key == "region")
+			{
+				char end{};
+				isValid = std::sscanf(value.c_str(), "%u,%u,%ux%u%c", &job.regionX, &job.regionY, &job.regionWidth, &job.regionHeight, &end) == 4
+					&& job.regionWidth > 0 && job.regionHeight > 0 && job.regionWidth <= MaxImageSize && job.regionHeight <= MaxImageSize;
+			}
+			else if (key == "position")
+			{
+				char end{};
+				isValid = std::sscanf(value.c_str(), "%f,%f,%f%c", &job.position.x, &job.position.y, &job.position.z, &end) == 3;
+			}
+			else if (key == "yaw")
+				isValid = ParseFloat(value, job.yaw);
+			else if (key == "pitch")
+				isValid = ParseFloat(value, job.pitch);
+			else if (key == "fov")
+				isValid = ParseFloat(value, job.fov) && job.fov > 0.f && job.fov < 180.f;
+			else if (key == "time")
+				isValid = ParseFloat(value, job.time);
+			else if (key == "lighting")
+			{
+				if (value == "observedarea")
+					job.lightingMode = Renderer::LightingMode::ObservedArea;
+				else if (value == "radiance")
+					job.lightingMode = Renderer::LightingMode::Radiance;
+				else if (value == "brdf")
+					job.lightingMode = Renderer::LightingMode::BRDF;
+				else if (value == "combined")
+					job.lightingMode = Renderer::LightingMode::Combined;
+				else
+					isValid = false;
+			}
+			else if (key == "shadows" || key == "reflections")
+			{
+				isValid = value == "on" || value == "off";
+				(key == "shadows" ? job.isShadowsEnabled : job.isReflectionsEnabled) = value == "on";
+			}
+			else if (key == "keyframe")
+			{
+				isValid = value == "on" || value == "off";
+				job.isKeyframe = value == "on";
+			}
+			else if (key == "format")
+			{
+				if (value == "qoi")
+					job.format = ImageFormat::QOI;
+				else if (value == "ppm")
+					job.format = ImageFormat::PPM;
+				else if (value == "bmp")
+					job.format = ImageFormat::BMP;
+				else
+					isValid = false;
+				job.isRaw = value == "rgb";
+				job.isDelta = value == "delta";
+				isValid |= job.isRaw || job.isDelta;
+			}
+			else
+			{
+				job.error = "unknown option " + key;
+				return;
+			}
+
+			if (!isValid)
+			{
+				job.error = "bad value for " + key;
+				return;
+			}
+		}
+
+		if (job.regionWidth == 0)
+		{
+			job.regionWidth = job.width;
+			job.regionHeight = job.height;
+		}
+		else if (job.regionX >= job.width || job.regionY >= job.height)
+			job.error = "region outside of the frame";
+	}
+
+	void RenderServer::RenderJobs()
+	{
+		while (true)
+		{
+			Job job{};
+			{
+				std::unique_lock lock{ m_Mutex };
+				m_JobQueued.wait(lock, [this] { return !m_Jobs.empty() || m_IsStopping; });
+				if (m_Jobs.empty())
+					return;  // stopping, and every accepted request is answered
+
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop_front();
+			}
+			m_JobTaken.notify_all();
+
+			RenderJob(job);
+		}
+	}
+
+	void RenderServer::RenderJob(Job& job)
+	{
+		char header[256];
+		if (job.pConnection->isBroken)
+			return;
+		if (!job.error.empty())
+		{
+			const int headerSize{ std::snprintf(header, sizeof(header), "error %s %.150s\n", job.id.c_str(), job.error.c_str()) };
+			job.pConnection->isBroken = !job.pConnection->socket.SendAll(header, static_cast<size_t>(headerSize));
+			return;
+		}
+
+		const Clock::time_point startTime{ Clock::now() };
+		if (m_pTarget == nullptr || m_pTarget->GetWidth() != job.regionWidth || m_pTarget->GetHeight() != job.regionHeight)
+		{
+			m_pRenderer.reset();
+			m_pTarget = std::make_unique<MemoryRenderTarget>(job.regionWidth, job.regionHeight);
+			m_pRenderer = std::make_unique<Renderer>(m_pTarget.get());
+			m_pRenderer->SetThreadCount(m_ThreadCount);
+		}
+
+		// The scene only animates (and refits its BVHs) when the time changes, a new camera alone just renders
+		if (!m_IsSceneUpdated || job.time != m_SceneTime)
+		{
+			m_Timer.SetFixedTime(job.time);
+			m_pScene->Update(&m_Timer);
+			m_SceneTime = job.time;
+			m_IsSceneUpdated = true;
+		}
+		else
+			m_pScene->GetFrameAllocator().Reset();
+
+		Camera& camera{ m_pScene->GetCamera() };
+		camera.origin = job.position;
+		camera.SetOrientation(job.pitch, job.yaw);
+		camera.SetFov(job.fov);
+
+		m_pRenderer->SetLightingMode(job.lightingMode);
+		m_pRenderer->SetShadowsEnabled(job.isShadowsEnabled);
+		m_pRenderer->SetReflectionsEnabled(job.isReflectionsEnabled);
+		m_pRenderer->SetRegion(job.width, job.height, job.regionX, job.regionY);
+		m_pRenderer->Render(m_pScene);
+
+		const uint32_t pixelCount{ job.regionWidth * job.regionHeight };
+		const uint32_t* pPixels{ m_pTarget->GetPixels() };
+		const FrameWriter::PixelLayout layout{ m_pTarget->GetLayout() };
+		if (job.isRaw)
+		{
+			m_Encoded.resize(size_t(pixelCount) * 3);
+			for (uint32_t i{}; i < pixelCount; ++i)
+			{
+				m_Encoded[i * 3] = static_cast<uint8_t>(pPixels[i] >> layout.redShift);
+				m_Encoded[i * 3 + 1] = static_cast<uint8_t>(pPixels[i] >> layout.greenShift);
+				m_Encoded[i * 3 + 2] = static_cast<uint8_t>(pPixels[i] >> layout.blueShift);
+			}
+		}
+		else if (job.isDelta)
+		{
+			DeltaFrameEncoder& encoder{ job.pConnection->deltaEncoder };
+			if (job.isKeyframe)
+				encoder.Reset();
+			const std::vector<uint8_t>& message{ encoder.Encode(pPixels, job.regionWidth, job.regionHeight, layout) };
+			m_Encoded.assign(message.begin(), message.end());
+		}
+		else
+			FrameWriter::Encode(pPixels, job.regionWidth, job.regionHeight, layout, job.format, m_Encoded);
+		++m_RenderedCount;
+
+		const Clock::time_point endTime{ Clock::now() };
+		const float queueMilliseconds{ std::chrono::duration<float, std::milli>(startTime - job.receiveTime).count() };
+		const float renderMilliseconds{ std::chrono::duration<float, std::milli>(endTime - startTime).count() };
+		const int headerSize{ std::snprintf(header, sizeof(header), "frame %s %s %u %u %zu %.3f %.3f\n", job.id.c_str(),
+			job.isRaw ? "rgb" : job.isDelta ? "delta" : FrameWriter::GetExtension(job.format) + 1, job.regionWidth, job.regionHeight, m_Encoded.size(),
+			queueMilliseconds, renderMilliseconds) };
+
+		// A client that hung up doesn't stop the others
+		job.pConnection->isBroken = !job.pConnection->socket.SendAll(header, static_cast<size_t>(headerSize))
+			|| !job.pConnection->socket.SendAll(m_Encoded.data(), m_Encoded.size());
+	}
+
+	void RenderServer::Stop()
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_IsStopping = true;
+		m_JobQueued.notify_all();
+		m_JobTaken.notify_all();
+	}
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DeltaFrameStream.h"
+#include "FrameWriter.h"
+#include "Math.h"
+#include "Renderer.h"
+#include "Socket.h"
+#include "Timer.h"
+
+namespace dae
+{
+	class Scene;
+	class MemoryRenderTarget;
+
+	// Keeps one scene loaded (geometry, BVHs, materials) and renders frames for clients on <address>:<port>, 127.0.0.1 by default.
+	// A client sends one request per line and may send many before reading anything back (pipelining),
+	// the answers come back in the same order:
+	//
+	//   render [id=<n>] [size=<w>x<h>] [region=<x>,<y>,<w>x<h>] [position=x,y,z] [yaw=<deg>] [pitch=<deg>] [fov=<deg>] [time=<s>]
+	//          [lighting=observedarea|radiance|brdf|combined] [shadows=on|off] [reflections=on|off] [format=qoi|ppm|bmp|rgb|delta]
+	//          [keyframe=on]
+	//     -> "frame <id> <format> <width> <height> <byte count> <queue ms> <render ms>\n" followed by the encoded image
+	//        region renders only that part of the frame (a tile for RenderCoordinator), it may stick out of the frame.
+	//        rgb is 8 bit R, G, B per pixel without any header.
+	//        delta only has the tiles that changed since the connection's previous delta frame (see DeltaFrameStream.h),
+	//        keyframe=on sends all of them, e.g. when the viewer lost its copy
+	//     -> "error <id> <message>\n"
+	//   shutdown
+	//     -> the server stops once the frames it already accepted are sent
+	//
+	// A client that doesn't read its answers for 10s (the send makes no progress) gets no more frames
+	// Whatever a request leaves out is the scene's own camera & the renderer's defaults, requests don't change each other.
+	// Requests from every connection go into one bounded queue and get rendered one after the other (each frame uses every thread).
+	// When the queue is full the server stops reading, so clients that send too much wait in their send instead of piling up memory
+	class RenderServer final
+	{
+	public:
+		// The scene is initialized already and not owned. threadCount like Renderer::SetThreadCount
+		RenderServer(Scene* pScene, uint32_t threadCount = 0, uint32_t queueCapacity = 16);
+		~RenderServer();
+
+		RenderServer(const RenderServer&) = delete;
+		RenderServer(RenderServer&&) noexcept = delete;
+		RenderServer& operator=(const RenderServer&) = delete;
+		RenderServer& operator=(RenderServer&&) noexcept = delete;
+
+		/**
+		 * \brief Serves until a client sends shutdown, false if the port couldn't be opened
+		 * \param address IPv4 address to listen on, 0.0.0.0 lets other machines connect (there's no authentication)
+		 */
+		bool Run(uint16_t port, const std::string& address = "127.0.0.1");
+
+		uint64_t GetRenderedCount() const { return m_RenderedCount; }
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct Connection
+		{
+			Socket socket{};
+			std::atomic<bool> isReading{ true };
+			// Render thread only
+			bool isBroken{};  // a send failed, the rest of its requests get skipped
+			DeltaFrameEncoder deltaEncoder{};
+		};
+
+		struct Job
+		{
+			std::shared_ptr<Connection> pConnection{};
+			std::string id{};
+			std::string error{};  // answered with this instead of rendering, kept in the queue so the order stays right
+			Clock::time_point receiveTime{};
+
+			uint32_t width{ 640 };
+			uint32_t height{ 480 };
+			Vector3 position{};
+			float yaw{};
+			float pitch{};
+			float fov{};
+			float time{};
+			// Part of the frame that gets rendered, 0 x 0 is all of it
+			uint32_t regionX{};
+			uint32_t regionY{};
+			uint32_t regionWidth{};
+			uint32_t regionHeight{};
+			Renderer::LightingMode lightingMode{ Renderer::LightingMode::Combined };
+			bool isShadowsEnabled{ true };
+			bool isReflectionsEnabled{ false };
+			ImageFormat format{ ImageFormat::QOI };
+			bool isRaw{};  // format=rgb
+			bool isDelta{};
+			bool isKeyframe{};
+		};
+
+		struct Reader
+		{
+			std::shared_ptr<Connection> pConnection{};
+			std::thread thread{};
+		};
+
+		// How long a send can make no progress before its connection counts as broken
+		static constexpr int SendTimeoutMilliseconds{ 10000 };
+
+		Scene* m_pScene{};
+		uint32_t m_ThreadCount{};
+		size_t m_QueueCapacity{};
+
+		// The scene's camera from before the first request, where requests start from
+		Vector3 m_DefaultPosition{};
+		float m_DefaultYaw{};
+		float m_DefaultPitch{};
+		float m_DefaultFov{};
+
+		std::deque<Job> m_Jobs{};
+		bool m_IsStopping{};
+		std::mutex m_Mutex{};
+		std::condition_variable m_JobQueued{};
+		std::condition_variable m_JobTaken{};
+
+		std::vector<Reader> m_Readers{};
+		uint64_t m_RenderedCount{};
+
+		// Only used on the render thread. Renderer & target stay alive as long as the requested (region) size doesn't change
+		Timer m_Timer{};
+		float m_SceneTime{};
+		bool m_IsSceneUpdated{};
+		std::unique_ptr<MemoryRenderTarget> m_pTarget{};
+		std::unique_ptr<Renderer> m_pRenderer{};
+		std::vector<uint8_t> m_Encoded{};
+
+		void ReadRequests(const std::shared_ptr<Connection>& pConnection);
+		// Fills in job, or its error when the line isn't a valid request
+		void ParseRequest(const std::string& line, Job& job) const;
+		void RenderJobs();
+		void RenderJob(Job& job);
+		void Stop();
+	};
+}
@@ -0,0 +1,105 @@
+#include "RenderStatistics.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "MemoryTracker.h"
+
+namespace dae
+{
+	namespace RenderStatistics
+	{
+		namespace
+		{
+			struct Registry
+			{
+				std::mutex mutex{};
+				std::vector<std::unique_ptr<ThreadCounters>> threads{};
+				Counters frameStart{};
+				Counters frame{};
+			};
+
+			Registry& GetRegistry()
+			{
+				static Registry registry{};
+				return registry;
+			}
+
+			constexpr const char* CounterNames[CounterCount]
+			{
+				"primary rays", "shadow rays", "reflection rays",
+				"planes", "spheres", "boxes", "oriented boxes", "disks", "quads", "cylinders", "height fields", "point clouds",
+				"voxel grids", "triangles", "slab tests", "mesh early-outs"
+			};
+		}
+
+		ThreadCounters* RegisterThread()
+		{
+			// Once per thread, whichever frame a pool worker happens to get its first pixels in, not per frame work
+			MemoryTracker::ScopedPause pauseTracking{};
+			Registry& registry{ GetRegistry() };
+			std::lock_guard lock{ registry.mutex };
+			registry.threads.push_back(std::make_unique<ThreadCounters>());
+			return registry.threads.back().get();
+		}
+
+		Counters GetTotal()
+		{
+			Registry& registry{ GetRegistry() };
+			std::lock_guard lock{ registry.mutex };
+			Counters total{};
+			for (const std::unique_ptr<ThreadCounters>& pThread : registry.threads)
+			{
+				for (uint32_t i{}; i < CounterCount; ++i)
+					total.counts[i] += pThread->counts[i].load(std::memory_order_relaxed);
+				for (uint32_t i{}; i < MaterialCount; ++i)
+					total.shadingCalls[i] += pThread->shadingCalls[i].load(std::memory_order_relaxed);
+			}
+			return total;
+		}
+
+		void EndFrame()
+		{
+			const Counters total{ GetTotal() };
+			Registry& registry{ GetRegistry() };
+			std::lock_guard lock{ registry.mutex };
+			for (uint32_t i{}; i < CounterCount; ++i)
+				registry.frame.counts[i] = total.counts[i] - registry.frameStart.counts[i];
+			for (uint32_t i{}; i < MaterialCount; ++i)
+				registry.frame.shadingCalls[i] = total.shadingCalls[i] - registry.frameStart.shadingCalls[i];
+			registry.frameStart = total;
+		}
+
+		Counters GetFrame()
+		{
+			Registry& registry{ GetRegistry() };
+			std::lock_guard lock{ registry.mutex };
+			return registry.frame;
+		}
+
+		const char* GetName(Counter counter)
+		{
+			return counter < Counter::Count ? CounterNames[static_cast<uint32_t>(counter)] : "";
+		}
+
+		void Print(std::ostream& stream, const Counters& counters)
+		{
+			const char* pSeparator{ "" };
+			for (uint32_t i{}; i < CounterCount; ++i)
+			{
+				if (counters.counts[i] == 0)
+					continue;
+				stream << pSeparator << CounterNames[i] << " " << counters.counts[i];
+				pSeparator = ", ";
+			}
+			for (uint32_t i{}; i < MaterialCount; ++i)
+			{
+				if (counters.shadingCalls[i] == 0)
+					continue;
+				stream << pSeparator << "shading material " << i << " " << counters.shadingCalls[i];
+				pSeparator = ", ";
+			}
+		}
+	}
+}
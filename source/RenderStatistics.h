@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+// 0 (e.g. in the project's preprocessor definitions) compiles every counter away, RENDER_STAT then does nothing
+#ifndef RENDER_STATISTICS
+#define RENDER_STATISTICS 1
+#endif
+
+namespace dae
+{
+	// What a frame costs: rays, intersection tests & shading calls. Every thread counts into its own block
+	// (no locks, no shared cache lines), the renderer adds them up once per frame
+	namespace RenderStatistics
+	{
+		enum class Counter : uint32_t
+		{
+			PrimaryRays,
+			ShadowRays,
+			ReflectionRays,
+			PlaneTests,
+			SphereTests,
+			BoxTests,
+			OrientedBoxTests,
+			DiskTests,
+			QuadTests,
+			CylinderTests,
+			HeightFieldTests,
+			PointCloudTests,
+			VoxelGridTests,
+			TriangleTests,
+			SlabTests,      // AABB slab tests, BVH nodes & voxel grid DDA steps (bricks and voxels) included
+			MeshEarlyOuts,  // meshes skipped because the ray missed their bounding box
+			Count
+		};
+		constexpr uint32_t CounterCount{ static_cast<uint32_t>(Counter::Count) };
+		// Material indices are an unsigned char
+		constexpr uint32_t MaterialCount{ 256 };
+
+		struct Counters
+		{
+			uint64_t counts[CounterCount]{};
+			uint64_t shadingCalls[MaterialCount]{};  // per material index
+
+			uint64_t operator[](Counter counter) const { return counts[static_cast<uint32_t>(counter)]; }
+		};
+
+		// Only its own thread writes, so a relaxed load & store is enough (no locked add), the sum reads them from another thread
+		struct ThreadCounters
+		{
+			std::atomic<uint64_t> counts[CounterCount]{};
+			std::atomic<uint64_t> shadingCalls[MaterialCount]{};
+		};
+
+		// The first call on a thread allocates its block, it stays until the program ends (threads that are gone still count)
+		ThreadCounters* RegisterThread();
+
+		inline ThreadCounters& GetThreadCounters()
+		{
+			thread_local ThreadCounters* pCounters{ RegisterThread() };
+			return *pCounters;
+		}
+
+		inline void Increment(std::atomic<uint64_t>& value)
+		{
+			value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+
+		// Everything counted so far, by every thread
+		Counters GetTotal();
+		// The frame's counts are everything since the previous EndFrame, GetFrame has them from then on
+		void EndFrame();
+		Counters GetFrame();
+
+		const char* GetName(Counter counter);
+		// One line, counters that are 0 are left out
+		void Print(std::ostream& stream, const Counters& counters);
+	}
+}
+
+#if RENDER_STATISTICS
+#define RENDER_STAT(counter) ::dae::RenderStatistics::Increment(::dae::RenderStatistics::GetThreadCounters().counts[static_cast<uint32_t>(::dae::RenderStatistics::Counter::counter)])
+#define RENDER_STAT_SHADING(materialIndex) ::dae::RenderStatistics::Increment(::dae::RenderStatistics::GetThreadCounters().shadingCalls[static_cast<uint8_t>(materialIndex)])
+#else
+#define RENDER_STAT(counter) ((void)0)
+#define RENDER_STAT_SHADING(materialIndex) ((void)0)
+#endif
@@ -0,0 +1,46 @@
+#include "RenderTarget.h"
+
+#include <cassert>
+
+#include "SDL.h"
+#include "SDL_surface.h"
+
+namespace dae
+{
+	WindowRenderTarget::WindowRenderTarget(SDL_Window* pWindow) :
+		m_pWindow{ pWindow },
+		m_pSurface{ SDL_GetWindowSurface(pWindow) }
+	{
+		int width{}, height{};
+		SDL_GetWindowSize(pWindow, &width, &height);
+		m_Width = static_cast<uint32_t>(width);
+		m_Height = static_cast<uint32_t>(height);
+
+		// Rows are written back to back
+		assert(m_pSurface->pitch == width * static_cast<int>(sizeof(uint32_t)) && "Window surface rows are padded");
+	}
+
+	uint32_t* WindowRenderTarget::GetPixels()
+	{
+		return static_cast<uint32_t*>(m_pSurface->pixels);
+	}
+
+	FrameWriter::PixelLayout WindowRenderTarget::GetLayout() const
+	{
+		const SDL_PixelFormat* pFormat{ m_pSurface->format };
+		return { pFormat->Rshift, pFormat->Gshift, pFormat->Bshift, pFormat->Amask };
+	}
+
+	void WindowRenderTarget::Present()
+	{
+		SDL_UpdateWindowSurface(m_pWindow);
+	}
+
+	MemoryRenderTarget::MemoryRenderTarget(uint32_t width, uint32_t height, const FrameWriter::PixelLayout& layout) :
+		m_Width{ width },
+		m_Height{ height },
+		m_Layout{ layout },
+		m_Pixels(size_t(width) * height)
+	{
+	}
+}
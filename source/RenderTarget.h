@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "FrameWriter.h"
+
+struct SDL_Window;
+struct SDL_Surface;
+
+namespace dae
+{
+	// Where the renderer puts its frames: width * height packed 8 bit pixels, presented once a frame is complete
+	class RenderTarget
+	{
+	public:
+		RenderTarget() = default;
+		virtual ~RenderTarget() = default;
+
+		RenderTarget(const RenderTarget&) = delete;
+		RenderTarget(RenderTarget&&) noexcept = delete;
+		RenderTarget& operator=(const RenderTarget&) = delete;
+		RenderTarget& operator=(RenderTarget&&) noexcept = delete;
+
+		virtual uint32_t GetWidth() const = 0;
+		virtual uint32_t GetHeight() const = 0;
+		// The frame that's being written, or was presented last
+		virtual uint32_t* GetPixels() = 0;
+		virtual FrameWriter::PixelLayout GetLayout() const = 0;
+
+		// Where the next frame goes, right before the renderer writes it. Targets with several buffers switch to the next one here
+		virtual uint32_t* BeginFrame() { return GetPixels(); }
+		// The pixels hold a complete frame
+		virtual void Present() = 0;
+	};
+
+	// The SDL window surface, Present shows it
+	class WindowRenderTarget final : public RenderTarget
+	{
+	public:
+		explicit WindowRenderTarget(SDL_Window* pWindow);
+
+		uint32_t GetWidth() const override { return m_Width; }
+		uint32_t GetHeight() const override { return m_Height; }
+		uint32_t* GetPixels() override;
+		FrameWriter::PixelLayout GetLayout() const override;
+		void Present() override;
+
+	private:
+		SDL_Window* m_pWindow{};
+		SDL_Surface* m_pSurface{};
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+	};
+
+	// Plain memory, for rendering without a window or display: only the frame sinks (streams, captures) see the frames
+	class MemoryRenderTarget final : public RenderTarget
+	{
+	public:
+		MemoryRenderTarget(uint32_t width, uint32_t height, const FrameWriter::PixelLayout& layout = {});
+
+		uint32_t GetWidth() const override { return m_Width; }
+		uint32_t GetHeight() const override { return m_Height; }
+		uint32_t* GetPixels() override { return m_Pixels.data(); }
+		FrameWriter::PixelLayout GetLayout() const override { return m_Layout; }
+		void Present() override { ++m_PresentedCount; }
+
+		uint64_t GetPresentedCount() const { return m_PresentedCount; }
+
+	private:
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		FrameWriter::PixelLayout m_Layout{};
+		std::vector<uint32_t> m_Pixels{};
+		uint64_t m_PresentedCount{};
+	};
+}
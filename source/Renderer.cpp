@@ -1,7 +1,3 @@
-//External includes
-#include "SDL.h"
-#include "SDL_surface.h"
-
 //Project includes
 #include "Renderer.h"
 #include "Math.h"
@@ -9,35 +5,110 @@
 #include "Material.h"
 #include "Scene.h"
 #include "Utils.h"
+#include <cstdio>
 #include <thread>
 #include "camera.h"
 #include <future>
+#if defined(_MSC_VER)
 #include <ppl.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include "DeltaFrameStream.h"
+#include "MemoryTracker.h"
+#include "RenderStatistics.h"
+#include "RenderTarget.h"
+#include "ThreadPool.h"
+#include "TiledImageFile.h"
 
 using namespace dae;
 
+namespace
+{
+	// This thread's running count of what the heat map shows, the difference over a pixel is what the pixel cost
+	uint64_t GetCostCount(Renderer::HeatMapMode heatMapMode)
+	{
+#if RENDER_STATISTICS
+		using RenderStatistics::Counter;
+		const RenderStatistics::ThreadCounters& counters{ RenderStatistics::GetThreadCounters() };
+		const auto get{ [&counters](Counter counter) { return counters.counts[static_cast<uint32_t>(counter)].load(std::memory_order_relaxed); } };
+		switch (heatMapMode)
+		{
+		case Renderer::HeatMapMode::IntersectionTests:
+		{
+			uint64_t count{};
+			for (uint32_t counter{ static_cast<uint32_t>(Counter::PlaneTests) }; counter <= static_cast<uint32_t>(Counter::TriangleTests); ++counter)
+				count += get(static_cast<Counter>(counter));
+			return count;
+		}
+		case Renderer::HeatMapMode::NodesVisited:
+			return get(Counter::SlabTests);
+		case Renderer::HeatMapMode::ShadowRays:
+			return get(Counter::ShadowRays);
+		default:
+			break;
+		}
+#endif
+		return 0;
+	}
+
+	// Delta frames decode to what was encoded: a keyframe, a delta with one changed tile & an unchanged frame.
+	// Not a multiple of the tile size, so the border tiles are cropped
+	bool IsDeltaFrameRoundTripExact()
+	{
+		constexpr uint32_t width{ 70 };
+		constexpr uint32_t height{ 45 };
+		std::vector<uint32_t> pixels(width * height);
+		for (uint32_t i{}; i < pixels.size(); ++i)
+			pixels[i] = (i * 2654435761u) & 0x00FFFFFF;
+
+		DeltaFrameEncoder encoder{ 32 };
+		DeltaFrameDecoder decoder{};
+		const auto roundTrip{ [&]
+			{
+				const std::vector<uint8_t>& message{ encoder.Encode(pixels.data(), width, height, FrameWriter::PixelLayout{}) };
+				return decoder.Decode(message.data(), message.size()) && decoder.GetWidth() == width && decoder.GetHeight() == height
+					&& std::equal(pixels.begin(), pixels.end(), decoder.GetPixels().begin(), [](uint32_t a, uint32_t b) { return (a & 0x00FFFFFF) == (b & 0x00FFFFFF); });
+			} };
+
+		if (!roundTrip() || !encoder.GetStatistics().isKeyframe)
+			return false;
+		pixels[40 * width + 65] ^= 0x00FFFFFF;  // bottom right tile
+		if (!roundTrip() || encoder.GetStatistics().isKeyframe || encoder.GetStatistics().changedTileCount != 1)
+			return false;
+		return roundTrip() && encoder.GetStatistics().changedTileCount == 0;
+	}
+}
+
 // Both in comment -> synchronous execution
 //#define ASYNC
 #define PARALLEL_FOR
 
 
-Renderer::Renderer(SDL_Window* pWindow) :
-	m_pWindow(pWindow),
-	m_pBuffer(SDL_GetWindowSurface(pWindow))
+Renderer::Renderer(RenderTarget* pTarget) :
+	m_pTarget(pTarget)
 {
 	//Initialize
-	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
-	m_pBufferPixels = static_cast<uint32_t*>(m_pBuffer->pixels);
+	m_Width = static_cast<int>(pTarget->GetWidth());
+	m_Height = static_cast<int>(pTarget->GetHeight());
+	m_FrameWidth = m_Width;
+	m_FrameHeight = m_Height;
+	m_PixelLayout = pTarget->GetLayout();
+	m_pFrameBuffer = std::make_unique<FrameBuffer>(m_Width, m_Height);
+	m_pFrameWriter = std::make_unique<FrameWriter>(m_Width, m_Height, m_PixelLayout);
 	assert(RunTests());
 }
 
+Renderer::~Renderer() = default;
+
 void Renderer::Render(Scene* pScene) const
 {
 	Camera& camera = pScene->GetCamera();
 	auto& materials = pScene->GetMaterials();
 	auto& lights = pScene->GetLights();
 	
-	const float aspectRatio{ m_Width / float(m_Height) };	
+	const float aspectRatio{ m_FrameWidth / float(m_FrameHeight) };	
 	
 	camera.CalculateCameraToWorld();
 
@@ -50,8 +121,11 @@ void Renderer::Render(Scene* pScene) const
 	// Get the number of cores of the system
 	const uint32_t numCores{ std::thread::hardware_concurrency() };
 
-	// Vector to keep track of all the async futures
-	std::vector<std::future<void>> async_futures{};
+	// Vector to keep track of all the async futures, lives in the scene's per frame memory
+	// std::async itself still allocates its shared state, which isn't ours to count
+	MemoryTracker::ScopedPause pauseTracking{};
+	std::vector<std::future<void>, ArenaAllocator<std::future<void>>> async_futures{ ArenaAllocator<std::future<void>>(pScene->GetFrameAllocator()) };
+	async_futures.reserve(numCores);
 
 	// Calculate how many pixels per task
 	const uint32_t pixelsPerTask{ numPixels / numCores };
@@ -69,8 +143,9 @@ void Renderer::Render(Scene* pScene) const
 		}
 
 		async_futures.push_back(
-			std::async(std::launch::async, [=, this]
+			std::async(std::launch::async, [=, this, &camera, &lights, &materials]
 				{
+					MemoryTracker::ScopedTracking tracking{};
 					const uint32_t endPixel = currPixelIndex + taskSize;
 					for (uint32_t pixelIndex{ currPixelIndex }; pixelIndex < endPixel; ++pixelIndex)
 					{
@@ -97,10 +172,29 @@ void Renderer::Render(Scene* pScene) const
 #elif defined(PARALLEL_FOR)
 	// PARALLEL FOR EXECUTION
 	//concurrency::parallel_for()
-	concurrency::parallel_for((uint32_t)0, numPixels, [=, this](int pixelIndex)
+	// By reference: [=] would copy the light & material vectors every frame
+	const auto renderPixel{ [&, this](uint32_t pixelIndex)
 		{
 			RenderPixel(pScene, pixelIndex, camera.fovRatio, aspectRatio, camera, lights, materials);
-		});
+		} };
+	// The pool's workers count allocations for as long as the frame does, its own bookkeeping included
+	if (m_pThreadPool)
+		m_pThreadPool->ParallelFor(0, numPixels, renderPixel);
+	else
+	{
+#if defined(_MSC_VER)
+		// PPL's task bookkeeping isn't ours to count, its workers opt in per pixel
+		MemoryTracker::ScopedPause pauseTracking{};
+		concurrency::parallel_for((uint32_t)0, numPixels, [&renderPixel](uint32_t pixelIndex)
+			{
+				MemoryTracker::ScopedTracking tracking{};
+				renderPixel(pixelIndex);
+			});
+#else
+		// No PPL outside of MSVC
+		ThreadPool::GetShared().ParallelFor(0, numPixels, renderPixel);
+#endif
+	}
 
 #else
 	// SYNCHRONOUS EXECUTION
@@ -115,28 +209,60 @@ void Renderer::Render(Scene* pScene) const
 
 
 	//@END
-	//Update SDL Surface
-	SDL_UpdateWindowSurface(m_pWindow);
+#if RENDER_STATISTICS
+	RenderStatistics::EndFrame();
+#endif
+
+	// HDR -> display format in one pass, the heat map shows the costs instead (the float frame still has the image)
+	if (m_HeatMapMode != HeatMapMode::Off)
+		m_pHeatMap->Colorize(m_pTarget->BeginFrame(), m_PixelLayout, m_HeatMapRamp, m_HeatMapScale);
+	else
+		m_pFrameBuffer->ToneMap(m_pTarget->BeginFrame(), m_PixelLayout, m_ToneMapping, m_Exposure);
+
+	// Show it (window) / hand it over (headless)
+	m_pTarget->Present();
 }
 
 void Renderer::RenderPixel(Scene* pScene, uint32_t pixelIndex, float fov, float aspectRatio, const Camera& camera, const std::vector<Light>& lights, const std::vector<Material*>& materials) const
 {
-	uint32_t px{ pixelIndex % m_Width };
-	uint32_t py{ pixelIndex / m_Width };
+	uint32_t px{ pixelIndex % m_Width + m_RegionX };
+	uint32_t py{ pixelIndex / m_Width + m_RegionY };
 
-	const float cx{ ((2.0f * (px + 0.5f) / float(m_Width)) - 1.0f) * aspectRatio * fov };
-	const float cy{ (1.0f - ((2.0f * (py + 0.5f)) / float(m_Height))) * fov };
-
-	float multiplier = 1.0f;
+	const float cx{ ((2.0f * (px + 0.5f) / float(m_FrameWidth)) - 1.0f) * aspectRatio * fov };
+	const float cy{ (1.0f - ((2.0f * (py + 0.5f)) / float(m_FrameHeight))) * fov };
 
 	const Vector3 rayDirection{ camera.cameraToWorld.TransformVector(Vector3{cx, cy, 1}).Normalized() };
-	Ray viewRay{ camera.origin,  rayDirection };
+
+	// Unclamped, tone mapping happens once for the whole frame
+	if (m_HeatMapMode == HeatMapMode::Off)
+	{
+		m_pFrameBuffer->SetPixel(pixelIndex, TraceRay(pScene, Ray{ camera.origin, rayDirection }, lights, materials));
+		return;
+	}
+
+	// The same work as a normal frame, with what it cost on the side
+	const uint64_t startCount{ GetCostCount(m_HeatMapMode) };
+	const auto startTime{ std::chrono::steady_clock::now() };
+	m_pFrameBuffer->SetPixel(pixelIndex, TraceRay(pScene, Ray{ camera.origin, rayDirection }, lights, materials));
+	m_pHeatMap->SetCost(pixelIndex, m_HeatMapMode == HeatMapMode::Time
+		? std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - startTime).count()
+		: static_cast<float>(GetCostCount(m_HeatMapMode) - startCount));
+}
+
+ColorRGB Renderer::TraceRay(Scene* pScene, Ray viewRay, const std::vector<Light>& lights, const std::vector<Material*>& materials) const
+{
+	const Vector3 rayDirection{ viewRay.direction };
+	float multiplier = 1.0f;
 
 	ColorRGB finalColor{};
 	float reflectivity{};
 	for (int bounce{}; bounce < m_Bounces; bounce++)
 	{
 		
+		if (bounce == 0)
+			RENDER_STAT(PrimaryRays);
+		else
+			RENDER_STAT(ReflectionRays);
 		HitRecord closestHit{};
 		pScene->GetClosestHit(viewRay, closestHit);  // Checks EVERY object in the scene and returns the closest one hit.
 		if (closestHit.didHit)
@@ -153,11 +279,16 @@ void Renderer::RenderPixel(Scene* pScene, uint32_t pixelIndex, float fov, float
 				const float observedArea{ Vector3::Dot(closestHit.normal, directionToLight) };
 
 				// Check if shadowed
-				if (m_ShadowsEnabled && pScene->DoesHit(lightRay))
-					continue;  // Skip if point can't see the light
+				if (m_ShadowsEnabled)
+				{
+					RENDER_STAT(ShadowRays);
+					if (pScene->DoesHit(lightRay))
+						continue;  // Skip if point can't see the light
+				}
 
 				// Calculate radiance color (light intensity)
 				const ColorRGB radianceColor{ LightUtils::GetRadiance(light, closestHit.origin) };
+				RENDER_STAT_SHADING(closestHit.materialIndex);
 				const ColorRGB BRDF{ materials[closestHit.materialIndex]->Shade(closestHit, -directionToLight, rayDirection) };  // Shade takes direction from light so inverse
 
 
@@ -204,22 +335,338 @@ void Renderer::RenderPixel(Scene* pScene, uint32_t pixelIndex, float fov, float
 			finalColor += skyColor;
 		}
 		
-		//Update Color in Buffer
+	}
+	return finalColor;
+}
 
 
+bool Renderer::RenderTiled(Scene* pScene, const std::string& filename, uint32_t width, uint32_t height, uint32_t tileSize) const
+{
+	TiledImageFile file{};
+	if (!file.Open(filename, width, height, tileSize))
+	{
+		std::cout << "Couldn't open " << filename << " for a " << width << "x" << height << " tiled render\n";
+		return false;
+	}
+
+	const uint32_t tileCount{ file.GetTileCount() };
+	const uint32_t skippedCount{ file.GetDoneCount() };
+	if (file.IsResumed())
+		std::cout << "Resuming " << filename << ": " << skippedCount << "/" << tileCount << " tiles already done\n";
+
+	Camera& camera = pScene->GetCamera();
+	const auto& materials = pScene->GetMaterials();
+	const auto& lights = pScene->GetLights();
+	camera.CalculateCameraToWorld();
+	const float aspectRatio{ width / float(height) };
+
+	// Tiles go to whichever thread asks first, each thread keeps its own tile buffers for the whole render
+	std::atomic<uint32_t> nextTile{};
+	std::atomic<uint32_t> renderedCount{};
+	std::atomic<bool> hasFailed{};
+	const auto renderTiles{ [&]
+		{
+			FrameBuffer tile{ tileSize, tileSize };
+			std::vector<uint32_t> packed(tile.GetPixelCount());
+			std::vector<uint8_t> rgb(size_t(tile.GetPixelCount()) * 3);
+			// Byte order R, G, B, (A) in memory
+			const FrameWriter::PixelLayout layout{ 0, 8, 16, 0 };
+
+			for (uint32_t tileIndex{ nextTile++ }; tileIndex < tileCount && !hasFailed; tileIndex = nextTile++)
+			{
+				if (file.IsTileDone(tileIndex))
+					continue;
+
+				const uint32_t tileX{ tileIndex % file.GetTilesX() * tileSize };
+				const uint32_t tileY{ tileIndex / file.GetTilesX() * tileSize };
+				for (uint32_t y{}; y < tileSize; ++y)
+				{
+					for (uint32_t x{}; x < tileSize; ++x)
+					{
+						const uint32_t px{ tileX + x };
+						const uint32_t py{ tileY + y };
+						// Border tiles stick out of the image, that part stays black
+						if (px >= width || py >= height)
+						{
+							tile.SetPixel(y * tileSize + x, {});
+							continue;
+						}
+
+						const float cx{ ((2.0f * (px + 0.5f) / float(width)) - 1.0f) * aspectRatio * camera.fovRatio };
+						const float cy{ (1.0f - ((2.0f * (py + 0.5f)) / float(height))) * camera.fovRatio };
+						const Vector3 rayDirection{ camera.cameraToWorld.TransformVector(Vector3{ cx, cy, 1 }).Normalized() };
+						tile.SetPixel(y * tileSize + x, TraceRay(pScene, Ray{ camera.origin, rayDirection }, lights, materials));
+					}
+				}
+
+				tile.ToneMap(packed.data(), layout, m_ToneMapping, m_Exposure);
+				for (size_t i{}; i < packed.size(); ++i)
+				{
+					rgb[i * 3] = static_cast<uint8_t>(packed[i]);
+					rgb[i * 3 + 1] = static_cast<uint8_t>(packed[i] >> 8);
+					rgb[i * 3 + 2] = static_cast<uint8_t>(packed[i] >> 16);
+				}
+
+				if (file.WriteTile(tileIndex, rgb.data()))
+					++renderedCount;
+				else
+					hasFailed = true;
+			}
+		} };
+
+	const auto start{ std::chrono::steady_clock::now() };
+	std::vector<std::thread> threads(m_pThreadPool ? m_pThreadPool->GetThreadCount() : std::max(1u, std::thread::hardware_concurrency()));
+	for (std::thread& thread : threads)
+	{
+		thread = std::thread{ renderTiles };
+	}
+
+	// Progress while the workers run, an interrupted render keeps every tile that got written
+	uint32_t printedCount{};
+	while (renderedCount + skippedCount < tileCount && !hasFailed)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(500));
+		if (renderedCount != printedCount)
+		{
+			printedCount = renderedCount;
+			std::cout << "Tiles: " << printedCount + skippedCount << "/" << tileCount << "\n";
+		}
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
 	}
-	finalColor.MaxToOne();
-	m_pBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBuffer->format,
-		static_cast<uint8_t>(finalColor.r * 255),
-		static_cast<uint8_t>(finalColor.g * 255),
-		static_cast<uint8_t>(finalColor.b * 255));
 
+	const float seconds{ std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count() };
+	if (hasFailed)
+	{
+		std::cout << "Writing " << filename << " failed, run it again to continue\n";
+		return false;
+	}
+	std::cout << filename << ": " << width << "x" << height << ", " << renderedCount << " tiles rendered in " << seconds << "s\n";
+	return true;
 }
 
+bool Renderer::SaveBufferToImage()
+{
+	char filename[FrameWriter::MaxFilenameLength]{};
+	FrameWriter::MakeTimestampedName(filename, sizeof(filename), "RayTracing", FrameWriter::GetExtension(m_ImageFormat));
+	if (!m_pFrameWriter->Submit(m_pTarget->GetPixels(), m_ImageFormat, filename))
+		return false;
+
+	std::cout << "Screenshot queued: " << filename << "\n";
+	return true;
+}
 
-bool Renderer::SaveBufferToImage() const
+void Renderer::ToggleFrameCapture()
 {
-	return SDL_SaveBMP(m_pBuffer, "RayTracing_Buffer.bmp");
+	m_IsCapturing = !m_IsCapturing;
+	if (m_IsCapturing)
+	{
+		m_CapturedFrameCount = 0;
+		FrameWriter::MakeTimestampedName(m_CapturePrefix, sizeof(m_CapturePrefix), "Capture", "");
+		std::cout << "Capturing frames: " << m_CapturePrefix << "_*" << FrameWriter::GetExtension(m_ImageFormat) << "\n";
+		return;
+	}
+
+	m_pFrameWriter->Flush();
+	std::cout << "Capture stopped: " << m_CapturedFrameCount << " frames, " << m_pFrameWriter->GetWrittenCount() << " written in total, "
+		<< m_pFrameWriter->GetFailedCount() << " failed, waited " << m_pFrameWriter->GetWaitSeconds() * 1000.f << "ms for free buffers\n";
+}
+
+void Renderer::CaptureFrame()
+{
+	if (m_pSequenceWriter && !m_pSequenceWriter->Submit(m_pTarget->GetPixels()))
+		CloseFrameSequence();
+
+	if (!m_IsCapturing)
+		return;
+
+	// Waits when the writer falls behind, every frame ends up on disk
+	char filename[FrameWriter::MaxFilenameLength]{};
+	std::snprintf(filename, sizeof(filename), "%s_%06u%s", m_CapturePrefix, m_CapturedFrameCount, FrameWriter::GetExtension(m_ImageFormat));
+	m_pFrameWriter->Submit(m_pTarget->GetPixels(), m_ImageFormat, filename);
+	++m_CapturedFrameCount;
+}
+
+bool Renderer::OpenFrameSequence(const std::string& path, SequenceFormat format, uint32_t framesPerSecond)
+{
+	m_pSequenceWriter = std::make_unique<FrameSequenceWriter>(m_Width, m_Height, m_PixelLayout, format, framesPerSecond);
+	if (!m_pSequenceWriter->Open(path))
+	{
+		m_pSequenceWriter.reset();
+		return false;
+	}
+	return true;
+}
+
+void Renderer::CloseFrameSequence()
+{
+	if (!m_pSequenceWriter)
+		return;
+
+	// Finishes writing before the stats are printed
+	const float waitSeconds{ m_pSequenceWriter->GetWaitSeconds() };
+	m_pSequenceWriter.reset();
+	std::cout << "Frame sequence closed, render thread waited " << waitSeconds * 1000.f << "ms for the writer\n";
+}
+
+bool Renderer::SaveImage(const std::string& filename)
+{
+	if (filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".pfm") == 0)
+		return m_pFrameBuffer->SavePFM(filename);
+
+	ImageFormat format{};
+	if (!FrameWriter::GetFormat(filename, format))
+		return false;
+
+	// Screenshots that failed before don't count against this one
+	const uint64_t failedCount{ m_pFrameWriter->GetFailedCount() };
+	if (filename.size() >= FrameWriter::MaxFilenameLength || !m_pFrameWriter->Submit(m_pTarget->GetPixels(), format, filename.c_str()))
+		return false;
+
+	m_pFrameWriter->Flush();
+	return m_pFrameWriter->GetFailedCount() == failedCount;
+}
+
+void Renderer::SetThreadCount(uint32_t threadCount)
+{
+	m_pThreadPool = threadCount > 0 ? std::make_unique<ThreadPool>(threadCount) : nullptr;
+}
+
+void Renderer::SetRegion(uint32_t frameWidth, uint32_t frameHeight, uint32_t x, uint32_t y)
+{
+	m_FrameWidth = static_cast<int>(frameWidth);
+	m_FrameHeight = static_cast<int>(frameHeight);
+	m_RegionX = static_cast<int>(x);
+	m_RegionY = static_cast<int>(y);
+}
+
+bool Renderer::SaveHDRImage() const
+{
+	char filename[FrameWriter::MaxFilenameLength]{};
+	FrameWriter::MakeTimestampedName(filename, sizeof(filename), "RayTracing", ".pfm");
+	if (!m_pFrameBuffer->SavePFM(filename))
+		return false;
+
+	std::cout << "HDR screenshot saved: " << filename << "\n";
+	return true;
+}
+
+void Renderer::CycleToneMapping()
+{
+	switch (m_ToneMapping)
+	{
+	case ToneMapping::MaxToOne:
+		m_ToneMapping = ToneMapping::Reinhard;
+		std::cout << "ToneMapping: Reinhard\n";
+		break;
+	case ToneMapping::Reinhard:
+		m_ToneMapping = ToneMapping::ACES;
+		std::cout << "ToneMapping: ACES\n";
+		break;
+	case ToneMapping::ACES:
+		m_ToneMapping = ToneMapping::MaxToOne;
+		std::cout << "ToneMapping: MaxToOne\n";
+		break;
+	}
+}
+
+void Renderer::CycleImageFormat()
+{
+	switch (m_ImageFormat)
+	{
+	case ImageFormat::QOI:
+		m_ImageFormat = ImageFormat::BMP;
+		std::cout << "ImageFormat: BMP\n";
+		break;
+	case ImageFormat::BMP:
+		m_ImageFormat = ImageFormat::PPM;
+		std::cout << "ImageFormat: PPM\n";
+		break;
+	case ImageFormat::PPM:
+		m_ImageFormat = ImageFormat::QOI;
+		std::cout << "ImageFormat: QOI\n";
+		break;
+	}
+}
+
+void Renderer::CycleHeatMapMode()
+{
+	switch (m_HeatMapMode)
+	{
+#if RENDER_STATISTICS
+	case HeatMapMode::Off:
+		SetHeatMapMode(HeatMapMode::IntersectionTests);
+		std::cout << "HeatMap: IntersectionTests\n";
+		break;
+	case HeatMapMode::IntersectionTests:
+		SetHeatMapMode(HeatMapMode::NodesVisited);
+		std::cout << "HeatMap: NodesVisited\n";
+		break;
+	case HeatMapMode::NodesVisited:
+		SetHeatMapMode(HeatMapMode::ShadowRays);
+		std::cout << "HeatMap: ShadowRays\n";
+		break;
+	case HeatMapMode::ShadowRays:
+#else
+	// Without the counters there's only time to show
+	case HeatMapMode::Off:
+	case HeatMapMode::IntersectionTests:
+	case HeatMapMode::NodesVisited:
+	case HeatMapMode::ShadowRays:
+#endif
+		SetHeatMapMode(HeatMapMode::Time);
+		std::cout << "HeatMap: Time\n";
+		break;
+	case HeatMapMode::Time:
+		SetHeatMapMode(HeatMapMode::Off);
+		std::cout << "HeatMap: Off\n";
+		break;
+	}
+}
+
+void Renderer::SetHeatMapMode(HeatMapMode heatMapMode)
+{
+	m_HeatMapMode = heatMapMode;
+	if (m_HeatMapMode != HeatMapMode::Off && !m_pHeatMap)
+		m_pHeatMap = std::make_unique<HeatMap>(m_Width, m_Height);
+}
+
+void Renderer::CycleHeatMapRamp()
+{
+	switch (m_HeatMapRampPreset)
+	{
+	case HeatMap::Ramp::Heat:
+		m_HeatMapRampPreset = HeatMap::Ramp::Rainbow;
+		std::cout << "HeatMapRamp: Rainbow\n";
+		break;
+	case HeatMap::Ramp::Rainbow:
+		m_HeatMapRampPreset = HeatMap::Ramp::Grayscale;
+		std::cout << "HeatMapRamp: Grayscale\n";
+		break;
+	case HeatMap::Ramp::Grayscale:
+		m_HeatMapRampPreset = HeatMap::Ramp::Heat;
+		std::cout << "HeatMapRamp: Heat\n";
+		break;
+	}
+	m_HeatMapRamp = HeatMap::GetRamp(m_HeatMapRampPreset);
+}
+
+bool Renderer::SaveCostBuffer(const std::string& filename) const
+{
+	if (!m_pHeatMap)
+		return false;
+	if (!filename.empty())
+		return m_pHeatMap->SavePFM(filename);
+
+	char timestampedName[FrameWriter::MaxFilenameLength]{};
+	FrameWriter::MakeTimestampedName(timestampedName, sizeof(timestampedName), "RayTracing_Cost", ".pfm");
+	if (!m_pHeatMap->SavePFM(timestampedName))
+		return false;
+
+	std::cout << "Cost buffer saved: " << timestampedName << "\n";
+	return true;
 }
 
 void dae::Renderer::CycleLightingMode()
@@ -252,6 +699,6 @@ bool Renderer::RunTests()
 	assert(int(roundf(Vector3::Dot(Vector3::UnitX, -Vector3::UnitX))) == -1);  // Should be -1 -> opposite direction
 	assert(int(roundf(Vector3::Dot(Vector3::UnitX, Vector3::UnitY))) == 0);  // Should be 0 -> perpendicular direction
 
-
-	return true;
+	// The constructor asserts the result
+	return IsDeltaFrameRoundTripExact();
 }
\ No newline at end of file
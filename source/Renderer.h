@@ -1,23 +1,31 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
-struct SDL_Window;
-struct SDL_Surface;
+#include "FrameBuffer.h"
+#include "FrameSequenceWriter.h"
+#include "FrameWriter.h"
+#include "HeatMap.h"
 
 namespace dae
 {
 	class Scene;
 	struct Camera;
 	struct Light;
+	struct Ray;
 	class Material;
+	class RenderTarget;
+	class ThreadPool;
 
 	class Renderer final
 	{
 	public:
-		Renderer(SDL_Window* pWindow);
-		~Renderer() = default;
+		// Renders at the target's size, the target isn't owned
+		Renderer(RenderTarget* pTarget);
+		~Renderer();
 
 		Renderer(const Renderer&) = delete;
 		Renderer(Renderer&&) noexcept = delete;
@@ -29,35 +37,113 @@ namespace dae
 		void RenderPixel(Scene* pScene, uint32_t pixelIndex, float fov, float aspectRatio, 
 			const Camera& camera, const std::vector<Light>& lights, const std::vector<Material*>& materials) const;
 
-		bool SaveBufferToImage() const;
+		/**
+		 * \brief Renders an image of any size tile by tile, each tile goes to a tiled TIFF as soon as it's done.
+		 * Memory stays at one tile per thread. Tiles that are already in the file from an interrupted run are skipped
+		 * \param tileSize multiple of 16
+		 */
+		bool RenderTiled(Scene* pScene, const std::string& filename, uint32_t width, uint32_t height, uint32_t tileSize = 256) const;
+
+		// Queues the current buffer for the frame writer thread as RayTracing_<timestamp>, false if it couldn't be queued
+		bool SaveBufferToImage();
+		// While capturing, CaptureFrame queues every frame as Capture_<start timestamp>_<frame number>
+		void ToggleFrameCapture();
+		// Also streams the frame to the frame sequence, when one is open
+		void CaptureFrame();
+		// Every frame after this goes into one raw RGB / Y4M stream, path "-" is stdout
+		bool OpenFrameSequence(const std::string& path, SequenceFormat format, uint32_t framesPerSecond);
+		void CloseFrameSequence();
+		void CycleImageFormat();
+		// Writes the float framebuffer as is (linear radiance, before tone mapping) to RayTracing_<timestamp>.pfm
+		bool SaveHDRImage() const;
+		void CycleToneMapping();
+		void ScaleExposure(float factor) { m_Exposure *= factor; }
+
+		// Saves the current frame, the format follows the extension: .ppm/.bmp/.qoi (through the frame writer, waits until it's on disk) or .pfm (HDR)
+		bool SaveImage(const std::string& filename);
+		// 0 = the default scheduler (PPL, or a worker per hardware thread without it), otherwise a pool of exactly that many threads
+		void SetThreadCount(uint32_t threadCount);
+		// Renders the target as the part of a frameWidth x frameHeight frame that starts at (x, y), e.g. one tile of a frame
+		// that's spread over several processes. It may stick out of the frame, the image plane just continues there
+		void SetRegion(uint32_t frameWidth, uint32_t frameHeight, uint32_t x, uint32_t y);
+
+		enum class LightingMode
+		{
+			ObservedArea, // Lambert cosine law
+			Radiance, // Incident Radiance
+			BRDF, // Scattering of the light
+			Combined // ObservedArea & Radiance & BRDF
+		};
 
 		void CycleLightingMode();
+		void SetLightingMode(LightingMode lightingMode) { m_CurrentLightingMode = lightingMode; }
 		void ToggleShadows() { m_ShadowsEnabled = !m_ShadowsEnabled; }
+		void SetShadowsEnabled(bool isEnabled) { m_ShadowsEnabled = isEnabled; }
 		void ToggleReflections() { m_ReflectionsEnabled = !m_ReflectionsEnabled; }
+		void SetReflectionsEnabled(bool isEnabled) { m_ReflectionsEnabled = isEnabled; }
+
+		// What a pixel cost, shown instead of its color. The counts come from RenderStatistics, without it there's only Time
+		enum class HeatMapMode
+		{
+			Off,
+			IntersectionTests, // every primitive test, the triangles of a mesh included
+			NodesVisited, // AABB slab tests: bounding boxes, BVH nodes (meshes & point clouds) and voxel grid bricks & voxels
+			ShadowRays,
+			Time // microseconds
+		};
+
+		void CycleHeatMapMode();
+		void SetHeatMapMode(HeatMapMode heatMapMode);
+		void CycleHeatMapRamp();
+		// At least one color, from cost 0 to the scale
+		void SetHeatMapRamp(const std::vector<ColorRGB>& ramp) { m_HeatMapRamp = ramp; }
+		// Cost at the end of the ramp, 0 = the 99th percentile of every frame
+		void SetHeatMapScale(float scale) { m_HeatMapScale = scale; }
+		float GetHeatMapScale() const { return m_HeatMapScale; }
+		// The raw costs of the last heat map frame as a single channel float map, RayTracing_Cost_<timestamp>.pfm without a filename
+		bool SaveCostBuffer(const std::string& filename = {}) const;
 
 	private:
-		SDL_Window* m_pWindow{};
+		RenderTarget* m_pTarget{};
+		FrameWriter::PixelLayout m_PixelLayout{};
+
+		// Every pixel renders into this first, Render tone maps it into the target at the end
+		std::unique_ptr<FrameBuffer> m_pFrameBuffer{};
+		ToneMapping m_ToneMapping{ ToneMapping::MaxToOne };
+		float m_Exposure{ 1.f };
 
-		SDL_Surface* m_pBuffer{};
-		uint32_t* m_pBufferPixels{};
+		std::unique_ptr<FrameWriter> m_pFrameWriter{};
+		std::unique_ptr<FrameSequenceWriter> m_pSequenceWriter{};
+		ImageFormat m_ImageFormat{ ImageFormat::QOI };
+		bool m_IsCapturing{ false };
+		uint32_t m_CapturedFrameCount{};
+		char m_CapturePrefix[FrameWriter::MaxFilenameLength]{};
 
 		int m_Width{};
 		int m_Height{};
+		// The whole frame & where the target is in it, the same as the target unless SetRegion says otherwise
+		int m_FrameWidth{};
+		int m_FrameHeight{};
+		int m_RegionX{};
+		int m_RegionY{};
 		float m_AspectRatio{};
 		int m_Bounces{ 3 };
 
-		enum class LightingMode
-		{
-			ObservedArea, // Lambert cosine law
-			Radiance, // Incident Radiance
-			BRDF, // Scattering of the light
-			Combined // ObservedArea & Radiance & BRDF
-		};
+		std::unique_ptr<ThreadPool> m_pThreadPool{};
 
 		LightingMode m_CurrentLightingMode{ LightingMode::Combined };
 		bool m_ShadowsEnabled{ true };
 		bool m_ReflectionsEnabled{ false };
 
+		HeatMapMode m_HeatMapMode{ HeatMapMode::Off };
+		std::unique_ptr<HeatMap> m_pHeatMap{};  // once a heat map mode is used
+		HeatMap::Ramp m_HeatMapRampPreset{ HeatMap::Ramp::Heat };
+		std::vector<ColorRGB> m_HeatMapRamp{ HeatMap::GetRamp(HeatMap::Ramp::Heat) };
+		float m_HeatMapScale{};
+
+
+		// Color along a camera ray, including shadows & reflection bounces
+		ColorRGB TraceRay(Scene* pScene, Ray viewRay, const std::vector<Light>& lights, const std::vector<Material*>& materials) const;
 
 		static bool RunTests();
 	};
@@ -2,29 +2,41 @@
 #include "Utils.h"
 #include "Material.h"
 #include "Timer.h"
+#include "MeshUtils.h"
+#include "MeshFile.h"
+#include "PLYParser.h"
+#include "GLBParser.h"
+
+#include <chrono>
+#include <filesystem>
 
 namespace dae
 {
 
 #pragma region Base Scene
 	//Initialize Scene with Default Solid Color Material (RED)
-	Scene::Scene() :
-		m_Materials({ new Material_SolidColor({1,0,0}) })
+	Scene::Scene()
 	{
 		m_SphereGeometries.reserve(32);
 		m_PlaneGeometries.reserve(32);
+		m_BoxGeometries.reserve(32);
+		m_OrientedBoxGeometries.reserve(32);
+		m_DiskGeometries.reserve(32);
+		m_QuadGeometries.reserve(32);
+		m_CylinderGeometries.reserve(32);
+		m_HeightFieldGeometries.reserve(32);
+		m_PointClouds.reserve(32);
+		m_VoxelGrids.reserve(32);
 		m_TriangleMeshGeometries.reserve(32);
 		m_Lights.reserve(32);
+		m_Materials.reserve(32);
+
+		AddMaterial<Material_SolidColor>(ColorRGB{ 1, 0, 0 });
 	}
 
 	Scene::~Scene()
 	{
-		for (auto& pMaterial : m_Materials)
-		{
-			delete pMaterial;
-			pMaterial = nullptr;
-		}
-
+		// Materials are owned (and destroyed) by the scene arena
 		m_Materials.clear();
 	}
 
@@ -57,6 +69,108 @@ namespace dae
 		}
 
 
+		// Analytic primitives
+		const size_t boxGeometriesSize{ m_BoxGeometries.size() };
+		for (size_t i{}; i < boxGeometriesSize; ++i)
+		{
+			HitRecord hitInfo{};
+			GeometryUtils::HitTest_Box(m_BoxGeometries[i], ray, hitInfo);
+			if (hitInfo.t > 0.0f && hitInfo.t < closestHit.t)
+			{
+				closestHit = hitInfo;
+			}
+		}
+
+		const size_t orientedBoxGeometriesSize{ m_OrientedBoxGeometries.size() };
+		for (size_t i{}; i < orientedBoxGeometriesSize; ++i)
+		{
+			// World space AABB first, it's cheaper than moving the ray into box space
+			const OrientedBox& box{ m_OrientedBoxGeometries[i] };
+			if (!GeometryUtils::SlabTest_AABB(box.minAABB, box.maxAABB, ray))
+				continue;
+
+			HitRecord hitInfo{};
+			GeometryUtils::HitTest_OrientedBox(box, ray, hitInfo);
+			if (hitInfo.t > 0.0f && hitInfo.t < closestHit.t)
+			{
+				closestHit = hitInfo;
+			}
+		}
+
+		const size_t diskGeometriesSize{ m_DiskGeometries.size() };
+		for (size_t i{}; i < diskGeometriesSize; ++i)
+		{
+			HitRecord hitInfo{};
+			GeometryUtils::HitTest_Disk(m_DiskGeometries[i], ray, hitInfo);
+			if (hitInfo.t > 0.0f && hitInfo.t < closestHit.t)
+			{
+				closestHit = hitInfo;
+			}
+		}
+
+		const size_t quadGeometriesSize{ m_QuadGeometries.size() };
+		for (size_t i{}; i < quadGeometriesSize; ++i)
+		{
+			HitRecord hitInfo{};
+			GeometryUtils::HitTest_Quad(m_QuadGeometries[i], ray, hitInfo);
+			if (hitInfo.t > 0.0f && hitInfo.t < closestHit.t)
+			{
+				closestHit = hitInfo;
+			}
+		}
+
+		const size_t cylinderGeometriesSize{ m_CylinderGeometries.size() };
+		for (size_t i{}; i < cylinderGeometriesSize; ++i)
+		{
+			const Cylinder& cylinder{ m_CylinderGeometries[i] };
+			if (!GeometryUtils::SlabTest_AABB(cylinder.minAABB, cylinder.maxAABB, ray))
+				continue;
+
+			HitRecord hitInfo{};
+			GeometryUtils::HitTest_Cylinder(cylinder, ray, hitInfo);
+			if (hitInfo.t > 0.0f && hitInfo.t < closestHit.t)
+			{
+				closestHit = hitInfo;
+			}
+		}
+
+		const size_t heightFieldGeometriesSize{ m_HeightFieldGeometries.size() };
+		for (size_t i{}; i < heightFieldGeometriesSize; ++i)
+		{
+			const HeightField& heightField{ m_HeightFieldGeometries[i] };
+			if (!GeometryUtils::SlabTest_AABB(heightField.minAABB, heightField.maxAABB, ray))
+				continue;
+
+			HitRecord hitInfo{};
+			GeometryUtils::HitTest_HeightField(heightField, ray, hitInfo);
+			if (hitInfo.t > 0.0f && hitInfo.t < closestHit.t)
+			{
+				closestHit = hitInfo;
+			}
+		}
+
+		const size_t pointCloudsSize{ m_PointClouds.size() };
+		for (size_t i{}; i < pointCloudsSize; ++i)
+		{
+			HitRecord hitInfo{};
+			GeometryUtils::HitTest_PointCloud(m_PointClouds[i], ray, hitInfo);
+			if (hitInfo.t > 0.0f && hitInfo.t < closestHit.t)
+			{
+				closestHit = hitInfo;
+			}
+		}
+
+		const size_t voxelGridsSize{ m_VoxelGrids.size() };
+		for (size_t i{}; i < voxelGridsSize; ++i)
+		{
+			HitRecord hitInfo{};
+			GeometryUtils::HitTest_VoxelGrid(m_VoxelGrids[i], ray, hitInfo);
+			if (hitInfo.t > 0.0f && hitInfo.t < closestHit.t)
+			{
+				closestHit = hitInfo;
+			}
+		}
+
 		// SINGLE TRIANGLES
 		//const size_t trianglesSize{ m_Triangles.size() };
 		//for (size_t i{}; i < trianglesSize; ++i)
@@ -100,6 +214,54 @@ namespace dae
 				return true;
 		}
 
+		for (const Box& box : m_BoxGeometries)
+		{
+			if (GeometryUtils::HitTest_Box(box, ray))
+				return true;
+		}
+
+		for (const OrientedBox& box : m_OrientedBoxGeometries)
+		{
+			if (GeometryUtils::SlabTest_AABB(box.minAABB, box.maxAABB, ray) && GeometryUtils::HitTest_OrientedBox(box, ray))
+				return true;
+		}
+
+		for (const Disk& disk : m_DiskGeometries)
+		{
+			if (GeometryUtils::HitTest_Disk(disk, ray))
+				return true;
+		}
+
+		for (const Quad& quad : m_QuadGeometries)
+		{
+			if (GeometryUtils::HitTest_Quad(quad, ray))
+				return true;
+		}
+
+		for (const Cylinder& cylinder : m_CylinderGeometries)
+		{
+			if (GeometryUtils::SlabTest_AABB(cylinder.minAABB, cylinder.maxAABB, ray) && GeometryUtils::HitTest_Cylinder(cylinder, ray))
+				return true;
+		}
+
+		for (const HeightField& heightField : m_HeightFieldGeometries)
+		{
+			if (GeometryUtils::SlabTest_AABB(heightField.minAABB, heightField.maxAABB, ray) && GeometryUtils::HitTest_HeightField(heightField, ray))
+				return true;
+		}
+
+		for (const PointCloud& pointCloud : m_PointClouds)
+		{
+			if (GeometryUtils::HitTest_PointCloud(pointCloud, ray))
+				return true;
+		}
+
+		for (const VoxelGrid& voxelGrid : m_VoxelGrids)
+		{
+			if (GeometryUtils::HitTest_VoxelGrid(voxelGrid, ray))
+				return true;
+		}
+
 		for (const Triangle& triangle : m_Triangles)
 		{
 			if (GeometryUtils::HitTest_Triangle(triangle, ray))
@@ -138,6 +300,132 @@ namespace dae
 		return &m_PlaneGeometries.back();
 	}
 
+	Box* Scene::AddBox(const Vector3& minBounds, const Vector3& maxBounds, unsigned char materialIndex)
+	{
+		Box b;
+		b.minBounds = Vector3::Min(minBounds, maxBounds);
+		b.maxBounds = Vector3::Max(minBounds, maxBounds);
+		b.materialIndex = materialIndex;
+
+		m_BoxGeometries.emplace_back(b);
+		return &m_BoxGeometries.back();
+	}
+
+	Box* Scene::AddRoom(const Vector3& minBounds, const Vector3& maxBounds, unsigned char materialIndex)
+	{
+		Box* pRoom{ AddBox(minBounds, maxBounds, materialIndex) };
+		pRoom->isRoom = true;
+		return pRoom;
+	}
+
+	OrientedBox* Scene::AddOrientedBox(const Vector3& center, const Vector3& halfExtents, const Vector3& rotation, unsigned char materialIndex)
+	{
+		// rotation = pitch, yaw, roll in radians
+		const Matrix rotationMatrix{ Matrix::CreateRotation(rotation) };
+
+		OrientedBox b;
+		b.center = center;
+		b.halfExtents = halfExtents;
+		b.axisX = rotationMatrix.GetAxisX().Normalized();
+		b.axisY = rotationMatrix.GetAxisY().Normalized();
+		b.axisZ = rotationMatrix.GetAxisZ().Normalized();
+		b.materialIndex = materialIndex;
+		b.UpdateAABB();
+
+		m_OrientedBoxGeometries.emplace_back(b);
+		return &m_OrientedBoxGeometries.back();
+	}
+
+	Disk* Scene::AddDisk(const Vector3& origin, const Vector3& normal, float radius, unsigned char materialIndex)
+	{
+		Disk d;
+		d.origin = origin;
+		d.normal = normal.Normalized();
+		d.radius = radius;
+		d.materialIndex = materialIndex;
+
+		m_DiskGeometries.emplace_back(d);
+		return &m_DiskGeometries.back();
+	}
+
+	Quad* Scene::AddQuad(const Vector3& origin, const Vector3& edgeU, const Vector3& edgeV, unsigned char materialIndex)
+	{
+		Quad q;
+		q.origin = origin;
+		q.edgeU = edgeU;
+		q.edgeV = edgeV;
+		q.materialIndex = materialIndex;
+		q.UpdateNormal();
+
+		m_QuadGeometries.emplace_back(q);
+		return &m_QuadGeometries.back();
+	}
+
+	Cylinder* Scene::AddCylinder(const Vector3& origin, const Vector3& axis, float radius, float height, bool isCapped, unsigned char materialIndex)
+	{
+		Cylinder c;
+		c.origin = origin;
+		c.axis = axis.Normalized();
+		c.radius = radius;
+		c.height = height;
+		c.isCapped = isCapped;
+		c.materialIndex = materialIndex;
+		c.UpdateAABB();
+
+		m_CylinderGeometries.emplace_back(c);
+		return &m_CylinderGeometries.back();
+	}
+
+	HeightField* Scene::AddHeightField(const Vector3& origin, float cellSize, uint32_t width, uint32_t depth, std::vector<float> heights, unsigned char materialIndex)
+	{
+		assert(heights.size() == size_t(width) * depth && "Expected width * depth height samples");
+
+		HeightField h;
+		h.origin = origin;
+		h.cellSize = cellSize;
+		h.width = width;
+		h.depth = depth;
+		h.heights = std::move(heights);
+		h.materialIndex = materialIndex;
+		h.BuildMinMaxLevels();
+
+		m_HeightFieldGeometries.emplace_back(std::move(h));
+		return &m_HeightFieldGeometries.back();
+	}
+
+	PointCloud* Scene::AddPointCloud(float sharedRadius, unsigned char materialIndex)
+	{
+		PointCloud p{};
+		p.sharedRadius = sharedRadius;
+		p.materialIndex = materialIndex;
+
+		m_PointClouds.emplace_back(std::move(p));
+		return &m_PointClouds.back();
+	}
+
+	PointCloud* Scene::AddPointCloud(const std::string& filename, float sharedRadius, unsigned char materialIndex)
+	{
+		PointCloud* pPointCloud{ AddPointCloud(sharedRadius, materialIndex) };
+		if (!PointCloudUtils::LoadPointCloud(filename, *pPointCloud))
+		{
+			std::cout << "Failed to load point cloud " << filename << '\n';
+			m_PointClouds.pop_back();
+			return nullptr;
+		}
+		return pPointCloud;
+	}
+
+	VoxelGrid* Scene::AddVoxelGrid(const Vector3& origin, float voxelSize, uint32_t voxelsX, uint32_t voxelsY, uint32_t voxelsZ)
+	{
+		VoxelGrid v{};
+		v.origin = origin;
+		v.voxelSize = voxelSize;
+		v.Resize(voxelsX, voxelsY, voxelsZ);
+
+		m_VoxelGrids.emplace_back(std::move(v));
+		return &m_VoxelGrids.back();
+	}
+
 	TriangleMesh* Scene::AddTriangleMesh(TriangleCullMode cullMode, unsigned char materialIndex)
 	{
 		TriangleMesh m{};
@@ -148,6 +436,132 @@ namespace dae
 		return &m_TriangleMeshGeometries.back();
 	}
 
+	bool Scene::LoadMeshFile(const std::string& filename, TriangleMesh& mesh)
+	{
+		std::error_code error{};
+		const std::filesystem::path path{ filename };
+		if (path.extension() == MeshFile::Extension)
+			return MeshFile::Load(filename, mesh);
+
+		if (path.extension() == ".obj")
+		{
+			std::filesystem::path cachePath{ path };
+			cachePath.replace_extension(MeshFile::Extension);
+
+			const bool isCacheValid{ std::filesystem::exists(cachePath, error) &&
+				std::filesystem::last_write_time(cachePath, error) >= std::filesystem::last_write_time(path, error) && !error };
+			if (isCacheValid && MeshFile::Load(cachePath.string(), mesh))
+				return true;
+
+			// A cache that can't be written isn't fatal, the converted mesh is still there
+			return MeshFile::ConvertOBJ(filename, cachePath.string(), mesh) || !mesh.indices.empty();
+		}
+
+		if (path.extension() == ".ply")
+		{
+			// Streamed straight into the mesh, no cache: scans are big and the binary read is already about disk speed
+			PLYParser::PLYData data{};
+			PLYParser::ParseStats stats{};
+			if (!PLYParser::Parse(filename, data, &stats))
+				return false;
+
+			PLYParser::ToTriangleMesh(data, mesh);
+			mesh.UpdateAABB();
+
+			const float megabytes{ stats.fileSize / (1024.f * 1024.f) };
+			std::cout << "Parsed " << filename << ": " << megabytes << "MB in " << stats.seconds << "s ("
+				<< megabytes / std::max(stats.seconds, 1e-6f) << " MB/s), peak " << stats.peakBytes / (1024 * 1024) << "MB\n";
+			return true;
+		}
+
+		if (path.extension() == ".glb")
+		{
+			GLBParser::GLBData data{};
+			if (!GLBParser::Parse(filename, data))
+				return false;
+
+			GLBParser::ToTriangleMesh(data, mesh);
+			MeshUtils::OptimizeMesh(mesh);
+			mesh.UpdateAABB();
+			return true;
+		}
+		return false;
+	}
+
+	TriangleMesh* Scene::AddGLBMesh(const std::string& filename, TriangleCullMode cullMode, unsigned char defaultMaterialIndex)
+	{
+		const auto startTime{ std::chrono::steady_clock::now() };
+
+		GLBParser::GLBData data{};
+		GLBParser::ParseStats stats{};
+		if (!GLBParser::Parse(filename, data, &stats))
+		{
+			std::cout << "Failed to load mesh " << filename << '\n';
+			return nullptr;
+		}
+
+		// Material indices are a byte, the scene can't have more than 256
+		if (m_Materials.size() + data.materials.size() > 256)
+		{
+			std::cout << "Failed to load mesh " << filename << ": its " << data.materials.size() << " materials don't fit next to the scene's "
+				<< m_Materials.size() << " (256 at most)\n";
+			return nullptr;
+		}
+
+		// glTF material -> scene material, the last slot is for primitives without a material
+		std::vector<unsigned char> materialSlots{};
+		for (const GLBParser::GLBMaterial& material : data.materials)
+		{
+			materialSlots.push_back(AddMaterial<Material_CookTorrence>(material.baseColor, material.metalness, std::max(material.roughness, 0.01f)));
+		}
+		materialSlots.push_back(defaultMaterialIndex);
+
+		TriangleMesh* pMesh{ AddTriangleMesh(cullMode, defaultMaterialIndex) };
+		GLBParser::ToTriangleMesh(data, *pMesh);
+		for (unsigned char& material : pMesh->triangleMaterials)
+		{
+			material = material < materialSlots.size() ? materialSlots[material] : defaultMaterialIndex;
+		}
+		// Every primitive has its own copy of the vertices it shares with the others
+		MeshUtils::OptimizeMesh(*pMesh);
+		pMesh->UpdateAABB();
+		pMesh->UpdateTransforms();
+
+		const float milliseconds{ std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count() };
+		std::cout << "Mesh loaded: " << filename << ", " << pMesh->positions.size() << " vertices, " << pMesh->indices.size() / 3
+			<< " triangles, " << stats.primitiveCount << " primitives, " << data.materials.size() << " materials in " << milliseconds << "ms (parse "
+			<< stats.seconds * 1000.f << "ms)\n";
+		return pMesh;
+	}
+
+	TriangleMesh* Scene::AddTriangleMesh(const std::string& filename, TriangleCullMode cullMode, unsigned char materialIndex, const std::vector<unsigned char>& materialSlots)
+	{
+		const auto startTime{ std::chrono::steady_clock::now() };
+		TriangleMesh* pMesh{ AddTriangleMesh(cullMode, materialIndex) };
+
+		if (!LoadMeshFile(filename, *pMesh))
+		{
+			std::cout << "Failed to load mesh " << filename << '\n';
+			m_TriangleMeshGeometries.pop_back();
+			return nullptr;
+		}
+
+		// Material slots of the file to scene materials
+		if (materialSlots.empty())
+			pMesh->triangleMaterials.clear();
+		for (unsigned char& material : pMesh->triangleMaterials)
+		{
+			material = material < materialSlots.size() ? materialSlots[material] : materialIndex;
+		}
+
+		pMesh->UpdateTransforms();
+
+		const float milliseconds{ std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count() };
+		std::cout << "Mesh loaded: " << filename << ", " << pMesh->positions.size() << " vertices, " << pMesh->indices.size() / 3
+			<< " triangles in " << milliseconds << "ms\n";
+		return pMesh;
+	}
+
 	Light* Scene::AddPointLight(const Vector3& origin, float intensity, const ColorRGB& color)
 	{
 		Light l;
@@ -174,6 +588,7 @@ namespace dae
 
 	unsigned char Scene::AddMaterial(Material* pMaterial)
 	{
+		// Pointer has to come from the scene arena (see the AddMaterial template), the scene never deletes it
 		m_Materials.push_back(pMaterial);
 		return static_cast<unsigned char>(m_Materials.size() - 1);
 	}
@@ -185,11 +600,11 @@ namespace dae
 	{
 		//default: Material id0 >> SolidColor Material (RED)
 		constexpr unsigned char matId_Solid_Red = 0;
-		const unsigned char matId_Solid_Blue = AddMaterial(new Material_SolidColor{ colors::Blue });
+		const unsigned char matId_Solid_Blue = AddMaterial<Material_SolidColor>(colors::Blue);
 
-		const unsigned char matId_Solid_Yellow = AddMaterial(new Material_SolidColor{ colors::Yellow });
-		const unsigned char matId_Solid_Green = AddMaterial(new Material_SolidColor{ colors::Green });
-		const unsigned char matId_Solid_Magenta = AddMaterial(new Material_SolidColor{ colors::Magenta });
+		const unsigned char matId_Solid_Yellow = AddMaterial<Material_SolidColor>(colors::Yellow);
+		const unsigned char matId_Solid_Green = AddMaterial<Material_SolidColor>(colors::Green);
+		const unsigned char matId_Solid_Magenta = AddMaterial<Material_SolidColor>(colors::Magenta);
 
 
 		//Spheres
@@ -235,12 +650,12 @@ namespace dae
 
 		// default: Material id0 >> SolidColor Material (RED)
 		constexpr unsigned char matId_Solid_Red = 0;
-		const unsigned char matId_Solid_Blue = AddMaterial(new Material_SolidColor{ colors::Blue });
-		const unsigned char matId_Solid_Yellow = AddMaterial(new Material_SolidColor{ colors::Yellow });
-		const unsigned char matId_Solid_Green = AddMaterial(new Material_SolidColor{ colors::Green });
-		const unsigned char matId_Solid_Magenta = AddMaterial(new Material_SolidColor{ colors::Magenta });
+		const unsigned char matId_Solid_Blue = AddMaterial<Material_SolidColor>(colors::Blue);
+		const unsigned char matId_Solid_Yellow = AddMaterial<Material_SolidColor>(colors::Yellow);
+		const unsigned char matId_Solid_Green = AddMaterial<Material_SolidColor>(colors::Green);
+		const unsigned char matId_Solid_Magenta = AddMaterial<Material_SolidColor>(colors::Magenta);
 
-		matId_Changing_Color = AddMaterial(new Material_SolidColor{ colors::Cyan });
+		matId_Changing_Color = AddMaterial<Material_SolidColor>(colors::Cyan);
 
 		// Planes
 		AddPlane({ -5.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, matId_Solid_Green);
@@ -274,15 +689,15 @@ namespace dae
 		m_Camera.origin = { 0.0f, 3.0f, -9.0f };
 		m_Camera.SetFov(45.0f);
 
-		const auto matCt_GrayRoughMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.96f, 0.915f }, 1.f, 1.f));
-		const auto matCt_GrayMediumMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.96f, 0.915f }, 1.f, 0.6f));
-		const auto matCt_GraySmoothMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.96f, 0.915f }, 1.f, 0.1f));
+		const auto matCt_GrayRoughMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f, 0.96f, 0.915f }, 1.f, 1.f);
+		const auto matCt_GrayMediumMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f, 0.96f, 0.915f }, 1.f, 0.6f);
+		const auto matCt_GraySmoothMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f, 0.96f, 0.915f }, 1.f, 0.1f);
 
-		const auto matCt_GrayRoughPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 1.f));
-		const auto matCt_GrayMediumPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 0.6f));
-		const auto matCt_GraySmoothPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 0.1f));
+		const auto matCt_GrayRoughPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 1.f);
+		const auto matCt_GrayMediumPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 0.6f);
+		const auto matCt_GraySmoothPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 0.1f);
 
-		const auto matLamber_GrayBlue = AddMaterial(new Material_Lambert({ 0.49f, 0.57f, 0.57f }, 1.0f));
+		const auto matLamber_GrayBlue = AddMaterial<Material_Lambert>(ColorRGB{ 0.49f, 0.57f, 0.57f }, 1.0f);
 
 		// Planes
 		AddPlane({ 0.0f, 0.0f, 10.0f }, { 0.0f, 0.0f, -1.0f }, matLamber_GrayBlue);  // BACK
@@ -294,9 +709,9 @@ namespace dae
 		AddPlane({ 0.0f, 0.0f, -100.0f }, { 0.0f, 0.0f, 1.0f }, matLamber_GrayBlue);  // BEHIND
 
 		//// TEMP Lambert-Phone spheres & materials
-		const auto matLambertPhong1 = AddMaterial(new Material_LambertPhong(colors::Blue, 0.5f, 0.5f, 3.0f));
-		const auto matLambertPhong2 = AddMaterial(new Material_LambertPhong(colors::Blue, 0.5f, 0.5f, 15.0f));
-		const auto matLambertPhong3 = AddMaterial(new Material_LambertPhong(colors::Blue, 0.5f, 0.5f, 50.0f));
+		const auto matLambertPhong1 = AddMaterial<Material_LambertPhong>(colors::Blue, 0.5f, 0.5f, 3.0f);
+		const auto matLambertPhong2 = AddMaterial<Material_LambertPhong>(colors::Blue, 0.5f, 0.5f, 15.0f);
+		const auto matLambertPhong3 = AddMaterial<Material_LambertPhong>(colors::Blue, 0.5f, 0.5f, 50.0f);
 
 		//AddSphere(Vector3(-1.75f, 1.0f, 0.f), 0.75f, matLambertPhong1);
 		//AddSphere(Vector3(0.0f, 1.0f, 0.f), 0.75f, matLambertPhong2);
@@ -323,10 +738,10 @@ namespace dae
 		m_Camera.origin = { 0.f, 1.f, -5.0f };
 		m_Camera.SetFov(45.0f);
 
-		const auto matLambert_Red = AddMaterial(new Material_Lambert(colors::Red, 1.f));
-		const auto matLambert_Blue = AddMaterial(new Material_LambertPhong(colors::Blue, 1.f, 1.f, 60.0f));
-		const auto matLambert_Yellow = AddMaterial(new Material_Lambert(colors::Yellow, 1.f));
-		const auto matCt_GraySmoothMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.f, 0.1f));
+		const auto matLambert_Red = AddMaterial<Material_Lambert>(colors::Red, 1.f);
+		const auto matLambert_Blue = AddMaterial<Material_LambertPhong>(colors::Blue, 1.f, 1.f, 60.0f);
+		const auto matLambert_Yellow = AddMaterial<Material_Lambert>(colors::Yellow, 1.f);
+		const auto matCt_GraySmoothMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f, 0.960f, 0.915f }, 1.f, 0.1f);
 
 		//// Triangles
 		//TriangleCullMode cullMode(TriangleCullMode::NoCulling);
@@ -354,8 +769,8 @@ namespace dae
 		m_Camera.SetFov(45.0f);
 
 		// Materials
-		const auto matLambert_GrayBlue = AddMaterial(new Material_Lambert({ .49f, .57f, .57f }, 1.f));
-		const auto matLambert_White = AddMaterial(new Material_Lambert(ColorRGB(colors::White), 1.f));
+		const auto matLambert_GrayBlue = AddMaterial<Material_Lambert>(ColorRGB{ .49f, .57f, .57f }, 1.f);
+		const auto matLambert_White = AddMaterial<Material_Lambert>(ColorRGB(colors::White), 1.f);
 
 		// Planes
 		AddPlane({ 0.f, 0.f, 10.f }, { 0.f, 0.f, -1.f }, matLambert_GrayBlue);  // BACK
@@ -413,16 +828,16 @@ namespace dae
 		m_Camera.SetFov(45.0f);
 
 		// Materials
-		const auto matCt_GrayRoughMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.96f, 0.915f }, 1.f, 1.f));
-		const auto matCt_GrayMediumMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.96f, 0.915f }, 1.f, 0.6f));
-		const auto matCt_GraySmoothMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.96f, 0.915f }, 1.f, 0.1f));
+		const auto matCt_GrayRoughMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f, 0.96f, 0.915f }, 1.f, 1.f);
+		const auto matCt_GrayMediumMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f, 0.96f, 0.915f }, 1.f, 0.6f);
+		const auto matCt_GraySmoothMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f, 0.96f, 0.915f }, 1.f, 0.1f);
 
-		const auto matCt_GrayRoughPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 1.f));
-		const auto matCt_GrayMediumPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 0.6f));
-		const auto matCt_GraySmoothPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 0.1f));
+		const auto matCt_GrayRoughPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 1.f);
+		const auto matCt_GrayMediumPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 0.6f);
+		const auto matCt_GraySmoothPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 0.1f);
 
-		const auto matLambert_GrayBlue = AddMaterial(new Material_Lambert({ 0.49f, 0.57f, 0.57f }, 1.f));
-		const auto matLambert_White = AddMaterial(new Material_Lambert(colors::White, 1.f));
+		const auto matLambert_GrayBlue = AddMaterial<Material_Lambert>(ColorRGB{ 0.49f, 0.57f, 0.57f }, 1.f);
+		const auto matLambert_White = AddMaterial<Material_Lambert>(colors::White, 1.f);
 
 		// Planes
 		AddPlane({ 0.f, 0.f, 10.f }, { 0.f, 0.f, -1.f }, matLambert_GrayBlue);	// BACK
@@ -445,6 +860,7 @@ namespace dae
 
 		m_Meshes[0] = AddTriangleMesh(TriangleCullMode::BackFaceCulling, matLambert_White);
 		m_Meshes[0]->AppendTriangle(baseTriangle, true);
+		MeshUtils::OptimizeMesh(*m_Meshes[0]);
 		m_Meshes[0]->Translate({ -1.75f, 4.5f, 0.f });
 		m_Meshes[0]->CalculateNormals();
 		m_Meshes[0]->UpdateAABB();
@@ -452,6 +868,7 @@ namespace dae
 
 		m_Meshes[1] = AddTriangleMesh(TriangleCullMode::FrontFaceCulling, matLambert_White);
 		m_Meshes[1]->AppendTriangle(baseTriangle, true);
+		MeshUtils::OptimizeMesh(*m_Meshes[1]);
 		m_Meshes[1]->Translate({ 0.f, 4.5f, 0.f });
 		m_Meshes[1]->CalculateNormals();
 		m_Meshes[1]->UpdateAABB();
@@ -459,6 +876,7 @@ namespace dae
 
 		m_Meshes[2] = AddTriangleMesh(TriangleCullMode::NoCulling, matLambert_White);
 		m_Meshes[2]->AppendTriangle(baseTriangle, true);
+		MeshUtils::OptimizeMesh(*m_Meshes[2]);
 		m_Meshes[2]->Translate({ 1.75f, 4.5f, 0.f });
 		m_Meshes[2]->CalculateNormals();
 		m_Meshes[2]->UpdateAABB();
@@ -487,6 +905,199 @@ namespace dae
 		}
 
 	}
+	void Scene_AnalyticPrimitives::Initialize()
+	{
+		sceneName = "Analytic Primitives Scene";
+		m_Camera.origin = { 0.f, 3.f, -9.f };
+		m_Camera.SetFov(45.0f);
+
+		// Materials
+		const auto matCt_GraySmoothMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f, 0.96f, 0.915f }, 1.f, 0.1f);
+		const auto matCt_GrayRoughPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 1.f);
+		const auto matCt_GraySmoothPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 0.1f);
+		const auto matLambert_GrayBlue = AddMaterial<Material_Lambert>(ColorRGB{ 0.49f, 0.57f, 0.57f }, 1.f);
+		const auto matLambert_White = AddMaterial<Material_Lambert>(colors::White, 1.f);
+
+		// One room box instead of 5 planes, closed behind the camera
+		AddRoom({ -5.f, 0.f, -10.f }, { 5.f, 10.f, 10.f }, matLambert_GrayBlue);
+
+		// Props
+		AddBox({ -3.5f, 0.f, 1.f }, { -2.f, 1.5f, 2.5f }, matCt_GrayRoughPlastic);
+		AddOrientedBox({ 0.f, 0.75f, 1.f }, { 0.75f, 0.75f, 0.75f }, { 0.f, PI_DIV_4, 0.f }, matCt_GraySmoothPlastic);
+		AddCylinder({ 2.75f, 0.f, 1.5f }, Vector3::UnitY, 0.75f, 2.f, true, matCt_GraySmoothMetal);
+		AddCylinder({ 0.f, 3.f, 4.f }, Vector3{ 1.f, 0.f, 0.f }, 0.4f, 3.f, false, matCt_GraySmoothMetal);
+
+		AddDisk({ 0.f, 5.f, 9.9f }, { 0.f, 0.f, -1.f }, 1.5f, matLambert_White);
+		AddQuad({ -4.f, 3.f, 9.9f }, { 2.f, 0.f, 0.f }, { 0.f, 2.f, 0.f }, matLambert_White);
+		AddQuad({ 2.f, 3.f, 9.9f }, { 2.f, 0.f, 0.f }, { 0.f, 2.f, 0.f }, matLambert_White);
+
+		// Lights
+		AddPointLight({ 0.f, 5.f, 5.f }, 50.f, { 1.f, .61f, .45f }); // BACKLIGHT
+		AddPointLight({ -2.5f, 5.f, -5.f }, 70.f, { 1.f, .8f, .45f }); // FRONT LIGHT LEFT
+		AddPointLight({ 2.5f, 2.5f, -5.f }, 50.f, { 0.34f, .47f, .68f });
+	}
+
+	void Scene_HeightField::Initialize()
+	{
+		sceneName = m_Triangulate ? "HeightField Scene (triangulated)" : "HeightField Scene";
+		m_Camera.origin = { 0.f, 6.f, -14.f };
+		m_Camera.SetFov(45.0f);
+
+		// Materials
+		const auto matLambert_GrayBlue = AddMaterial<Material_Lambert>(ColorRGB{ 0.49f, 0.57f, 0.57f }, 1.f);
+		const auto matCt_GrayRoughPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 1.f);
+
+		AddPlane({ 0.f, 0.f, 30.f }, { 0.f, 0.f, -1.f }, matLambert_GrayBlue);	// BACK
+
+		// Procedural terrain, 256x256 samples over 24x24 units
+		constexpr uint32_t samples{ 256 };
+		constexpr float cellSize{ 24.f / (samples - 1) };
+		std::vector<float> heights(samples * samples);
+		for (uint32_t z{}; z < samples; ++z)
+		{
+			for (uint32_t x{}; x < samples; ++x)
+			{
+				const float fx{ x * cellSize };
+				const float fz{ z * cellSize };
+				heights[z * samples + x] = 1.5f * sinf(fx * 0.45f) * cosf(fz * 0.35f)
+					+ 0.4f * sinf(fx * 1.7f + fz * 1.3f)
+					+ 0.1f * cosf(fx * 5.3f - fz * 4.1f);
+			}
+		}
+
+		HeightField* pHeightField{ AddHeightField({ -12.f, 0.f, -4.f }, cellSize, samples, samples, std::move(heights), matCt_GrayRoughPlastic) };
+
+		const size_t triangleCount{ size_t(samples - 1) * (samples - 1) * 2 };
+		const size_t meshBytes{ MeshUtils::CalculateMeshMemory(pHeightField->heights.size(), triangleCount, sizeof(int)) };
+		std::cout << "HeightField: " << pHeightField->GetMemoryFootprint() / 1024 << " KB"
+			<< ", triangulated: " << meshBytes / 1024 << " KB (" << triangleCount << " triangles)\n";
+
+		if (m_Triangulate)
+		{
+			TriangleMesh* pMesh{ AddTriangleMesh(TriangleCullMode::NoCulling, matCt_GrayRoughPlastic) };
+			pHeightField->Triangulate(*pMesh);
+			pMesh->UpdateAABB();
+			pMesh->UpdateTransforms();
+			m_HeightFieldGeometries.clear();
+		}
+
+		// Lights
+		AddPointLight({ 0.f, 12.f, -6.f }, 150.f, { 1.f, .8f, .45f });
+		AddPointLight({ -8.f, 8.f, 10.f }, 80.f, { 0.34f, .47f, .68f });
+		AddDirectionalLight(Vector3{ 0.3f, -1.f, 0.4f }.Normalized(), 1.f, colors::White);
+	}
+
+	void Scene_PointCloud::Initialize()
+	{
+		sceneName = "PointCloud Scene";
+		m_Camera.origin = { 0.f, 3.f, -9.f };
+		m_Camera.SetFov(45.0f);
+
+		// Materials
+		const auto matLambert_GrayBlue = AddMaterial<Material_Lambert>(ColorRGB{ 0.49f, 0.57f, 0.57f }, 1.f);
+		const auto matCt_GraySmoothPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 0.1f);
+
+		AddRoom({ -5.f, 0.f, -10.f }, { 5.f, 10.f, 10.f }, matLambert_GrayBlue);
+
+		if (m_Filename.empty() || !AddPointCloud(m_Filename, 0.01f, matCt_GraySmoothPlastic))
+		{
+			// Spiral galaxy, points get denser towards the center
+			PointCloud* pPointCloud{ AddPointCloud(0.01f, matCt_GraySmoothPlastic) };
+			pPointCloud->Reserve(m_PointCount);
+
+			uint32_t seed{ 1 };
+			const auto random = [&seed]()
+				{
+					seed = seed * 1664525u + 1013904223u;
+					return (seed >> 8) / float(1 << 24);
+				};
+
+			for (uint32_t i{}; i < m_PointCount; ++i)
+			{
+				const float distance{ Square(random()) * 4.f };
+				const float angle{ distance * 2.5f + (i % 3) * (PI_2 / 3.f) + random() * 0.6f };
+				const float height{ (random() - 0.5f) * 0.4f * (1.f - distance / 4.f) };
+				pPointCloud->AddPoint({ cosf(angle) * distance, 3.f + height, 2.f + sinf(angle) * distance });
+			}
+			pPointCloud->Build();
+
+			std::cout << "Point cloud generated: " << pPointCloud->GetPointCount() << " points, "
+				<< pPointCloud->GetMemoryFootprint() / (1024 * 1024) << "MB (as Spheres: "
+				<< pPointCloud->GetPointCount() * sizeof(Sphere) / (1024 * 1024) << "MB without acceleration)\n";
+		}
+
+		// Lights
+		AddPointLight({ 0.f, 8.f, 0.f }, 50.f, { 1.f, .8f, .45f });
+		AddPointLight({ -2.5f, 5.f, -5.f }, 70.f, { 1.f, .8f, .45f }); // FRONT LIGHT LEFT
+		AddPointLight({ 2.5f, 2.5f, -5.f }, 50.f, { 0.34f, .47f, .68f });
+	}
+
+	void Scene_Voxels::Initialize()
+	{
+		sceneName = "Voxel Scene";
+		m_Camera.origin = { 0.f, 3.f, -9.f };
+		m_Camera.SetFov(45.0f);
+
+		// Materials, voxels store these indices directly
+		const auto matCt_GraySmoothMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f, 0.96f, 0.915f }, 1.f, 0.1f);
+		const auto matCt_GrayRoughPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 1.f);
+		const auto matLambert_GrayBlue = AddMaterial<Material_Lambert>(ColorRGB{ 0.49f, 0.57f, 0.57f }, 1.f);
+		const auto matLambert_White = AddMaterial<Material_Lambert>(colors::White, 1.f);
+		const auto matLambert_Green = AddMaterial<Material_Lambert>(ColorRGB{ 0.3f, 0.6f, 0.25f }, 1.f);
+		const auto matLambert_Brown = AddMaterial<Material_Lambert>(ColorRGB{ 0.45f, 0.3f, 0.2f }, 1.f);
+
+		AddRoom({ -5.f, 0.f, -10.f }, { 5.f, 10.f, 10.f }, matLambert_GrayBlue);
+
+		// Voxel hill: grass on top of dirt, with a hollow ball floating above it
+		constexpr uint32_t gridSize{ 128 };
+		VoxelGrid* pVoxels{ AddVoxelGrid({ -4.f, 0.f, 0.f }, 8.f / gridSize, gridSize, gridSize, gridSize) };
+		for (uint32_t z{}; z < gridSize; ++z)
+		{
+			for (uint32_t x{}; x < gridSize; ++x)
+			{
+				const float fx{ (x - gridSize * 0.5f) / gridSize };
+				const float fz{ (z - gridSize * 0.5f) / gridSize };
+				const uint32_t height{ static_cast<uint32_t>(gridSize * 0.25f * expf(-8.f * (fx * fx + fz * fz))) };
+				for (uint32_t y{}; y <= height; ++y)
+				{
+					pVoxels->SetVoxel(x, y, z, y == height ? matLambert_Green : matLambert_Brown);
+				}
+			}
+		}
+
+		const Vector3 ballCenter{ gridSize * 0.5f, gridSize * 0.6f, gridSize * 0.5f };
+		for (uint32_t z{}; z < gridSize; ++z)
+		{
+			for (uint32_t y{}; y < gridSize; ++y)
+			{
+				for (uint32_t x{}; x < gridSize; ++x)
+				{
+					const float distance{ (Vector3{ float(x), float(y), float(z) } - ballCenter).Magnitude() };
+					if (distance < gridSize * 0.15f && distance > gridSize * 0.12f)
+						pVoxels->SetVoxel(x, y, z, matCt_GrayRoughPlastic);
+				}
+			}
+		}
+
+		std::cout << "Voxel grid: " << pVoxels->bricks.size() / VoxelGrid::BrickVoxelCount << " bricks in use, "
+			<< pVoxels->GetMemoryFootprint() / 1024 << " KB (dense: " << size_t(gridSize) * gridSize * gridSize / 1024 << " KB)\n";
+
+		// Mixed with regular geometry
+		AddSphere({ -2.5f, 1.f, -2.f }, 1.f, matCt_GraySmoothMetal);
+
+		TriangleMesh* pMesh{ AddTriangleMesh(TriangleCullMode::NoCulling, matLambert_White) };
+		pMesh->positions = { { 2.f, 0.f, -3.f }, { 4.f, 0.f, -3.f }, { 3.f, 0.f, -1.5f }, { 3.f, 2.f, -2.5f } };
+		pMesh->indices = { 0, 1, 3, 1, 2, 3, 2, 0, 3 };
+		pMesh->CalculateNormals();
+		pMesh->UpdateAABB();
+		pMesh->UpdateTransforms();
+
+		// Lights
+		AddPointLight({ 0.f, 5.f, 5.f }, 50.f, { 1.f, .61f, .45f }); // BACKLIGHT
+		AddPointLight({ -2.5f, 5.f, -5.f }, 70.f, { 1.f, .8f, .45f }); // FRONT LIGHT LEFT
+		AddPointLight({ 2.5f, 2.5f, -5.f }, 50.f, { 0.34f, .47f, .68f });
+	}
+
 	void Scene_W4_BunnyScene::Initialize()
 	{
 		sceneName = "Bunny Scene";
@@ -494,16 +1105,16 @@ namespace dae
 		m_Camera.SetFov(45.0f);
 
 		// Materials
-		const auto matCt_GrayRoughMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.96f, 0.915f }, 1.f, 1.f));
-		const auto matCt_GrayMediumMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.96f, 0.915f }, 1.f, 0.6f));
-		const auto matCt_GraySmoothMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.96f, 0.915f }, 1.f, 0.1f));
+		const auto matCt_GrayRoughMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f, 0.96f, 0.915f }, 1.f, 1.f);
+		const auto matCt_GrayMediumMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f, 0.96f, 0.915f }, 1.f, 0.6f);
+		const auto matCt_GraySmoothMetal = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.972f, 0.96f, 0.915f }, 1.f, 0.1f);
 
-		const auto matCt_GrayRoughPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 1.f));
-		const auto matCt_GrayMediumPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 0.6f));
-		const auto matCt_GraySmoothPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 0.1f));
+		const auto matCt_GrayRoughPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 1.f);
+		const auto matCt_GrayMediumPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 0.6f);
+		const auto matCt_GraySmoothPlastic = AddMaterial<Material_CookTorrence>(ColorRGB{ 0.75f, 0.75f, 0.75f }, 0.f, 0.1f);
 
-		const auto matLambert_GrayBlue = AddMaterial(new Material_Lambert({ 0.49f, 0.57f, 0.57f }, 1.f));
-		const auto matLambert_White = AddMaterial(new Material_Lambert(colors::White, 1.f));
+		const auto matLambert_GrayBlue = AddMaterial<Material_Lambert>(ColorRGB{ 0.49f, 0.57f, 0.57f }, 1.f);
+		const auto matLambert_White = AddMaterial<Material_Lambert>(colors::White, 1.f);
 
 		// Planes
 		AddPlane({ 0.f, 0.f, 10.f }, { 0.f, 0.f, -1.f }, matLambert_GrayBlue);	// BACK
@@ -513,8 +1124,9 @@ namespace dae
 		AddPlane({ -5.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, matLambert_GrayBlue);	// LEFT
 
 		// Bunny
-		pMesh = AddTriangleMesh(TriangleCullMode::BackFaceCulling, matLambert_White);
-		Utils::ParseOBJ("Resources/lowpoly_bunny2.obj", pMesh->positions, pMesh->normals, pMesh->indices);
+		// Optimized once when the .bmesh cache gets written, later runs only copy the arrays
+		pMesh = AddTriangleMesh("Resources/lowpoly_bunny2.obj", TriangleCullMode::BackFaceCulling, matLambert_White);
+		MeshUtils::CompressMesh(*pMesh);
 
 		//pMesh->CalculateNormals();
 		pMesh->Scale({ 2.f, 2.f, 2.f });
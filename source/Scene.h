@@ -1,10 +1,15 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "Math.h"
 #include "DataTypes.h"
 #include "Camera.h"
+#include "Arena.h"
+#include "HeightField.h"
+#include "PointCloud.h"
+#include "VoxelGrid.h"
 
 namespace dae
 {
@@ -30,23 +35,42 @@ namespace dae
 		virtual void Initialize() = 0;
 		virtual void Update(dae::Timer* pTimer)
 		{
-			m_Camera.Update(pTimer);
+			// Temporaries from the previous frame are gone by now
+			m_FrameAllocator.Reset();
+			m_Camera.Update(pTimer, m_pInputSource != nullptr ? m_pInputSource->GetCameraInput() : CameraInput{});
 		}
 
 		Camera& GetCamera() { return m_Camera; }
+		// Not owned, nullptr leaves the camera where the scene put it
+		void SetInputSource(InputSource* pInputSource) { m_pInputSource = pInputSource; }
 		void GetClosestHit(const Ray& ray, HitRecord& closestHit) const;
 		bool DoesHit(const Ray& ray) const;
 
 		const std::vector<Plane>& GetPlaneGeometries() const { return m_PlaneGeometries; }
 		const std::vector<Sphere>& GetSphereGeometries() const { return m_SphereGeometries; }
 		const std::vector<Light>& GetLights() const { return m_Lights; }
-		const std::vector<Material*> GetMaterials() const { return m_Materials; }
+		const std::vector<Material*>& GetMaterials() const { return m_Materials; }
+
+		// Per frame scratch memory, reset at the start of every Update
+		LinearAllocator& GetFrameAllocator() { return m_FrameAllocator; }
 
 	protected:
+		// Owns the materials, declared first so it outlives everything that points into it
+		SceneArena m_SceneArena{};
+		LinearAllocator m_FrameAllocator{};
+
 		std::string	sceneName;
 
 		std::vector<Plane> m_PlaneGeometries{};
 		std::vector<Sphere> m_SphereGeometries{};
+		std::vector<Box> m_BoxGeometries{};
+		std::vector<OrientedBox> m_OrientedBoxGeometries{};
+		std::vector<Disk> m_DiskGeometries{};
+		std::vector<Quad> m_QuadGeometries{};
+		std::vector<Cylinder> m_CylinderGeometries{};
+		std::vector<HeightField> m_HeightFieldGeometries{};
+		std::vector<PointCloud> m_PointClouds{};
+		std::vector<VoxelGrid> m_VoxelGrids{};
 		std::vector<TriangleMesh> m_TriangleMeshGeometries{};
 		std::vector<Light> m_Lights{};
 		std::vector<Material*> m_Materials{};
@@ -55,14 +79,51 @@ namespace dae
 		std::vector<Triangle> m_Triangles{};
 
 		Camera m_Camera{};
+		InputSource* m_pInputSource{};
 
 		Sphere* AddSphere(const Vector3& origin, float radius, unsigned char materialIndex = 0);
 		Plane* AddPlane(const Vector3& origin, const Vector3& normal, unsigned char materialIndex = 0);
+		Box* AddBox(const Vector3& minBounds, const Vector3& maxBounds, unsigned char materialIndex = 0);
+		Box* AddRoom(const Vector3& minBounds, const Vector3& maxBounds, unsigned char materialIndex = 0);
+		OrientedBox* AddOrientedBox(const Vector3& center, const Vector3& halfExtents, const Vector3& rotation, unsigned char materialIndex = 0);
+		Disk* AddDisk(const Vector3& origin, const Vector3& normal, float radius, unsigned char materialIndex = 0);
+		Quad* AddQuad(const Vector3& origin, const Vector3& edgeU, const Vector3& edgeV, unsigned char materialIndex = 0);
+		Cylinder* AddCylinder(const Vector3& origin, const Vector3& axis, float radius, float height, bool isCapped = true, unsigned char materialIndex = 0);
+		HeightField* AddHeightField(const Vector3& origin, float cellSize, uint32_t width, uint32_t depth, std::vector<float> heights, unsigned char materialIndex = 0);
+		// Empty cloud, add the points and call Build() on it
+		PointCloud* AddPointCloud(float sharedRadius, unsigned char materialIndex = 0);
+		// Loads and builds, nullptr if the file couldn't be read
+		PointCloud* AddPointCloud(const std::string& filename, float sharedRadius, unsigned char materialIndex = 0);
+		// Empty grid of (at least) voxelsX * voxelsY * voxelsZ voxels, fill it with SetVoxel
+		VoxelGrid* AddVoxelGrid(const Vector3& origin, float voxelSize, uint32_t voxelsX, uint32_t voxelsY, uint32_t voxelsZ);
 		TriangleMesh* AddTriangleMesh(TriangleCullMode cullMode, unsigned char materialIndex = 0);
+		/**
+		 * \brief Loads a .bmesh, or an .obj through a .bmesh next to it (converted on first use, reused while newer than the .obj)
+		 * a binary little endian .ply (streamed, not cached) or a .glb (geometry only, see AddGLBMesh for its materials).
+		 * AABB & transforms are up to date afterwards
+		 * \param materialSlots scene material per material slot of the file, without it the whole mesh uses materialIndex
+		 * \return nullptr if the file couldn't be loaded
+		 */
+		TriangleMesh* AddTriangleMesh(const std::string& filename, TriangleCullMode cullMode, unsigned char materialIndex = 0, const std::vector<unsigned char>& materialSlots = {});
+		// Fills positions, normals, indices, triangleMaterials & the AABB from a .bmesh/.obj/.ply/.glb, safe to call from several threads
+		static bool LoadMeshFile(const std::string& filename, TriangleMesh& mesh);
+		/**
+		 * \brief Loads a .glb with its materials: every glTF material becomes a Material_CookTorrence (base color, metallic & roughness factors),
+		 * primitives without one use defaultMaterialIndex. The nodes are baked into one mesh, Translate/RotateY/Scale place the whole model
+		 * \return nullptr if the file couldn't be loaded or its materials don't fit in the scene's 256
+		 */
+		TriangleMesh* AddGLBMesh(const std::string& filename, TriangleCullMode cullMode, unsigned char defaultMaterialIndex = 0);
 
 		Light* AddPointLight(const Vector3& origin, float intensity, const ColorRGB& color);
 		Light* AddDirectionalLight(const Vector3& direction, float intensity, const ColorRGB& color);
 		unsigned char AddMaterial(Material* pMaterial);
+
+		// Constructs the material inside the scene arena
+		template<typename T, typename... Args>
+		unsigned char AddMaterial(Args&&... args)
+		{
+			return AddMaterial(m_SceneArena.New<T>(std::forward<Args>(args)...));
+		}
 	};
 
 	//+++++++++++++++++++++++++++++++++++++++++
@@ -175,6 +236,79 @@ namespace dae
 
 	};
 
+	//+++++++++++++++++++++++++++++++++++++++++
+	//Analytic Primitives Scene
+	class Scene_AnalyticPrimitives final : public Scene
+	{
+	public:
+		Scene_AnalyticPrimitives() = default;
+		~Scene_AnalyticPrimitives() override = default;
+
+		Scene_AnalyticPrimitives(const Scene_AnalyticPrimitives&) = delete;
+		Scene_AnalyticPrimitives(Scene_AnalyticPrimitives&&) noexcept = delete;
+		Scene_AnalyticPrimitives& operator=(const Scene_AnalyticPrimitives&) = delete;
+		Scene_AnalyticPrimitives& operator=(Scene_AnalyticPrimitives&&) noexcept = delete;
+
+		void Initialize() override;
+	};
+
+	//+++++++++++++++++++++++++++++++++++++++++
+	//HeightField Scene
+	class Scene_HeightField final : public Scene
+	{
+	public:
+		// triangulate: render the same terrain as a regular triangle mesh, to compare speed and memory
+		explicit Scene_HeightField(bool triangulate = false) : m_Triangulate{ triangulate } {}
+		~Scene_HeightField() override = default;
+
+		Scene_HeightField(const Scene_HeightField&) = delete;
+		Scene_HeightField(Scene_HeightField&&) noexcept = delete;
+		Scene_HeightField& operator=(const Scene_HeightField&) = delete;
+		Scene_HeightField& operator=(Scene_HeightField&&) noexcept = delete;
+
+		void Initialize() override;
+
+	private:
+		bool m_Triangulate{};
+	};
+
+	//+++++++++++++++++++++++++++++++++++++++++
+	//PointCloud Scene
+	class Scene_PointCloud final : public Scene
+	{
+	public:
+		// Without a file a procedural cloud of pointCount points is generated
+		explicit Scene_PointCloud(const std::string& filename = "", uint32_t pointCount = 1'000'000) : m_Filename{ filename }, m_PointCount{ pointCount } {}
+		~Scene_PointCloud() override = default;
+
+		Scene_PointCloud(const Scene_PointCloud&) = delete;
+		Scene_PointCloud(Scene_PointCloud&&) noexcept = delete;
+		Scene_PointCloud& operator=(const Scene_PointCloud&) = delete;
+		Scene_PointCloud& operator=(Scene_PointCloud&&) noexcept = delete;
+
+		void Initialize() override;
+
+	private:
+		std::string m_Filename{};
+		uint32_t m_PointCount{};
+	};
+
+	//+++++++++++++++++++++++++++++++++++++++++
+	//Voxel Scene
+	class Scene_Voxels final : public Scene
+	{
+	public:
+		Scene_Voxels() = default;
+		~Scene_Voxels() override = default;
+
+		Scene_Voxels(const Scene_Voxels&) = delete;
+		Scene_Voxels(Scene_Voxels&&) noexcept = delete;
+		Scene_Voxels& operator=(const Scene_Voxels&) = delete;
+		Scene_Voxels& operator=(Scene_Voxels&&) noexcept = delete;
+
+		void Initialize() override;
+	};
+
 	//+++++++++++++++++++++++++++++++++++++++++
 	//WEEK 4 Reference Scene
 	class Scene_W4_BunnyScene final : public Scene
@@ -196,4 +330,49 @@ namespace dae
 
 	};
 
+	//+++++++++++++++++++++++++++++++++++++++++
+	//Scene loaded from a text file (.scene), see Resources/reference.scene for the format
+	class Scene_File final : public Scene
+	{
+	public:
+		explicit Scene_File(const std::string& filename) : m_Filename{ filename } {}
+		~Scene_File() override = default;
+
+		Scene_File(const Scene_File&) = delete;
+		Scene_File(Scene_File&&) noexcept = delete;
+		Scene_File& operator=(const Scene_File&) = delete;
+		Scene_File& operator=(Scene_File&&) noexcept = delete;
+
+		// Parses the file in one pass, the meshes it references get loaded in parallel afterwards
+		void Initialize() override;
+		void Update(dae::Timer* pTimer) override;
+
+	private:
+		enum class AnimationType
+		{
+			Spin,   // yaw += speed * time
+			Swing,  // yaw back and forth between 0 and 2 PI
+			Bob     // up and down, amplitude in world units
+		};
+
+		struct Animation
+		{
+			AnimationType type{};
+			bool isSphere{};
+			size_t index{};  // into the sphere or mesh geometries, pointers don't survive the vectors growing
+			Vector3 basePosition{};
+			float baseYaw{};
+			float amplitude{};
+			float speed{};
+		};
+
+		struct ParseState;
+
+		std::string m_Filename{};
+		std::vector<Animation> m_Animations{};
+
+		// false (with state.error filled in) when the statement is invalid
+		bool ParseStatement(const std::vector<std::string_view>& tokens, ParseState& state);
+	};
+
 }
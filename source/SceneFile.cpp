@@ -0,0 +1,540 @@
+#include "Scene.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <unordered_map>
+
+#include "MappedFile.h"
+#include "Material.h"
+#include "MeshUtils.h"
+#include "Timer.h"
+
+namespace dae
+{
+	namespace
+	{
+		// Splits a line on whitespace, everything after a '#' is a comment
+		void Tokenize(std::string_view line, std::vector<std::string_view>& tokens)
+		{
+			tokens.clear();
+			size_t position{};
+			while (position < line.size())
+			{
+				const char character{ line[position] };
+				if (character == '#')
+					break;
+				if (character == ' ' || character == '\t' || character == '\r')
+				{
+					++position;
+					continue;
+				}
+
+				const size_t start{ position };
+				while (position < line.size() && line[position] != ' ' && line[position] != '\t' && line[position] != '\r' && line[position] != '#')
+				{
+					++position;
+				}
+				tokens.push_back(line.substr(start, position - start));
+			}
+		}
+
+		// Reads the arguments of a statement left to right, after the first failure IsValid stays false
+		class ArgumentReader final
+		{
+		public:
+			explicit ArgumentReader(const std::vector<std::string_view>& tokens) : m_Tokens{ tokens } {}
+			~ArgumentReader() = default;
+
+			ArgumentReader(const ArgumentReader&) = delete;
+			ArgumentReader(ArgumentReader&&) noexcept = delete;
+			ArgumentReader& operator=(const ArgumentReader&) = delete;
+			ArgumentReader& operator=(ArgumentReader&&) noexcept = delete;
+
+			bool HasNext() const { return m_Next < m_Tokens.size(); }
+			bool IsValid() const { return m_IsValid; }
+
+			std::string_view Next()
+			{
+				if (!HasNext())
+				{
+					m_IsValid = false;
+					return {};
+				}
+				return m_Tokens[m_Next++];
+			}
+
+			float NextFloat()
+			{
+				const std::string_view token{ Next() };
+				float value{};
+				const auto [pEnd, error] { std::from_chars(token.data(), token.data() + token.size(), value) };
+				m_IsValid &= error == std::errc{} && pEnd == token.data() + token.size() && !token.empty();
+				return value;
+			}
+
+			Vector3 NextVector()
+			{
+				const float x{ NextFloat() };
+				const float y{ NextFloat() };
+				const float z{ NextFloat() };
+				return { x, y, z };
+			}
+
+			ColorRGB NextColor()
+			{
+				const Vector3 color{ NextVector() };
+				return { color.x, color.y, color.z };
+			}
+
+		private:
+			const std::vector<std::string_view>& m_Tokens;
+			size_t m_Next{ 1 };  // 0 is the keyword
+			bool m_IsValid{ true };
+		};
+
+		struct MeshRequest
+		{
+			std::string path{};
+			size_t meshIndex{};
+		};
+	}
+
+	struct Scene_File::ParseState
+	{
+		std::filesystem::path directory{};  // mesh paths are relative to the scene file
+		std::unordered_map<std::string, unsigned char> materials{};
+		std::vector<MeshRequest> meshRequests{};
+		std::string error{};
+	};
+
+	void Scene_File::Initialize()
+	{
+		const auto startTime{ std::chrono::steady_clock::now() };
+		sceneName = m_Filename;
+
+		MappedFile file{ m_Filename };
+		if (!file.IsOpen())
+		{
+			std::cout << "Couldn't open scene file " << m_Filename << '\n';
+			return;
+		}
+
+		ParseState state{};
+		state.directory = std::filesystem::path{ m_Filename }.parent_path();
+
+		// Single pass: every statement is added to the scene as soon as its line is read, only mesh files are deferred
+		std::vector<std::string_view> tokens{};
+		tokens.reserve(32);
+		const std::string_view text{ file.GetData(), file.GetSize() };
+		int errorCount{};
+		int lineNumber{};
+		size_t lineStart{};
+		while (lineStart < text.size())
+		{
+			size_t lineEnd{ text.find('\n', lineStart) };
+			if (lineEnd == std::string_view::npos)
+				lineEnd = text.size();
+			++lineNumber;
+
+			Tokenize(text.substr(lineStart, lineEnd - lineStart), tokens);
+			lineStart = lineEnd + 1;
+			if (tokens.empty())
+				continue;
+
+			if (!ParseStatement(tokens, state))
+			{
+				// Bad statements are skipped, the rest of the scene still loads
+				std::cout << m_Filename << '(' << lineNumber << "): " << state.error << '\n';
+				++errorCount;
+			}
+		}
+		const auto parseTime{ std::chrono::steady_clock::now() };
+
+		// Every file once, each on its own thread, then copied to the meshes that use it
+		std::unordered_map<std::string, std::vector<size_t>> meshesPerFile{};
+		for (const MeshRequest& request : state.meshRequests)
+		{
+			meshesPerFile[request.path].push_back(request.meshIndex);
+		}
+
+		std::vector<std::pair<const std::string*, std::future<TriangleMesh>>> loads{};
+		loads.reserve(meshesPerFile.size());
+		for (const auto& [path, meshIndices] : meshesPerFile)
+		{
+			loads.emplace_back(&path, std::async(std::launch::async, [&path]
+				{
+					TriangleMesh mesh{};
+					if (!LoadMeshFile(path, mesh))
+						mesh = TriangleMesh{};
+					return mesh;
+				}));
+		}
+
+		for (auto& [pPath, load] : loads)
+		{
+			const TriangleMesh loaded{ load.get() };
+			if (loaded.indices.empty())
+			{
+				std::cout << "Failed to load mesh " << *pPath << '\n';
+				++errorCount;
+			}
+
+			for (size_t meshIndex : meshesPerFile[*pPath])
+			{
+				// Material slots aren't mapped in scene files, the whole mesh uses its material
+				TriangleMesh& mesh{ m_TriangleMeshGeometries[meshIndex] };
+				mesh.positions = loaded.positions;
+				mesh.normals = loaded.normals;
+				mesh.indices = loaded.indices;
+				mesh.minAABB = loaded.minAABB;
+				mesh.maxAABB = loaded.maxAABB;
+				mesh.UpdateTransforms();
+			}
+		}
+
+		const auto endTime{ std::chrono::steady_clock::now() };
+		const size_t objectCount{ m_PlaneGeometries.size() + m_SphereGeometries.size() + m_BoxGeometries.size() + m_DiskGeometries.size() +
+			m_QuadGeometries.size() + m_CylinderGeometries.size() + m_TriangleMeshGeometries.size() };
+		const auto toMilliseconds{ [](auto duration) { return std::chrono::duration<float, std::milli>(duration).count(); } };
+		std::cout << "Scene loaded: " << m_Filename << ", " << objectCount << " objects, " << meshesPerFile.size() << " mesh files, "
+			<< errorCount << " errors in " << toMilliseconds(endTime - startTime) << "ms (parse " << toMilliseconds(parseTime - startTime)
+			<< "ms, meshes " << toMilliseconds(endTime - parseTime) << "ms)\n";
+	}
+
+	void Scene_File::Update(dae::Timer* pTimer)
+	{
+		Scene::Update(pTimer);
+
+		const float time{ pTimer->GetTotal() };
+		for (const Animation& animation : m_Animations)
+		{
+			const Vector3 bobOffset{ 0.f, animation.amplitude * sinf(time * animation.speed), 0.f };
+			if (animation.isSphere)
+			{
+				m_SphereGeometries[animation.index].origin = animation.basePosition + bobOffset;
+				continue;
+			}
+
+			TriangleMesh& mesh{ m_TriangleMeshGeometries[animation.index] };
+			switch (animation.type)
+			{
+			case AnimationType::Spin:
+				mesh.RotateY(animation.baseYaw + time * animation.speed);
+				break;
+			case AnimationType::Swing:
+				mesh.RotateY(animation.baseYaw + (cosf(time * animation.speed) + 1.f) / 2.f * PI_2);
+				break;
+			case AnimationType::Bob:
+				mesh.Translate(animation.basePosition + bobOffset);
+				break;
+			}
+			mesh.UpdateTransforms();
+		}
+	}
+
+	bool Scene_File::ParseStatement(const std::vector<std::string_view>& tokens, ParseState& state)
+	{
+		const std::string_view keyword{ tokens[0] };
+		ArgumentReader reader{ tokens };
+
+		// Options shared by the objects: material <name>, cull back|front|none, position x y z, yaw degrees, scale s,
+		// spin speed, swing speed, bob amplitude speed
+		unsigned char materialIndex{};
+		TriangleCullMode cullMode{ TriangleCullMode::BackFaceCulling };
+		Vector3 position{};
+		float yaw{};
+		float scale{ 1.f };
+		std::vector<Animation> animations{};
+		const auto parseOptions{ [&]
+			{
+				while (reader.HasNext() && reader.IsValid())
+				{
+					const std::string_view option{ reader.Next() };
+					if (option == "material")
+					{
+						const auto it{ state.materials.find(std::string{ reader.Next() }) };
+						if (it == state.materials.end())
+						{
+							state.error = "unknown material";
+							return false;
+						}
+						materialIndex = it->second;
+					}
+					else if (option == "cull")
+					{
+						const std::string_view mode{ reader.Next() };
+						if (mode == "back") cullMode = TriangleCullMode::BackFaceCulling;
+						else if (mode == "front") cullMode = TriangleCullMode::FrontFaceCulling;
+						else if (mode == "none") cullMode = TriangleCullMode::NoCulling;
+						else
+						{
+							state.error = "cull has to be back, front or none";
+							return false;
+						}
+					}
+					else if (option == "position")
+						position = reader.NextVector();
+					else if (option == "yaw")
+						yaw = reader.NextFloat() * TO_RADIANS;
+					else if (option == "scale")
+						scale = reader.NextFloat();
+					else if (option == "spin")
+						animations.push_back({ AnimationType::Spin, false, 0, {}, 0.f, 0.f, reader.NextFloat() });
+					else if (option == "swing")
+						animations.push_back({ AnimationType::Swing, false, 0, {}, 0.f, 0.f, reader.NextFloat() });
+					else if (option == "bob")
+					{
+						const float amplitude{ reader.NextFloat() };
+						animations.push_back({ AnimationType::Bob, false, 0, {}, 0.f, amplitude, reader.NextFloat() });
+					}
+					else
+					{
+						state.error = "unknown option " + std::string{ option };
+						return false;
+					}
+				}
+
+				if (!reader.IsValid())
+					state.error = "missing or invalid value";
+				return reader.IsValid();
+			} };
+
+		const auto addMeshAnimations{ [&](size_t meshIndex)
+			{
+				for (Animation& animation : animations)
+				{
+					animation.index = meshIndex;
+					animation.basePosition = position;
+					animation.baseYaw = yaw;
+					m_Animations.push_back(animation);
+				}
+			} };
+
+		if (keyword == "name")
+		{
+			// The rest of the line, spaces included
+			sceneName.clear();
+			for (size_t i{ 1 }; i < tokens.size(); ++i)
+			{
+				sceneName += (i > 1 ? " " : "") + std::string{ tokens[i] };
+			}
+			return true;
+		}
+
+		if (keyword == "camera")
+		{
+			// camera x y z [fov degrees] [yaw degrees] [pitch degrees]
+			m_Camera.origin = reader.NextVector();
+			m_Camera.SetFov(reader.HasNext() ? reader.NextFloat() : 45.f);
+			m_Camera.totalYaw = reader.HasNext() ? reader.NextFloat() : 0.f;
+			m_Camera.totalPitch = reader.HasNext() ? reader.NextFloat() : 0.f;
+			state.error = "camera x y z [fov] [yaw] [pitch]";
+			return reader.IsValid() && !reader.HasNext();
+		}
+
+		if (keyword == "material")
+		{
+			// material name solid|lambert|phong|cooktorrance r g b [parameters]
+			const std::string name{ reader.Next() };
+			const std::string_view type{ reader.Next() };
+			const ColorRGB color{ reader.NextColor() };
+			if (m_Materials.size() > 255)
+			{
+				state.error = "too many materials, the limit is 256";
+				return false;
+			}
+
+			// The whole line first, the arena never gives back what a rejected line would have taken
+			size_t parameterCount{};
+			if (type == "lambert")
+				parameterCount = 1;
+			else if (type == "phong")
+				parameterCount = 3;
+			else if (type == "cooktorrance")
+				parameterCount = 2;
+			float parameters[3]{};
+			for (size_t i{}; i < parameterCount; ++i)
+				parameters[i] = reader.NextFloat();
+
+			const bool isKnownType{ type == "solid" || parameterCount > 0 };
+			if (!isKnownType || !reader.IsValid() || reader.HasNext())
+			{
+				state.error = "material name solid|lambert|phong|cooktorrance r g b [kd] [ks exponent] [metalness roughness]";
+				return false;
+			}
+
+			Material* pMaterial{ nullptr };
+			if (type == "solid")
+				pMaterial = m_SceneArena.New<Material_SolidColor>(color);
+			else if (type == "lambert")
+				pMaterial = m_SceneArena.New<Material_Lambert>(color, parameters[0]);
+			else if (type == "phong")
+				pMaterial = m_SceneArena.New<Material_LambertPhong>(color, parameters[0], parameters[1], parameters[2]);
+			else
+				pMaterial = m_SceneArena.New<Material_CookTorrence>(color, parameters[0], parameters[1]);
+			state.materials[name] = AddMaterial(pMaterial);
+			return true;
+		}
+
+		if (keyword == "pointlight" || keyword == "directionallight")
+		{
+			// pointlight x y z intensity r g b, directionallight dx dy dz intensity r g b
+			const Vector3 vector{ reader.NextVector() };
+			const float intensity{ reader.NextFloat() };
+			const ColorRGB color{ reader.NextColor() };
+			if (!reader.IsValid() || reader.HasNext())
+			{
+				state.error = std::string{ keyword } + " x y z intensity r g b";
+				return false;
+			}
+
+			if (keyword == "pointlight")
+				AddPointLight(vector, intensity, color);
+			else
+				AddDirectionalLight(vector.Normalized(), intensity, color);
+			return true;
+		}
+
+		if (keyword == "sphere")
+		{
+			// sphere x y z radius [options]
+			const Vector3 origin{ reader.NextVector() };
+			const float radius{ reader.NextFloat() };
+			if (!parseOptions())
+				return false;
+			if (std::any_of(animations.begin(), animations.end(), [](const Animation& animation) { return animation.type != AnimationType::Bob; }))
+			{
+				state.error = "spheres can only bob";
+				return false;
+			}
+
+			AddSphere(origin, radius, materialIndex);
+			for (Animation& animation : animations)
+			{
+				animation.isSphere = true;
+				animation.index = m_SphereGeometries.size() - 1;
+				animation.basePosition = origin;
+				m_Animations.push_back(animation);
+			}
+			return true;
+		}
+
+		if (keyword == "plane")
+		{
+			// plane x y z nx ny nz [material]
+			const Vector3 origin{ reader.NextVector() };
+			const Vector3 normal{ reader.NextVector() };
+			if (!parseOptions())
+				return false;
+			AddPlane(origin, normal.Normalized(), materialIndex);
+			return true;
+		}
+
+		if (keyword == "box" || keyword == "room")
+		{
+			// box minX minY minZ maxX maxY maxZ [material], a room is a box seen from the inside
+			const Vector3 minBounds{ reader.NextVector() };
+			const Vector3 maxBounds{ reader.NextVector() };
+			if (!parseOptions())
+				return false;
+
+			if (keyword == "box")
+				AddBox(minBounds, maxBounds, materialIndex);
+			else
+				AddRoom(minBounds, maxBounds, materialIndex);
+			return true;
+		}
+
+		if (keyword == "disk")
+		{
+			// disk x y z nx ny nz radius [material]
+			const Vector3 origin{ reader.NextVector() };
+			const Vector3 normal{ reader.NextVector() };
+			const float radius{ reader.NextFloat() };
+			if (!parseOptions())
+				return false;
+			AddDisk(origin, normal.Normalized(), radius, materialIndex);
+			return true;
+		}
+
+		if (keyword == "quad")
+		{
+			// quad x y z ux uy uz vx vy vz [material]
+			const Vector3 origin{ reader.NextVector() };
+			const Vector3 edgeU{ reader.NextVector() };
+			const Vector3 edgeV{ reader.NextVector() };
+			if (!parseOptions())
+				return false;
+			AddQuad(origin, edgeU, edgeV, materialIndex);
+			return true;
+		}
+
+		if (keyword == "cylinder")
+		{
+			// cylinder x y z ax ay az radius height [material]
+			const Vector3 origin{ reader.NextVector() };
+			const Vector3 axis{ reader.NextVector() };
+			const float radius{ reader.NextFloat() };
+			const float height{ reader.NextFloat() };
+			if (!parseOptions())
+				return false;
+			AddCylinder(origin, axis.Normalized(), radius, height, true, materialIndex);
+			return true;
+		}
+
+		if (keyword == "triangle")
+		{
+			// triangle x0 y0 z0 x1 y1 z1 x2 y2 z2 [options], a mesh of its own so it can be transformed & animated
+			Triangle triangle{};
+			triangle.v0 = reader.NextVector();
+			triangle.v1 = reader.NextVector();
+			triangle.v2 = reader.NextVector();
+			if (!parseOptions())
+				return false;
+
+			TriangleMesh* pMesh{ AddTriangleMesh(cullMode, materialIndex) };
+			pMesh->AppendTriangle(triangle, true);
+			MeshUtils::OptimizeMesh(*pMesh);
+			pMesh->Translate(position);
+			pMesh->RotateY(yaw);
+			pMesh->Scale(scale);
+			pMesh->CalculateNormals();
+			pMesh->UpdateAABB();
+			pMesh->UpdateTransforms();
+			addMeshAnimations(m_TriangleMeshGeometries.size() - 1);
+			return true;
+		}
+
+		if (keyword == "mesh")
+		{
+			// mesh path [options], .obj/.bmesh/.ply/.glb
+			std::filesystem::path path{ std::string{ reader.Next() } };
+			if (!reader.IsValid())
+			{
+				state.error = "mesh path [options]";
+				return false;
+			}
+			if (!parseOptions())
+				return false;
+
+			if (path.is_relative())
+				path = state.directory / path;
+
+			// Geometry comes later, once all files are loaded
+			TriangleMesh* pMesh{ AddTriangleMesh(cullMode, materialIndex) };
+			pMesh->Translate(position);
+			pMesh->RotateY(yaw);
+			pMesh->Scale(scale);
+			state.meshRequests.push_back({ path.string(), m_TriangleMeshGeometries.size() - 1 });
+			addMeshAnimations(m_TriangleMeshGeometries.size() - 1);
+			return true;
+		}
+
+		state.error = "unknown statement " + std::string{ keyword };
+		return false;
+	}
+}
@@ -0,0 +1,300 @@
+#include "SharedMemoryRenderTarget.h"
+
+#include <algorithm>
+#include <climits>
+#include <new>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <ctime>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		constexpr uint64_t PageSize{ 4096 };
+
+		uint64_t AlignToPage(uint64_t size)
+		{
+			return (size + PageSize - 1) & ~(PageSize - 1);
+		}
+
+		uint64_t GetSlotsOffset()
+		{
+			return sizeof(SharedFrames::Header);
+		}
+
+		uint64_t GetPixelsOffset(uint32_t slotCount)
+		{
+			return AlignToPage(GetSlotsOffset() + uint64_t(slotCount) * sizeof(SharedFrames::Slot));
+		}
+
+#if defined(_WIN32)
+		// Local\ keeps it in this login session, Global\ would need extra rights
+		std::string GetMappingName(const std::string& name)
+		{
+			return "Local\\" + name;
+		}
+#else
+		std::string GetMappingName(const std::string& name)
+		{
+			return name.rfind('/', 0) == 0 ? name : "/" + name;
+		}
+#endif
+	}
+
+	SharedMemoryRenderTarget::SharedMemoryRenderTarget(const std::string& name, uint32_t width, uint32_t height, uint32_t slotCount,
+		const FrameWriter::PixelLayout& layout) :
+		m_Name{ GetMappingName(name) },
+		m_Width{ width },
+		m_Height{ height },
+		m_Layout{ layout }
+	{
+		slotCount = std::max(2u, slotCount);
+		const uint64_t slotSize{ AlignToPage(uint64_t(width) * height * sizeof(uint32_t)) };
+		const uint64_t size{ GetPixelsOffset(slotCount) + slotCount * slotSize };
+
+		void* pMemory{};
+#if defined(_WIN32)
+		m_pMappingHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+			static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), m_Name.c_str());
+		// Someone else has that name, we'd get their mapping with their size & layout
+		if (m_pMappingHandle != nullptr && GetLastError() == ERROR_ALREADY_EXISTS)
+		{
+			CloseHandle(m_pMappingHandle);
+			m_pMappingHandle = nullptr;
+			m_IsNameTaken = true;
+		}
+		if (m_pMappingHandle == nullptr)
+			return;
+		pMemory = MapViewOfFile(m_pMappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+		if (pMemory == nullptr)
+		{
+			CloseHandle(m_pMappingHandle);
+			m_pMappingHandle = nullptr;
+			return;
+		}
+#else
+		// A new object instead of resizing the old one, readers that still have that mapped would crash on it
+		shm_unlink(m_Name.c_str());
+		const int file{ shm_open(m_Name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600) };
+		if (file < 0)
+			return;
+		if (ftruncate(file, static_cast<off_t>(size)) != 0)
+		{
+			close(file);
+			shm_unlink(m_Name.c_str());
+			return;
+		}
+		pMemory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		close(file);
+		if (pMemory == MAP_FAILED)
+		{
+			shm_unlink(m_Name.c_str());
+			return;
+		}
+#endif
+
+		m_pHeader = new (pMemory) SharedFrames::Header{};
+		m_pHeader->version = SharedFrames::Version;
+		m_pHeader->width = width;
+		m_pHeader->height = height;
+		m_pHeader->slotCount = slotCount;
+		m_pHeader->redShift = layout.redShift;
+		m_pHeader->greenShift = layout.greenShift;
+		m_pHeader->blueShift = layout.blueShift;
+		m_pHeader->alphaMask = layout.alphaMask;
+		m_pHeader->size = size;
+		for (uint32_t i{}; i < slotCount; ++i)
+		{
+			SharedFrames::Slot* pSlot{ new (static_cast<uint8_t*>(pMemory) + GetSlotsOffset() + i * sizeof(SharedFrames::Slot)) SharedFrames::Slot{} };
+			pSlot->pixelOffset = GetPixelsOffset(slotCount) + i * slotSize;
+		}
+
+		// Readers check this first, it's only there once the rest is
+		std::atomic_thread_fence(std::memory_order_release);
+		m_pHeader->magic = SharedFrames::Magic;
+	}
+
+	SharedMemoryRenderTarget::~SharedMemoryRenderTarget()
+	{
+		if (m_pHeader == nullptr)
+			return;
+
+#if defined(_WIN32)
+		UnmapViewOfFile(m_pHeader);
+		CloseHandle(m_pMappingHandle);
+#else
+		munmap(m_pHeader, m_pHeader->size);
+		shm_unlink(m_Name.c_str());
+#endif
+	}
+
+	uint32_t* SharedMemoryRenderTarget::BeginFrame()
+	{
+		m_Slot = static_cast<uint32_t>(m_FrameCount % m_pHeader->slotCount);
+
+		// Odd: readers leave it alone from here on
+		SharedFrames::Slot& slot{ GetSlot(m_Slot) };
+		slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		return GetSlotPixels(m_Slot);
+	}
+
+	void SharedMemoryRenderTarget::Present()
+	{
+		const auto now{ std::chrono::steady_clock::now() };
+		SharedFrames::Slot& slot{ GetSlot(m_Slot) };
+		slot.frameNumber = ++m_FrameCount;
+		slot.presentNanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count());
+		slot.frameNanoseconds = m_FrameCount > 1 ? static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_PresentTime).count()) : 0;
+		m_PresentTime = now;
+
+		// Even again, then the frame counts as published
+		slot.sequence.store(slot.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		m_pHeader->publishedCount.store(m_FrameCount, std::memory_order_release);
+		m_pHeader->futex.store(static_cast<uint32_t>(m_FrameCount), std::memory_order_release);
+#if defined(__linux__)
+		syscall(SYS_futex, &m_pHeader->futex, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+	}
+
+	SharedFrames::Slot& SharedMemoryRenderTarget::GetSlot(uint32_t slot) const
+	{
+		return reinterpret_cast<SharedFrames::Slot*>(reinterpret_cast<uint8_t*>(m_pHeader) + GetSlotsOffset())[slot];
+	}
+
+	uint32_t* SharedMemoryRenderTarget::GetSlotPixels(uint32_t slot) const
+	{
+		return reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(m_pHeader) + GetSlot(slot).pixelOffset);
+	}
+
+	SharedFrameReader::~SharedFrameReader()
+	{
+		Close();
+	}
+
+	bool SharedFrameReader::Open(const std::string& name)
+	{
+		Close();
+		const std::string mappingName{ GetMappingName(name) };
+
+		const void* pMemory{};
+		size_t size{};
+#if defined(_WIN32)
+		m_pMappingHandle = OpenFileMappingA(FILE_MAP_READ, FALSE, mappingName.c_str());
+		if (m_pMappingHandle == nullptr)
+			return false;
+		pMemory = MapViewOfFile(m_pMappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (pMemory == nullptr)
+		{
+			Close();
+			return false;
+		}
+		MEMORY_BASIC_INFORMATION information{};
+		VirtualQuery(pMemory, &information, sizeof(information));
+		size = information.RegionSize;
+#else
+		const int file{ shm_open(mappingName.c_str(), O_RDONLY, 0) };
+		if (file < 0)
+			return false;
+		struct stat status{};
+		if (fstat(file, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(SharedFrames::Header)))
+		{
+			close(file);
+			return false;
+		}
+		size = static_cast<size_t>(status.st_size);
+		pMemory = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+		close(file);
+		if (pMemory == MAP_FAILED)
+			return false;
+#endif
+
+		m_pHeader = static_cast<const SharedFrames::Header*>(pMemory);
+		m_Size = size;
+		const bool isValid{ m_pHeader->magic == SharedFrames::Magic && m_pHeader->version == SharedFrames::Version && m_pHeader->size <= size };
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (!isValid)
+			Close();
+		return isValid;
+	}
+
+	void SharedFrameReader::Close()
+	{
+#if defined(_WIN32)
+		if (m_pHeader != nullptr)
+			UnmapViewOfFile(m_pHeader);
+		if (m_pMappingHandle != nullptr)
+			CloseHandle(m_pMappingHandle);
+		m_pMappingHandle = nullptr;
+#else
+		if (m_pHeader != nullptr)
+			munmap(const_cast<SharedFrames::Header*>(m_pHeader), m_Size);
+#endif
+		m_pHeader = nullptr;
+		m_Size = 0;
+	}
+
+	bool SharedFrameReader::WaitForFrame(uint64_t lastFrameNumber, int timeoutMilliseconds, Frame& frame) const
+	{
+		const auto deadline{ std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMilliseconds) };
+		while (true)
+		{
+			const uint64_t publishedCount{ m_pHeader->publishedCount.load(std::memory_order_acquire) };
+			if (publishedCount > lastFrameNumber)
+			{
+				frame.slot = static_cast<uint32_t>((publishedCount - 1) % m_pHeader->slotCount);
+				const SharedFrames::Slot& slot{ GetSlot(frame.slot) };
+				frame.sequence = slot.sequence.load(std::memory_order_acquire);
+				frame.frameNumber = slot.frameNumber;
+				frame.presentNanoseconds = slot.presentNanoseconds;
+				frame.frameNanoseconds = slot.frameNanoseconds;
+				frame.pPixels = reinterpret_cast<const uint32_t*>(reinterpret_cast<const uint8_t*>(m_pHeader) + slot.pixelOffset);
+
+				// Otherwise the renderer is in that slot already: there's a newer frame, look again
+				if ((frame.sequence & 1) == 0 && IsIntact(frame) && frame.frameNumber == publishedCount)
+					return true;
+				continue;
+			}
+
+			const auto remaining{ deadline - std::chrono::steady_clock::now() };
+			if (remaining <= std::chrono::nanoseconds::zero())
+				return false;
+
+#if defined(__linux__)
+			// Sleeps until Present changes the word (or right away when it already did)
+			const auto remainingNanoseconds{ std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count() };
+			const timespec timeout{ static_cast<time_t>(remainingNanoseconds / 1000000000), static_cast<long>(remainingNanoseconds % 1000000000) };
+			syscall(SYS_futex, &m_pHeader->futex, FUTEX_WAIT, static_cast<uint32_t>(publishedCount), &timeout, nullptr, 0);
+#else
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+		}
+	}
+
+	bool SharedFrameReader::IsIntact(const Frame& frame) const
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return GetSlot(frame.slot).sequence.load(std::memory_order_relaxed) == frame.sequence;
+	}
+
+	const SharedFrames::Slot& SharedFrameReader::GetSlot(uint32_t slot) const
+	{
+		return reinterpret_cast<const SharedFrames::Slot*>(reinterpret_cast<const uint8_t*>(m_pHeader) + GetSlotsOffset())[slot];
+	}
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "RenderTarget.h"
+
+namespace dae
+{
+	// What's in the shared memory, for programs that read the frames. Fixed layout, nothing but plain fields & lock free atomics:
+	// [Header][Slot * slotCount] then the pixels of every slot, each starting on a 4KB boundary
+	namespace SharedFrames
+	{
+		constexpr uint32_t Magic{ 0x42465452 };  // "RTFB"
+		constexpr uint32_t Version{ 1 };
+
+		struct Slot
+		{
+			// Seqlock: odd while the renderer writes the pixels. What a reader got is only complete when
+			// the sequence was the same even number before & after reading it
+			std::atomic<uint32_t> sequence;
+			uint32_t padding;
+			uint64_t frameNumber;          // 1 for the first frame
+			uint64_t presentNanoseconds;   // steady clock when it was done
+			uint64_t frameNanoseconds;     // since the frame before it, 0 for the first
+			uint64_t pixelOffset;          // from the start of the shared memory
+		};
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t width;
+			uint32_t height;
+			uint32_t slotCount;
+			// 32 bit pixels, rows top to bottom without padding
+			uint32_t redShift;
+			uint32_t greenShift;
+			uint32_t blueShift;
+			uint32_t alphaMask;
+			uint32_t padding;
+			uint64_t size;                         // of the whole shared memory
+			std::atomic<uint64_t> publishedCount;  // frames done so far, the newest is in slot (publishedCount - 1) % slotCount
+			std::atomic<uint32_t> futex;           // low 32 bits of publishedCount, Linux readers can FUTEX_WAIT on it
+		};
+
+		static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+			"Atomics in shared memory have to be lock free");
+	}
+
+	// Frames go straight into a ring of buffers in named shared memory (POSIX shm_open, a file mapping on Windows),
+	// other processes map it and read finished frames without a copy or a pipe in between.
+	// The renderer tone maps into the next slot, while the slots before it stay untouched for slotCount - 1 frames
+	class SharedMemoryRenderTarget final : public RenderTarget
+	{
+	public:
+		// Creates the shared memory with this name, IsOpen says whether that worked.
+		// POSIX replaces an object that's already there (readers keep the old one until they unmap it),
+		// a Windows mapping can't be replaced: the name is taken as long as any process still has it open
+		SharedMemoryRenderTarget(const std::string& name, uint32_t width, uint32_t height, uint32_t slotCount = 3,
+			const FrameWriter::PixelLayout& layout = { 16, 8, 0, 0xFF000000 });
+		// Readers that still have it mapped keep it, the name is gone
+		~SharedMemoryRenderTarget() override;
+
+		bool IsOpen() const { return m_pHeader != nullptr; }
+		// Why it's not open on Windows: another renderer or a reader still has this name
+		bool IsNameTaken() const { return m_IsNameTaken; }
+
+		uint32_t GetWidth() const override { return m_Width; }
+		uint32_t GetHeight() const override { return m_Height; }
+		uint32_t* GetPixels() override { return GetSlotPixels(m_Slot); }
+		FrameWriter::PixelLayout GetLayout() const override { return m_Layout; }
+		uint32_t* BeginFrame() override;
+		void Present() override;
+
+	private:
+		std::string m_Name{};
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		FrameWriter::PixelLayout m_Layout{};
+
+		SharedFrames::Header* m_pHeader{};
+		void* m_pMappingHandle{};  // Windows only
+		bool m_IsNameTaken{};
+		uint32_t m_Slot{};
+		uint64_t m_FrameCount{};
+		std::chrono::steady_clock::time_point m_PresentTime{};
+
+		SharedFrames::Slot& GetSlot(uint32_t slot) const;
+		uint32_t* GetSlotPixels(uint32_t slot) const;
+	};
+
+	// The other end: maps a SharedMemoryRenderTarget's memory read only and hands out pointers into it
+	class SharedFrameReader final
+	{
+	public:
+		struct Frame
+		{
+			const uint32_t* pPixels{};
+			uint64_t frameNumber{};
+			uint64_t presentNanoseconds{};
+			uint64_t frameNanoseconds{};
+			uint32_t slot{};
+			uint32_t sequence{};
+		};
+
+		SharedFrameReader() = default;
+		~SharedFrameReader();
+
+		SharedFrameReader(const SharedFrameReader&) = delete;
+		SharedFrameReader(SharedFrameReader&&) noexcept = delete;
+		SharedFrameReader& operator=(const SharedFrameReader&) = delete;
+		SharedFrameReader& operator=(SharedFrameReader&&) noexcept = delete;
+
+		bool Open(const std::string& name);
+		void Close();
+		// Size, pixel layout & slot count, nullptr when it's not open
+		const SharedFrames::Header* GetHeader() const { return m_pHeader; }
+
+		/**
+		 * \brief Waits for a frame newer than lastFrameNumber and points frame at the newest one
+		 * (frames in between are skipped when the reader is slower than the renderer)
+		 * \param lastFrameNumber 0 takes any frame
+		 * \return false when nothing new came in time
+		 */
+		bool WaitForFrame(uint64_t lastFrameNumber, int timeoutMilliseconds, Frame& frame) const;
+		// True when the renderer didn't start overwriting the frame's slot yet, check after using the pixels
+		bool IsIntact(const Frame& frame) const;
+
+	private:
+		const SharedFrames::Header* m_pHeader{};
+		size_t m_Size{};
+		void* m_pMappingHandle{};  // Windows only
+
+		const SharedFrames::Slot& GetSlot(uint32_t slot) const;
+	};
+}
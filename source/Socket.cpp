@@ -0,0 +1,186 @@
+#include "Socket.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <csignal>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+namespace dae
+{
+	namespace
+	{
+#if defined(_WIN32)
+		void CloseSocket(Socket::Handle handle) { closesocket(handle); }
+#else
+		void CloseSocket(Socket::Handle handle) { close(handle); }
+#endif
+
+		// Frames go out in one send after their header, no need to wait for more data (Nagle)
+		void DisableDelay(Socket::Handle handle)
+		{
+			const int isEnabled{ 1 };
+			setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&isEnabled), sizeof(isEnabled));
+		}
+	}
+
+	Socket::~Socket()
+	{
+		Close();
+	}
+
+	bool Socket::Startup()
+	{
+#if defined(_WIN32)
+		WSADATA data{};
+		return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+		std::signal(SIGPIPE, SIG_IGN);
+		return true;
+#endif
+	}
+
+	void Socket::Cleanup()
+	{
+#if defined(_WIN32)
+		WSACleanup();
+#endif
+	}
+
+	bool Socket::Listen(const std::string& address, uint16_t port, int backlog)
+	{
+		Close();
+		m_Handle = static_cast<Handle>(socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+		if (m_Handle == InvalidHandle)
+			return false;
+
+		// A restarted server gets its port back right away instead of after TIME_WAIT
+#if !defined(_WIN32)
+		const int isEnabled{ 1 };
+		setsockopt(m_Handle, SOL_SOCKET, SO_REUSEADDR, &isEnabled, sizeof(isEnabled));
+#endif
+
+		sockaddr_in socketAddress{};
+		socketAddress.sin_family = AF_INET;
+		socketAddress.sin_port = htons(port);
+		if (inet_pton(AF_INET, address.c_str(), &socketAddress.sin_addr) != 1
+			|| bind(m_Handle, reinterpret_cast<const sockaddr*>(&socketAddress), sizeof(socketAddress)) != 0 || listen(m_Handle, backlog) != 0)
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	bool Socket::Accept(Socket& client, int timeoutMilliseconds)
+	{
+		client.Close();
+
+		fd_set readable{};
+		FD_ZERO(&readable);
+		FD_SET(m_Handle, &readable);
+		timeval timeout{ timeoutMilliseconds / 1000, (timeoutMilliseconds % 1000) * 1000 };
+		if (select(static_cast<int>(m_Handle) + 1, &readable, nullptr, nullptr, &timeout) <= 0)
+			return false;
+
+		client.m_Handle = static_cast<Handle>(accept(m_Handle, nullptr, nullptr));
+		if (!client.IsOpen())
+			return false;
+
+		DisableDelay(client.m_Handle);
+		return true;
+	}
+
+	bool Socket::Connect(const std::string& host, uint16_t port)
+	{
+		Close();
+
+		addrinfo hints{};
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+		addrinfo* pAddresses{};
+		if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &pAddresses) != 0)
+			return false;
+
+		for (const addrinfo* pAddress{ pAddresses }; pAddress != nullptr && !IsOpen(); pAddress = pAddress->ai_next)
+		{
+			m_Handle = static_cast<Handle>(socket(pAddress->ai_family, pAddress->ai_socktype, pAddress->ai_protocol));
+			if (IsOpen() && connect(m_Handle, pAddress->ai_addr, static_cast<int>(pAddress->ai_addrlen)) != 0)
+				Close();
+		}
+		freeaddrinfo(pAddresses);
+
+		if (!IsOpen())
+			return false;
+
+		DisableDelay(m_Handle);
+		return true;
+	}
+
+	bool Socket::SendAll(const void* pData, size_t size)
+	{
+		const char* pBytes{ static_cast<const char*>(pData) };
+		while (size > 0)
+		{
+			// Winsock takes an int
+			const int chunkSize{ static_cast<int>(std::min<size_t>(size, 1 << 30)) };
+			const auto sentSize{ send(m_Handle, pBytes, chunkSize, 0) };
+			if (sentSize <= 0)
+				return false;
+
+			pBytes += sentSize;
+			size -= static_cast<size_t>(sentSize);
+		}
+		return true;
+	}
+
+	bool Socket::SetSendTimeout(int timeoutMilliseconds)
+	{
+#if defined(_WIN32)
+		const DWORD timeout{ static_cast<DWORD>(timeoutMilliseconds) };
+#else
+		const timeval timeout{ timeoutMilliseconds / 1000, (timeoutMilliseconds % 1000) * 1000 };
+#endif
+		return setsockopt(m_Handle, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout)) == 0;
+	}
+
+	int64_t Socket::Receive(void* pData, size_t size)
+	{
+		const int chunkSize{ static_cast<int>(std::min<size_t>(size, 1 << 30)) };
+		const auto receivedSize{ recv(m_Handle, static_cast<char*>(pData), chunkSize, 0) };
+		return receivedSize < 0 ? -1 : static_cast<int64_t>(receivedSize);
+	}
+
+	void Socket::Shutdown()
+	{
+		if (!IsOpen())
+			return;
+#if defined(_WIN32)
+		shutdown(m_Handle, SD_BOTH);
+#else
+		shutdown(m_Handle, SHUT_RDWR);
+#endif
+	}
+
+	void Socket::Close()
+	{
+		if (IsOpen())
+		{
+			CloseSocket(m_Handle);
+			m_Handle = InvalidHandle;
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dae
+{
+	// Blocking TCP socket, Winsock or BSD sockets underneath. Closes itself when it goes out of scope
+	class Socket final
+	{
+	public:
+#if defined(_WIN32)
+		using Handle = uintptr_t;  // SOCKET
+#else
+		using Handle = int;
+#endif
+		static constexpr Handle InvalidHandle{ static_cast<Handle>(~0) };
+
+		Socket() = default;
+		~Socket();
+
+		Socket(const Socket&) = delete;
+		Socket(Socket&&) noexcept = delete;
+		Socket& operator=(const Socket&) = delete;
+		Socket& operator=(Socket&&) noexcept = delete;
+
+		// Once per process before any socket gets opened (WSAStartup, and a closed peer doesn't raise SIGPIPE)
+		static bool Startup();
+		static void Cleanup();
+
+		// IPv4 address like "127.0.0.1" (only this machine can connect) or "0.0.0.0" (every interface)
+		bool Listen(const std::string& address, uint16_t port, int backlog = 16);
+		/**
+		 * \brief Waits for a connection on a listening socket
+		 * \param timeoutMilliseconds how long to wait, so the caller can check whether it should stop in between
+		 * \return false on a timeout or an error, client stays closed
+		 */
+		bool Accept(Socket& client, int timeoutMilliseconds);
+		// Host name or IPv4 address
+		bool Connect(const std::string& host, uint16_t port);
+
+		// Keeps sending until everything is out, false when the connection broke or a send timed out
+		bool SendAll(const void* pData, size_t size);
+		// A send that can't get anything out for that long fails instead of blocking, 0 = wait forever (the default)
+		bool SetSendTimeout(int timeoutMilliseconds);
+		// Up to size bytes, 0 when the peer closed the connection, -1 on an error
+		int64_t Receive(void* pData, size_t size);
+
+		// Wakes up a Receive that's blocking on another thread, the handle stays valid until Close
+		void Shutdown();
+		void Close();
+		bool IsOpen() const { return m_Handle != InvalidHandle; }
+
+	private:
+		Handle m_Handle{ InvalidHandle };
+	};
+}
@@ -0,0 +1,97 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+#include "MemoryTracker.h"
+
+namespace dae
+{
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		for (uint32_t i{ 1 }; i < threadCount; ++i)
+		{
+			m_Threads.emplace_back(&ThreadPool::WorkerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_LoopStarted.notify_all();
+		for (std::thread& thread : m_Threads)
+		{
+			thread.join();
+		}
+	}
+
+	ThreadPool& ThreadPool::GetShared()
+	{
+		static ThreadPool pool{ std::max(1u, std::thread::hardware_concurrency()) };
+		return pool;
+	}
+
+	void ThreadPool::Run(uint32_t begin, uint32_t end, uint32_t grainSize, Task task, const void* pFunction)
+	{
+		if (begin >= end)
+			return;
+
+		std::lock_guard runLock{ m_RunMutex };
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_Task = task;
+			m_pFunction = pFunction;
+			m_End = end;
+			m_GrainSize = std::max(grainSize, 1u);
+			m_NextIndex = begin;
+			m_IsTracking = MemoryTracker::IsTracking();
+			m_BusyCount = static_cast<uint32_t>(m_Threads.size());
+			++m_Generation;
+		}
+		m_LoopStarted.notify_all();
+
+		Work();
+
+		// Everything is handed out, wait for the workers that are still on their last chunk
+		std::unique_lock lock{ m_Mutex };
+		m_LoopFinished.wait(lock, [this] { return m_BusyCount == 0; });
+	}
+
+	void ThreadPool::Work()
+	{
+		for (uint32_t first{ m_NextIndex.fetch_add(m_GrainSize) }; first < m_End; first = m_NextIndex.fetch_add(m_GrainSize))
+		{
+			const uint32_t last{ std::min(m_End, first + m_GrainSize) };
+			for (uint32_t index{ first }; index < last; ++index)
+			{
+				m_Task(m_pFunction, index);
+			}
+		}
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		uint64_t generation{};
+		std::unique_lock lock{ m_Mutex };
+		while (true)
+		{
+			m_LoopStarted.wait(lock, [&] { return m_Generation != generation || m_IsStopping; });
+			if (m_IsStopping)
+				return;
+			generation = m_Generation;
+			const bool isTracking{ m_IsTracking };
+
+			lock.unlock();
+			{
+				MemoryTracker::ScopedTracking tracking{ isTracking };
+				Work();
+			}
+			lock.lock();
+
+			if (--m_BusyCount == 0)
+				m_LoopFinished.notify_one();
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	// Fixed set of worker threads for data parallel loops, the stand-in for concurrency::parallel_for where there's no PPL.
+	// A loop doesn't allocate: the function is passed by pointer and the indices are handed out in chunks from an atomic counter
+	class ThreadPool final
+	{
+	public:
+		// threadCount includes the thread that calls ParallelFor, it works along
+		explicit ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		/**
+		 * \brief Calls function(index) for every index in [begin, end) and returns when all of them are done.
+		 * Loops from different threads take turns
+		 * \param grainSize indices a thread takes at once
+		 */
+		template<typename Function>
+		void ParallelFor(uint32_t begin, uint32_t end, const Function& function, uint32_t grainSize = 64)
+		{
+			const Task task{ [](const void* pFunction, uint32_t index) { (*static_cast<const Function*>(pFunction))(index); } };
+			Run(begin, end, grainSize, task, &function);
+		}
+
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Threads.size()) + 1; }
+
+		// One worker per hardware thread, started on first use
+		static ThreadPool& GetShared();
+
+	private:
+		using Task = void(*)(const void* pFunction, uint32_t index);
+
+		std::vector<std::thread> m_Threads{};
+
+		// The current loop
+		Task m_Task{};
+		const void* m_pFunction{};
+		uint32_t m_End{};
+		uint32_t m_GrainSize{};
+		std::atomic<uint32_t> m_NextIndex{};
+		bool m_IsTracking{};  // the caller counts its allocations (MemoryTracker), so do the workers during its loop
+
+		uint64_t m_Generation{};  // +1 per loop, wakes the workers
+		uint32_t m_BusyCount{};   // workers that haven't finished the current loop
+		bool m_IsStopping{};
+
+		std::mutex m_RunMutex{};  // one loop at a time
+		std::mutex m_Mutex{};
+		std::condition_variable m_LoopStarted{};
+		std::condition_variable m_LoopFinished{};
+
+		void Run(uint32_t begin, uint32_t end, uint32_t grainSize, Task task, const void* pFunction);
+		void Work();
+		void WorkerLoop();
+	};
+}
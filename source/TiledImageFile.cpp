@@ -0,0 +1,203 @@
+#include "TiledImageFile.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace dae
+{
+	namespace
+	{
+		enum TiffType : uint16_t
+		{
+			Short = 3,
+			Long = 4,
+			Undefined = 7
+		};
+
+		// Private tags (65000 - 65535) are free to use, readers skip the ones they don't know
+		constexpr uint16_t DoneFlagsTag{ 65000 };
+		constexpr uint16_t EntryCount{ 12 };
+		constexpr uint64_t IfdOffset{ 8 };
+
+		// fseek only takes a long, which is 32 bit on Windows
+		bool SeekTo(std::FILE* pFile, uint64_t offset)
+		{
+#if defined(_WIN32)
+			return _fseeki64(pFile, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+			return fseeko(pFile, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+		}
+	}
+
+	TiledImageFile::~TiledImageFile()
+	{
+		Close();
+	}
+
+	bool TiledImageFile::Open(const std::string& filename, uint32_t width, uint32_t height, uint32_t tileSize)
+	{
+		Close();
+		if (width == 0 || height == 0 || tileSize == 0 || tileSize % 16 != 0)
+			return false;
+
+		m_TileSize = tileSize;
+		m_TilesX = (width + tileSize - 1) / tileSize;
+		m_TilesY = (height + tileSize - 1) / tileSize;
+		const std::vector<uint8_t> header{ BuildHeader(width, height) };
+		if (header.empty())
+			return false;
+
+		m_DoneFlags.assign(GetTileCount(), 0);
+		m_IsResumed = false;
+
+		// Same header apart from the done flags: same image, continue it
+		m_pFile = std::fopen(filename.c_str(), "r+b");
+		if (m_pFile != nullptr)
+		{
+			std::vector<uint8_t> existing(header.size());
+			const bool isMatch{ std::fread(existing.data(), 1, existing.size(), m_pFile) == existing.size()
+				&& std::equal(header.begin(), header.begin() + m_FlagsOffset, existing.begin())
+				&& std::equal(header.begin() + m_FlagsOffset + GetTileCount(), header.end(), existing.begin() + m_FlagsOffset + GetTileCount()) };
+			if (isMatch)
+			{
+				for (uint32_t i{}; i < GetTileCount(); ++i)
+				{
+					m_DoneFlags[i] = existing[m_FlagsOffset + i] != 0;
+				}
+				m_IsResumed = GetDoneCount() > 0;
+				return true;
+			}
+			std::fclose(m_pFile);
+		}
+
+		m_pFile = std::fopen(filename.c_str(), "w+b");
+		if (m_pFile == nullptr)
+			return false;
+
+		// Writing the last byte makes the file its full size, every tile reads as black until it's written
+		const uint64_t fileSize{ m_TilesOffset + uint64_t(GetTileCount()) * tileSize * tileSize * 3 };
+		if (std::fwrite(header.data(), 1, header.size(), m_pFile) != header.size()
+			|| !SeekTo(m_pFile, fileSize - 1) || std::fputc(0, m_pFile) == EOF || std::fflush(m_pFile) != 0)
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void TiledImageFile::Close()
+	{
+		std::lock_guard lock{ m_Mutex };
+		if (m_pFile != nullptr)
+		{
+			std::fclose(m_pFile);
+			m_pFile = nullptr;
+		}
+	}
+
+	bool TiledImageFile::WriteTile(uint32_t tileIndex, const uint8_t* pPixels)
+	{
+		const size_t tileBytes{ size_t(m_TileSize) * m_TileSize * 3 };
+
+		std::lock_guard lock{ m_Mutex };
+		if (m_pFile == nullptr || tileIndex >= GetTileCount())
+			return false;
+
+		// Pixels first, flag after: a tile is never marked done without its pixels in the file
+		if (!SeekTo(m_pFile, m_TilesOffset + uint64_t(tileIndex) * tileBytes)
+			|| std::fwrite(pPixels, 1, tileBytes, m_pFile) != tileBytes || std::fflush(m_pFile) != 0)
+			return false;
+		if (!SeekTo(m_pFile, m_FlagsOffset + tileIndex) || std::fputc(1, m_pFile) == EOF || std::fflush(m_pFile) != 0)
+			return false;
+
+		m_DoneFlags[tileIndex] = 1;
+		return true;
+	}
+
+	bool TiledImageFile::IsTileDone(uint32_t tileIndex) const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return m_DoneFlags[tileIndex] != 0;
+	}
+
+	uint32_t TiledImageFile::GetDoneCount() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return static_cast<uint32_t>(std::count(m_DoneFlags.begin(), m_DoneFlags.end(), uint8_t{ 1 }));
+	}
+
+	std::vector<uint8_t> TiledImageFile::BuildHeader(uint32_t width, uint32_t height)
+	{
+		const uint32_t tileCount{ GetTileCount() };
+		std::vector<uint8_t> header(IfdOffset + 2 + EntryCount * 12 + 4);
+
+		const auto put16{ [&header](uint64_t position, uint32_t value)
+			{
+				header[position] = static_cast<uint8_t>(value);
+				header[position + 1] = static_cast<uint8_t>(value >> 8);
+			} };
+		const auto put32{ [&header](uint64_t position, uint32_t value)
+			{
+				for (uint32_t i{}; i < 4; ++i)
+					header[position + i] = static_cast<uint8_t>(value >> (i * 8));
+			} };
+
+		// Returns where the entry's values go: inside the entry when they fit in 4 bytes, otherwise after the IFD
+		uint32_t entryIndex{};
+		const auto addEntry{ [&](uint16_t tag, TiffType type, uint32_t count)
+			{
+				const uint64_t entry{ IfdOffset + 2 + entryIndex++ * 12 };
+				put16(entry, tag);
+				put16(entry + 2, type);
+				put32(entry + 4, count);
+
+				const uint64_t valueSize{ uint64_t(count) * (type == Short ? 2 : type == Long ? 4 : 1) };
+				if (valueSize <= 4)
+					return entry + 8;
+
+				const uint64_t position{ (header.size() + 3) & ~uint64_t{ 3 } };
+				put32(entry + 8, static_cast<uint32_t>(position));
+				header.resize(position + valueSize);
+				return position;
+			} };
+
+		header[0] = 'I';
+		header[1] = 'I';
+		put16(2, 42);
+		put32(4, static_cast<uint32_t>(IfdOffset));
+		put16(IfdOffset, EntryCount);
+
+		// Entries sorted by tag, as TIFF requires
+		put32(addEntry(256, Long, 1), width);
+		put32(addEntry(257, Long, 1), height);
+		const uint64_t bitsPerSample{ addEntry(258, Short, 3) };
+		put16(addEntry(259, Short, 1), 1);  // no compression
+		put16(addEntry(262, Short, 1), 2);  // RGB
+		put16(addEntry(277, Short, 1), 3);  // samples per pixel
+		put16(addEntry(284, Short, 1), 1);  // interleaved
+		put32(addEntry(322, Long, 1), m_TileSize);
+		put32(addEntry(323, Long, 1), m_TileSize);
+		const uint64_t tileOffsets{ addEntry(324, Long, tileCount) };
+		const uint64_t tileByteCounts{ addEntry(325, Long, tileCount) };
+		m_FlagsOffset = addEntry(DoneFlagsTag, Undefined, tileCount);
+		put32(IfdOffset + 2 + EntryCount * 12, 0);  // no next IFD
+
+		for (uint32_t i{}; i < 3; ++i)
+			put16(bitsPerSample + i * 2, 8);
+
+		// Tiles start page aligned, at fixed offsets
+		const uint64_t tileBytes{ uint64_t(m_TileSize) * m_TileSize * 3 };
+		m_TilesOffset = (header.size() + 4095) & ~uint64_t{ 4095 };
+		if (m_TilesOffset + tileCount * tileBytes > UINT32_MAX)
+			return {};
+
+		header.resize(m_TilesOffset);
+		for (uint32_t i{}; i < tileCount; ++i)
+		{
+			put32(tileOffsets + i * 4, static_cast<uint32_t>(m_TilesOffset + i * tileBytes));
+			put32(tileByteCounts + i * 4, static_cast<uint32_t>(tileBytes));
+		}
+		return header;
+	}
+}
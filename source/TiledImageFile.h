@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dae
+{
+	// An uncompressed, tiled 8 bit RGB TIFF that gets filled in one tile at a time, straight on disk.
+	// Every tile has a fixed place in the file and a "done" byte in a private tag (ignored by image viewers),
+	// so tiles can be written in any order from any thread and a render that got interrupted continues where it stopped.
+	// Tiles that aren't written yet are black. Max 4GB (no BigTIFF), that's still a bit more than 32k x 32k
+	class TiledImageFile final
+	{
+	public:
+		TiledImageFile() = default;
+		~TiledImageFile();
+
+		TiledImageFile(const TiledImageFile&) = delete;
+		TiledImageFile(TiledImageFile&&) noexcept = delete;
+		TiledImageFile& operator=(const TiledImageFile&) = delete;
+		TiledImageFile& operator=(TiledImageFile&&) noexcept = delete;
+
+		/**
+		 * \brief Continues an existing file with the same size & tile size, otherwise (re)creates it with every tile empty
+		 * \param tileSize multiple of 16 (a TIFF rule)
+		 */
+		bool Open(const std::string& filename, uint32_t width, uint32_t height, uint32_t tileSize);
+		void Close();
+
+		/**
+		 * \brief Writes one tile and marks it done, safe to call from several threads
+		 * \param pPixels tileSize * tileSize packed RGB, including the part of border tiles that's outside of the image
+		 */
+		bool WriteTile(uint32_t tileIndex, const uint8_t* pPixels);
+
+		bool IsTileDone(uint32_t tileIndex) const;
+		uint32_t GetDoneCount() const;
+		// True when Open found tiles from an earlier run
+		bool IsResumed() const { return m_IsResumed; }
+
+		uint32_t GetTileSize() const { return m_TileSize; }
+		uint32_t GetTilesX() const { return m_TilesX; }
+		uint32_t GetTilesY() const { return m_TilesY; }
+		uint32_t GetTileCount() const { return m_TilesX * m_TilesY; }
+
+	private:
+		std::FILE* m_pFile{};
+		uint32_t m_TileSize{};
+		uint32_t m_TilesX{};
+		uint32_t m_TilesY{};
+		bool m_IsResumed{};
+
+		uint64_t m_FlagsOffset{};   // file offset of the done bytes
+		uint64_t m_TilesOffset{};   // file offset of the first tile
+		std::vector<uint8_t> m_DoneFlags{};
+
+		mutable std::mutex m_Mutex{};
+
+		// Header, IFD & tile tables, with every done flag cleared
+		std::vector<uint8_t> BuildHeader(uint32_t width, uint32_t height);
+	};
+}
@@ -90,7 +90,7 @@ void Timer::Update()
 
 	m_TotalTime = (float)(((m_CurrentTime - m_PausedTime) - m_BaseTime) * m_SecondsPerCount);
 
-	//FPS LOGIC
+	//FPS LOGIC (always real time)
 	m_FPSTimer += m_ElapsedTime;
 	++m_FPSCount;
 	if (m_FPSTimer >= 1.0f)
@@ -129,6 +129,13 @@ void Timer::Update()
 			}
 		}
 	}
+
+	if (m_FixedStep > 0.0f)
+	{
+		m_FixedTotalTime += m_FixedStep;
+		m_ElapsedTime = m_FixedStep;
+		m_TotalTime = static_cast<float>(m_FixedTotalTime);
+	}
 }
 
 void Timer::Stop()
@@ -18,6 +18,15 @@ namespace dae
 		Timer& operator=(Timer&&) noexcept = delete;
 
 		void StartBenchmark(int numFrames = 10);
+		// Every Update advances the scene time by exactly this much (0 = real time), for offline renders at a fixed frame rate
+		void SetFixedStep(float seconds) { m_FixedStep = seconds; }
+		// Jumps the scene time to an exact moment, without a fixed step the next Update goes back to real time
+		void SetFixedTime(double seconds)
+		{
+			m_FixedTotalTime = seconds;
+			m_TotalTime = static_cast<float>(seconds);
+			m_ElapsedTime = 0.f;
+		}
 
 		void Reset();
 		void Start();
@@ -46,6 +55,8 @@ namespace dae
 		float m_SecondsPerCount = 0.0f;
 		float m_ElapsedUpperBound = 0.03f;
 		float m_FPSTimer = 0.0f;
+		float m_FixedStep = 0.0f;
+		double m_FixedTotalTime = 0.0;
 
 		bool m_IsStopped = true;
 		bool m_ForceElapsedUpperBound = false;
@@ -3,6 +3,11 @@
 #include <fstream>
 #include "Math.h"
 #include "DataTypes.h"
+#include "HeightField.h"
+#include "PointCloud.h"
+#include "VoxelGrid.h"
+#include "OBJParser.h"
+#include "RenderStatistics.h"
 #include <iostream>
 
 #define MOLLER_TRUMBORE
@@ -15,6 +20,7 @@ namespace dae
 		//SPHERE HIT-TESTS
 		inline bool HitTest_Sphere(const Sphere& sphere, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
 		{
+			RENDER_STAT(SphereTests);
 #pragma region Geometric
 			//Vector from ray origin to center of sphere
 			Vector3 tc{ sphere.origin - ray.origin };   // Vector TC  (T is start, C is center of sphere)
@@ -57,6 +63,7 @@ namespace dae
 		//PLANE HIT-TESTS
 		inline bool HitTest_Plane(const Plane& plane, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
 		{
+			RENDER_STAT(PlaneTests);
 			//todo W1
 
 			// Check if ray hits the plane, and where the hit is.
@@ -92,10 +99,356 @@ namespace dae
 			return HitTest_Plane(plane, ray, temp, true);
 		}
 #pragma endregion
+#pragma region AABB SlabTest
+		// Slab test against an axis aligned box, returns the entry & exit distance along the ray
+		inline bool SlabTest_AABB(const Vector3& minAABB, const Vector3& maxAABB, const Ray& ray, float& tNear, float& tFar, int& nearAxis, int& farAxis)
+		{
+			RENDER_STAT(SlabTests);
+			tNear = -FLT_MAX;
+			tFar = FLT_MAX;
+			nearAxis = 0;
+			farAxis = 0;
+
+			for (int axis{}; axis < 3; ++axis)
+			{
+				const float invDirection{ 1.f / ray.direction[axis] };
+				float t1{ (minAABB[axis] - ray.origin[axis]) * invDirection };
+				float t2{ (maxAABB[axis] - ray.origin[axis]) * invDirection };
+				if (t1 > t2)
+					std::swap(t1, t2);
+
+				if (t1 > tNear)
+				{
+					tNear = t1;
+					nearAxis = axis;
+				}
+				if (t2 < tFar)
+				{
+					tFar = t2;
+					farAxis = axis;
+				}
+			}
+
+			return tFar > 0 && tFar >= tNear;
+		}
+
+		inline bool SlabTest_AABB(const Vector3& minAABB, const Vector3& maxAABB, const Ray& ray)
+		{
+			float tNear{}, tFar{};
+			int nearAxis{}, farAxis{};
+			return SlabTest_AABB(minAABB, maxAABB, ray, tNear, tFar, nearAxis, farAxis);
+		}
+#pragma endregion
+#pragma region Box HitTest
+		//BOX HIT-TESTS
+		inline bool HitTest_Box(const Box& box, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			RENDER_STAT(BoxTests);
+			float tNear{}, tFar{};
+			int nearAxis{}, farAxis{};
+			if (!SlabTest_AABB(box.minBounds, box.maxBounds, ray, tNear, tFar, nearAxis, farAxis))
+				return false;
+
+			// A solid box is hit where the ray enters, a room where the ray leaves (it's only visible from the inside)
+			const float t{ box.isRoom ? tFar : tNear };
+			const int axis{ box.isRoom ? farAxis : nearAxis };
+			if (t < ray.min || t > ray.max)
+				return false;
+
+			if (ignoreHitRecord) return true;
+
+			// Outward normal of the entry face & inward normal of the exit face both point against the ray
+			Vector3 normal{};
+			normal[axis] = ray.direction[axis] > 0.f ? -1.f : 1.f;
+
+			hitRecord.didHit = true;
+			hitRecord.materialIndex = box.materialIndex;
+			hitRecord.normal = normal;
+			hitRecord.origin = ray.origin + (t * ray.direction);
+			hitRecord.t = t;
+			return true;
+		}
+
+		inline bool HitTest_Box(const Box& box, const Ray& ray)
+		{
+			HitRecord temp{};
+			return HitTest_Box(box, ray, temp, true);
+		}
+
+		inline bool HitTest_OrientedBox(const OrientedBox& box, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			RENDER_STAT(OrientedBoxTests);
+			// Move the ray into the local space of the box, where it's a regular AABB around the origin
+			const Vector3 offset{ ray.origin - box.center };
+			Ray localRay{ ray };
+			localRay.origin = { Vector3::Dot(offset, box.axisX), Vector3::Dot(offset, box.axisY), Vector3::Dot(offset, box.axisZ) };
+			localRay.direction = { Vector3::Dot(ray.direction, box.axisX), Vector3::Dot(ray.direction, box.axisY), Vector3::Dot(ray.direction, box.axisZ) };
+
+			float tNear{}, tFar{};
+			int nearAxis{}, farAxis{};
+			if (!SlabTest_AABB(-box.halfExtents, box.halfExtents, localRay, tNear, tFar, nearAxis, farAxis))
+				return false;
+
+			if (tNear < ray.min || tNear > ray.max)
+				return false;
+
+			if (ignoreHitRecord) return true;
+
+			const Vector3& localAxis{ nearAxis == 0 ? box.axisX : nearAxis == 1 ? box.axisY : box.axisZ };
+
+			hitRecord.didHit = true;
+			hitRecord.materialIndex = box.materialIndex;
+			hitRecord.normal = localRay.direction[nearAxis] > 0.f ? -localAxis : localAxis;
+			hitRecord.origin = ray.origin + (tNear * ray.direction);
+			hitRecord.t = tNear;
+			return true;
+		}
+
+		inline bool HitTest_OrientedBox(const OrientedBox& box, const Ray& ray)
+		{
+			HitRecord temp{};
+			return HitTest_OrientedBox(box, ray, temp, true);
+		}
+#pragma endregion
+#pragma region Disk & Quad HitTest
+		//DISK HIT-TESTS
+		inline bool HitTest_Disk(const Disk& disk, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			RENDER_STAT(DiskTests);
+			const float directionDotNormal{ Vector3::Dot(ray.direction, disk.normal) };
+			if (AreEqual(directionDotNormal, 0.f))
+				return false;  // Parallel to the disk
+
+			const float t{ Vector3::Dot(disk.origin - ray.origin, disk.normal) / directionDotNormal };
+			if (t < ray.min || t > ray.max)
+				return false;
+
+			const Vector3 point{ ray.origin + (t * ray.direction) };
+			if ((point - disk.origin).SqrMagnitude() > Square(disk.radius))
+				return false;
+
+			if (ignoreHitRecord) return true;
+
+			// Two-sided, so the normal always faces the ray
+			hitRecord.didHit = true;
+			hitRecord.materialIndex = disk.materialIndex;
+			hitRecord.normal = directionDotNormal > 0.f ? -disk.normal : disk.normal;
+			hitRecord.origin = point;
+			hitRecord.t = t;
+			return true;
+		}
+
+		inline bool HitTest_Disk(const Disk& disk, const Ray& ray)
+		{
+			HitRecord temp{};
+			return HitTest_Disk(disk, ray, temp, true);
+		}
+
+		//QUAD HIT-TESTS
+		inline bool HitTest_Quad(const Quad& quad, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			RENDER_STAT(QuadTests);
+			const float directionDotNormal{ Vector3::Dot(ray.direction, quad.normal) };
+			if (AreEqual(directionDotNormal, 0.f))
+				return false;  // Parallel to the quad
+
+			const float t{ Vector3::Dot(quad.origin - ray.origin, quad.normal) / directionDotNormal };
+			if (t < ray.min || t > ray.max)
+				return false;
+
+			// Planar coordinates of the hit along both edges, both have to be in [0, 1]
+			const Vector3 point{ ray.origin + (t * ray.direction) };
+			const Vector3 planarHit{ point - quad.origin };
+			const float alpha{ Vector3::Dot(quad.w, Vector3::Cross(planarHit, quad.edgeV)) };
+			const float beta{ Vector3::Dot(quad.w, Vector3::Cross(quad.edgeU, planarHit)) };
+			if (alpha < 0.f || alpha > 1.f || beta < 0.f || beta > 1.f)
+				return false;
+
+			if (ignoreHitRecord) return true;
+
+			hitRecord.didHit = true;
+			hitRecord.materialIndex = quad.materialIndex;
+			hitRecord.normal = directionDotNormal > 0.f ? -quad.normal : quad.normal;
+			hitRecord.origin = point;
+			hitRecord.t = t;
+			return true;
+		}
+
+		inline bool HitTest_Quad(const Quad& quad, const Ray& ray)
+		{
+			HitRecord temp{};
+			return HitTest_Quad(quad, ray, temp, true);
+		}
+#pragma endregion
+#pragma region Cylinder HitTest
+		//CYLINDER HIT-TESTS
+		inline bool HitTest_Cylinder(const Cylinder& cylinder, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			RENDER_STAT(CylinderTests);
+			const Vector3 offset{ ray.origin - cylinder.origin };
+			const float directionDotAxis{ Vector3::Dot(ray.direction, cylinder.axis) };
+			const float offsetDotAxis{ Vector3::Dot(offset, cylinder.axis) };
+
+			float closestT{ FLT_MAX };
+			Vector3 closestNormal{};
+
+			// Side: remove the axis component of the ray, what's left is a circle test in the plane of the base
+			const Vector3 radialDirection{ ray.direction - cylinder.axis * directionDotAxis };
+			const Vector3 radialOffset{ offset - cylinder.axis * offsetDotAxis };
+			const float a{ radialDirection.SqrMagnitude() };
+			if (a > FLT_EPSILON)
+			{
+				const float b{ Vector3::Dot(radialOffset, radialDirection) };
+				const float c{ radialOffset.SqrMagnitude() - Square(cylinder.radius) };
+				const float discriminant{ Square(b) - a * c };
+				if (discriminant >= 0.f)
+				{
+					const float sqrtDiscriminant{ sqrtf(discriminant) };
+					const float roots[2]{ (-b - sqrtDiscriminant) / a, (-b + sqrtDiscriminant) / a };
+					for (const float t : roots)
+					{
+						if (t < ray.min || t > ray.max)
+							continue;
+
+						// Has to be between the 2 caps
+						const float height{ offsetDotAxis + t * directionDotAxis };
+						if (height < 0.f || height > cylinder.height)
+							continue;
+
+						closestT = t;
+						closestNormal = (radialOffset + radialDirection * t) / cylinder.radius;
+						break;
+					}
+				}
+			}
+
+			// Caps: disks at both ends of the axis
+			if (cylinder.isCapped && !AreEqual(directionDotAxis, 0.f))
+			{
+				const float capHeights[2]{ 0.f, cylinder.height };
+				for (const float capHeight : capHeights)
+				{
+					const float t{ (capHeight - offsetDotAxis) / directionDotAxis };
+					if (t < ray.min || t > ray.max || t >= closestT)
+						continue;
+
+					const Vector3 radialHit{ radialOffset + radialDirection * t };
+					if (radialHit.SqrMagnitude() > Square(cylinder.radius))
+						continue;
+
+					closestT = t;
+					closestNormal = capHeight > 0.f ? cylinder.axis : -cylinder.axis;
+				}
+			}
+
+			if (closestT == FLT_MAX)
+				return false;
+
+			if (ignoreHitRecord) return true;
+
+			// Open cylinders can be seen from the inside, flip the normal towards the ray
+			if (Vector3::Dot(closestNormal, ray.direction) > 0.f)
+				closestNormal = -closestNormal;
+
+			hitRecord.didHit = true;
+			hitRecord.materialIndex = cylinder.materialIndex;
+			hitRecord.normal = closestNormal;
+			hitRecord.origin = ray.origin + (closestT * ray.direction);
+			hitRecord.t = closestT;
+			return true;
+		}
+
+		inline bool HitTest_Cylinder(const Cylinder& cylinder, const Ray& ray)
+		{
+			HitRecord temp{};
+			return HitTest_Cylinder(cylinder, ray, temp, true);
+		}
+#pragma endregion
+#pragma region HeightField HitTest
+		//HEIGHTFIELD HIT-TESTS
+		inline bool HitTest_HeightField(const HeightField& heightField, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			RENDER_STAT(HeightFieldTests);
+			float t{};
+			Vector3 normal{};
+			if (!heightField.Intersect(ray, t, normal, ignoreHitRecord))
+				return false;
+
+			if (ignoreHitRecord) return true;
+
+			hitRecord.didHit = true;
+			hitRecord.materialIndex = heightField.materialIndex;
+			hitRecord.normal = normal;
+			hitRecord.origin = ray.origin + (t * ray.direction);
+			hitRecord.t = t;
+			return true;
+		}
+
+		inline bool HitTest_HeightField(const HeightField& heightField, const Ray& ray)
+		{
+			HitRecord temp{};
+			return HitTest_HeightField(heightField, ray, temp, true);
+		}
+#pragma endregion
+#pragma region PointCloud HitTest
+		//POINTCLOUD HIT-TESTS
+		inline bool HitTest_PointCloud(const PointCloud& pointCloud, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			RENDER_STAT(PointCloudTests);
+			float t{};
+			uint32_t hitIndex{};
+			if (!pointCloud.Intersect(ray, t, hitIndex, ignoreHitRecord))
+				return false;
+
+			if (ignoreHitRecord) return true;
+
+			const Vector3 center{ pointCloud.positionsX[hitIndex], pointCloud.positionsY[hitIndex], pointCloud.positionsZ[hitIndex] };
+			hitRecord.didHit = true;
+			hitRecord.materialIndex = pointCloud.materialIndex;
+			hitRecord.origin = ray.origin + (t * ray.direction);
+			hitRecord.normal = (hitRecord.origin - center).Normalized();
+			hitRecord.t = t;
+			return true;
+		}
+
+		inline bool HitTest_PointCloud(const PointCloud& pointCloud, const Ray& ray)
+		{
+			HitRecord temp{};
+			return HitTest_PointCloud(pointCloud, ray, temp, true);
+		}
+#pragma endregion
+#pragma region VoxelGrid HitTest
+		//VOXELGRID HIT-TESTS
+		inline bool HitTest_VoxelGrid(const VoxelGrid& voxelGrid, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			RENDER_STAT(VoxelGridTests);
+			float t{};
+			Vector3 normal{};
+			unsigned char materialIndex{};
+			if (!voxelGrid.Intersect(ray, t, normal, materialIndex))
+				return false;
+
+			if (ignoreHitRecord) return true;
+
+			hitRecord.didHit = true;
+			hitRecord.materialIndex = materialIndex;
+			hitRecord.normal = normal;
+			hitRecord.origin = ray.origin + (t * ray.direction);
+			hitRecord.t = t;
+			return true;
+		}
+
+		inline bool HitTest_VoxelGrid(const VoxelGrid& voxelGrid, const Ray& ray)
+		{
+			HitRecord temp{};
+			return HitTest_VoxelGrid(voxelGrid, ray, temp, true);
+		}
+#pragma endregion
 #pragma region Triangle HitTest
 		//TRIANGLE HIT-TESTS
 		inline bool HitTest_Triangle(const Triangle& triangle, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
 		{
+			RENDER_STAT(TriangleTests);
 #ifdef MOLLER_TRUMBORE
 			// MllerTrumbore intersection algorithm
 			const Vector3 edge1{ triangle.v1 - triangle.v0 };
@@ -251,27 +604,53 @@ namespace dae
 		inline bool SlabTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray)
 		{
 			// Perform slabtest on the mesh (acceleration structures)
+			return SlabTest_AABB(mesh.transformedMinAABB, mesh.transformedMaxAABB, ray);
+		}
 
-			float tx1 = (mesh.transformedMinAABB.x - ray.origin.x) / ray.direction.x;
-			float tx2 = (mesh.transformedMaxAABB.x - ray.origin.x) / ray.direction.x;
-
-			float tmin = std::min(tx1, tx2);
-			float tmax = std::max(tx1, tx2);
-
-			float ty1 = (mesh.transformedMinAABB.y - ray.origin.y) / ray.direction.y;
-			float ty2 = (mesh.transformedMaxAABB.y - ray.origin.y) / ray.direction.y;
+		inline bool HitTest_CompressedTriangleMesh(const TriangleMesh& mesh, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
+		{
+			// Move the ray into object space instead of moving every vertex into world space.
+			// The direction is left unnormalized so t stays the same in both spaces.
+			Ray objectRay{ ray };
+			objectRay.origin = mesh.worldToObject.TransformPoint(ray.origin);
+			objectRay.direction = mesh.worldToObject.TransformVector(ray.direction);
 
-			tmin = std::max(tmin, std::min(ty1, ty2));
-			tmax = std::min(tmax, std::max(ty1, ty2));
+			const CompressedMeshData& data{ mesh.compressed };
+			Triangle triangle{};
+			triangle.cullMode = mesh.cullMode;
+			triangle.materialIndex = mesh.materialIndex;
 
-			float tz1 = (mesh.transformedMinAABB.z - ray.origin.z) / ray.direction.z;
-			float tz2 = (mesh.transformedMaxAABB.z - ray.origin.z) / ray.direction.z;
+			size_t closestTriangle{ SIZE_MAX };
+			const size_t meshIndicesSize{ data.GetIndexCount() };
+			for (size_t i{}; i < meshIndicesSize; i += 3)
+			{
+				triangle.v0 = MeshCompression::DecodePosition(data, data.GetIndex(i));
+				triangle.v1 = MeshCompression::DecodePosition(data, data.GetIndex(i + 1));
+				triangle.v2 = MeshCompression::DecodePosition(data, data.GetIndex(i + 2));
 
-			tmin = std::max(tmin, std::min(tz1, tz2));
-			tmax = std::min(tmax, std::max(tz1, tz2));
+				HitRecord tempHitrecord{};
+				if (HitTest_Triangle(triangle, objectRay, tempHitrecord, ignoreHitRecord))
+				{
+					if (ignoreHitRecord)
+					{
+						return true;
+					}
+					else if (tempHitrecord.t > 0.0f && tempHitrecord.t < hitRecord.t)
+					{
+						hitRecord = tempHitrecord;
+						closestTriangle = i / 3;
+					}
+				}
+			}
 
-			return tmax > 0 && tmax >= tmin;
+			if (closestTriangle == SIZE_MAX)
+				return hitRecord.didHit;
 
+			// Only decode the normal of the closest hit, and bring the hit back into world space
+			hitRecord.origin = ray.origin + (hitRecord.t * ray.direction);
+			hitRecord.normal = mesh.rotationTransform.TransformVector(MeshCompression::DecodeOctahedral(data.normals[closestTriangle]));
+			hitRecord.materialIndex = mesh.GetTriangleMaterial(closestTriangle);
+			return true;
 		}
 
 		inline bool HitTest_TriangleMesh(const TriangleMesh& mesh, const Ray& ray, HitRecord& hitRecord, bool ignoreHitRecord = false)
@@ -279,7 +658,13 @@ namespace dae
 			// Opitimization using slabtest
 			// Checks if ray hits the slab/bounding box (AABB), stops the calculation if ray doesn't hit this box
 			if (!SlabTest_TriangleMesh(mesh, ray))
+			{
+				RENDER_STAT(MeshEarlyOuts);
 				return false;
+			}
+
+			if (mesh.isCompressed)
+				return HitTest_CompressedTriangleMesh(mesh, ray, hitRecord, ignoreHitRecord);
 
 			// Loop through all triangles in the mesh, and check if they hit the ray.
 			Triangle triangle{};
@@ -293,7 +678,7 @@ namespace dae
 				triangle.v2 = mesh.transformedPositions[mesh.indices[i + 2]];
 				triangle.normal = mesh.transformedNormals[i / 3];
 				triangle.cullMode = mesh.cullMode;
-				triangle.materialIndex = mesh.materialIndex;
+				triangle.materialIndex = mesh.GetTriangleMaterial(i / 3);
 
 				HitRecord tempHitrecord{};
 				if (HitTest_Triangle(triangle, ray, tempHitrecord, ignoreHitRecord))
@@ -373,74 +758,16 @@ namespace dae
 
 	namespace Utils
 	{
-		//Just parses vertices and indices
+		//Parses positions and faces (any corner syntax, polygons get triangulated), one normal per triangle
 #pragma warning(push)
 #pragma warning(disable : 4505) //Warning unreferenced local function
 		static bool ParseOBJ(const std::string& filename, std::vector<Vector3>& positions, std::vector<Vector3>& normals, std::vector<int>& indices)
 		{
-			std::ifstream file(filename);
-			if (!file)
+			OBJParser::OBJData data{};
+			if (!OBJParser::Parse(filename, data))
 				return false;
 
-			std::string sCommand;
-			// start a while iteration ending when the end of file is reached (ios::eof)
-			while (!file.eof())
-			{
-				//read the first word of the string, use the >> operator (istream::operator>>) 
-				file >> sCommand;
-				//use conditional statements to process the different commands	
-				if (sCommand == "#")
-				{
-					// Ignore Comment
-				}
-				else if (sCommand == "v")
-				{
-					//Vertex
-					float x, y, z;
-					file >> x >> y >> z;
-					positions.push_back({ x, y, z });
-				}
-				else if (sCommand == "f")
-				{
-					float i0, i1, i2;
-					file >> i0 >> i1 >> i2;
-
-					indices.push_back((int)i0 - 1);
-					indices.push_back((int)i1 - 1);
-					indices.push_back((int)i2 - 1);
-				}
-				//read till end of line and ignore all remaining chars
-				file.ignore(1000, '\n');
-
-				if (file.eof())
-					break;
-			}
-
-			//Precompute normals
-			for (uint64_t index = 0; index < indices.size(); index += 3)
-			{
-				uint32_t i0 = indices[index];
-				uint32_t i1 = indices[index + 1];
-				uint32_t i2 = indices[index + 2];
-
-				Vector3 edgeV0V1 = positions[i1] - positions[i0];
-				Vector3 edgeV0V2 = positions[i2] - positions[i0];
-				Vector3 normal = Vector3::Cross(edgeV0V1, edgeV0V2);
-
-				if (isnan(normal.x))
-				{
-					int k = 0;
-				}
-
-				normal.Normalize();
-				if (isnan(normal.x))
-				{
-					int k = 0;
-				}
-
-				normals.push_back(normal);
-			}
-
+			OBJParser::ToTriangleMesh(data, positions, normals, indices);
 			return true;
 		}
 #pragma warning(pop)
@@ -0,0 +1,182 @@
+#include "VoxelGrid.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "Utils.h"
+
+namespace dae
+{
+	void VoxelGrid::Resize(uint32_t voxelsX, uint32_t voxelsY, uint32_t voxelsZ)
+	{
+		bricksX = (voxelsX + BrickSize - 1) / BrickSize;
+		bricksY = (voxelsY + BrickSize - 1) / BrickSize;
+		bricksZ = (voxelsZ + BrickSize - 1) / BrickSize;
+
+		brickIndices.assign(size_t(bricksX) * bricksY * bricksZ, EmptyBrick);
+		bricks.clear();
+
+		minAABB = origin;
+		maxAABB = origin + Vector3{ float(GetVoxelsX()), float(GetVoxelsY()), float(GetVoxelsZ()) } * voxelSize;
+	}
+
+	void VoxelGrid::SetVoxel(uint32_t x, uint32_t y, uint32_t z, unsigned char materialIndex)
+	{
+		assert(x < GetVoxelsX() && y < GetVoxelsY() && z < GetVoxelsZ() && "Voxel outside of the grid");
+
+		uint32_t& brickIndex{ brickIndices[(size_t(z / BrickSize) * bricksY + y / BrickSize) * bricksX + x / BrickSize] };
+		if (brickIndex == EmptyBrick)
+		{
+			// Clearing a voxel never needs a brick
+			if (materialIndex == EmptyVoxel)
+				return;
+
+			brickIndex = static_cast<uint32_t>(bricks.size() / BrickVoxelCount);
+			bricks.resize(bricks.size() + BrickVoxelCount, EmptyVoxel);
+		}
+
+		const uint32_t localIndex{ ((z % BrickSize) * BrickSize + y % BrickSize) * BrickSize + x % BrickSize };
+		bricks[size_t(brickIndex) * BrickVoxelCount + localIndex] = materialIndex;
+	}
+
+	unsigned char VoxelGrid::GetVoxel(uint32_t x, uint32_t y, uint32_t z) const
+	{
+		const uint32_t brickIndex{ brickIndices[(size_t(z / BrickSize) * bricksY + y / BrickSize) * bricksX + x / BrickSize] };
+		if (brickIndex == EmptyBrick)
+			return EmptyVoxel;
+
+		const uint32_t localIndex{ ((z % BrickSize) * BrickSize + y % BrickSize) * BrickSize + x % BrickSize };
+		return bricks[size_t(brickIndex) * BrickVoxelCount + localIndex];
+	}
+
+	size_t VoxelGrid::GetMemoryFootprint() const
+	{
+		return brickIndices.size() * sizeof(uint32_t) + bricks.size();
+	}
+
+	bool VoxelGrid::Intersect(const Ray& ray, float& t, Vector3& normal, unsigned char& materialIndex) const
+	{
+		if (bricks.empty())
+			return false;
+
+		float tNear{}, tFar{};
+		int nearAxis{}, farAxis{};
+		if (!GeometryUtils::SlabTest_AABB(minAABB, maxAABB, ray, tNear, tFar, nearAxis, farAxis))
+			return false;
+
+		const float tStart{ std::max(tNear, ray.min) };
+		const float tEnd{ std::min(tFar, ray.max) };
+		if (tStart > tEnd)
+			return false;
+
+		const int step[3]{ ray.direction.x >= 0.f ? 1 : -1, ray.direction.y >= 0.f ? 1 : -1, ray.direction.z >= 0.f ? 1 : -1 };
+		const int brickCount[3]{ int(bricksX), int(bricksY), int(bricksZ) };
+		const float brickSize{ voxelSize * BrickSize };
+		const float invVoxelSize{ 1.f / voxelSize };
+
+		// Brick level DDA, in grid space (units of voxels, relative to the origin)
+		const Vector3 start{ (ray.origin + ray.direction * tStart - origin) * invVoxelSize };
+		int brick[3]{};
+		float brickTMax[3]{};
+		float brickTDelta[3]{};
+		for (int axis{}; axis < 3; ++axis)
+		{
+			brick[axis] = std::clamp(static_cast<int>(start[axis] / BrickSize), 0, brickCount[axis] - 1);
+
+			const float direction{ ray.direction[axis] };
+			if (direction != 0.f)
+			{
+				const float boundary{ origin[axis] + (brick[axis] + (step[axis] > 0 ? 1 : 0)) * brickSize };
+				brickTMax[axis] = (boundary - ray.origin[axis]) / direction;
+				brickTDelta[axis] = brickSize / fabsf(direction);
+			}
+			else
+			{
+				brickTMax[axis] = FLT_MAX;
+				brickTDelta[axis] = FLT_MAX;
+			}
+		}
+
+		// Axis of the last boundary that was crossed, gives the normal of the face that was hit
+		int enterAxis{ nearAxis };
+		float brickTEnter{ tStart };
+
+		while (true)
+		{
+			// Every brick & voxel the DDA steps through counts like a BVH node
+			RENDER_STAT(SlabTests);
+			const uint32_t brickIndex{ brickIndices[(size_t(brick[2]) * bricksY + brick[1]) * bricksX + brick[0]] };
+			const float brickTExit{ std::min({ brickTMax[0], brickTMax[1], brickTMax[2], tEnd }) };
+
+			if (brickIndex != EmptyBrick)
+			{
+				// Voxel level DDA, limited to this brick
+				const unsigned char* pBrick{ &bricks[size_t(brickIndex) * BrickVoxelCount] };
+				const Vector3 entry{ (ray.origin + ray.direction * brickTEnter - origin) * invVoxelSize };
+
+				int voxel[3]{};
+				float voxelTMax[3]{};
+				float voxelTDelta[3]{};
+				for (int axis{}; axis < 3; ++axis)
+				{
+					const int brickStart{ brick[axis] * int(BrickSize) };
+					voxel[axis] = std::clamp(static_cast<int>(floorf(entry[axis])), brickStart, brickStart + int(BrickSize) - 1) - brickStart;
+
+					const float direction{ ray.direction[axis] };
+					if (direction != 0.f)
+					{
+						const float boundary{ origin[axis] + (brickStart + voxel[axis] + (step[axis] > 0 ? 1 : 0)) * voxelSize };
+						voxelTMax[axis] = (boundary - ray.origin[axis]) / direction;
+						voxelTDelta[axis] = voxelSize / fabsf(direction);
+					}
+					else
+					{
+						voxelTMax[axis] = FLT_MAX;
+						voxelTDelta[axis] = FLT_MAX;
+					}
+				}
+
+				float voxelTEnter{ brickTEnter };
+				int voxelEnterAxis{ enterAxis };
+				while (true)
+				{
+					RENDER_STAT(SlabTests);
+					const unsigned char material{ pBrick[(voxel[2] * BrickSize + voxel[1]) * BrickSize + voxel[0]] };
+					if (material != EmptyVoxel)
+					{
+						t = voxelTEnter;
+						materialIndex = material;
+						normal = {};
+						normal[voxelEnterAxis] = -static_cast<float>(step[voxelEnterAxis]);
+						return true;
+					}
+
+					const int axis{ voxelTMax[0] < voxelTMax[1] ? (voxelTMax[0] < voxelTMax[2] ? 0 : 2) : (voxelTMax[1] < voxelTMax[2] ? 1 : 2) };
+					if (voxelTMax[axis] > brickTExit)
+						break;
+
+					voxel[axis] += step[axis];
+					if (voxel[axis] < 0 || voxel[axis] >= int(BrickSize))
+						break;
+
+					voxelTEnter = voxelTMax[axis];
+					voxelEnterAxis = axis;
+					voxelTMax[axis] += voxelTDelta[axis];
+				}
+			}
+
+			// Next brick
+			const int axis{ brickTMax[0] < brickTMax[1] ? (brickTMax[0] < brickTMax[2] ? 0 : 2) : (brickTMax[1] < brickTMax[2] ? 1 : 2) };
+			if (brickTMax[axis] > tEnd)
+				return false;
+
+			brick[axis] += step[axis];
+			if (brick[axis] < 0 || brick[axis] >= brickCount[axis])
+				return false;
+
+			brickTEnter = brickTMax[axis];
+			enterAxis = axis;
+			brickTMax[axis] += brickTDelta[axis];
+		}
+	}
+}
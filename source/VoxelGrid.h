@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	struct Ray;
+
+	// Sparse voxel volume: a coarse grid of bricks, only bricks that contain at least one voxel get storage.
+	// Every voxel is a single byte holding its material index (EmptyVoxel when there's nothing).
+	struct VoxelGrid
+	{
+		static constexpr uint32_t BrickSize{ 8 };  // voxels per side of a brick
+		static constexpr uint32_t BrickVoxelCount{ BrickSize * BrickSize * BrickSize };
+		static constexpr unsigned char EmptyVoxel{ 0xFF };
+		static constexpr uint32_t EmptyBrick{ 0xFFFFFFFF };
+
+		// Corner of voxel (0, 0, 0)
+		Vector3 origin{};
+		float voxelSize{ 1.f };
+
+		// Size of the grid in bricks
+		uint32_t bricksX{};
+		uint32_t bricksY{};
+		uint32_t bricksZ{};
+
+		std::vector<uint32_t> brickIndices{};  // per grid cell: index of its brick in bricks, or EmptyBrick
+		std::vector<unsigned char> bricks{};   // BrickVoxelCount materials per allocated brick
+
+		Vector3 minAABB{};
+		Vector3 maxAABB{};
+
+		// Size in voxels, rounded up to whole bricks. Clears the grid
+		void Resize(uint32_t voxelsX, uint32_t voxelsY, uint32_t voxelsZ);
+
+		void SetVoxel(uint32_t x, uint32_t y, uint32_t z, unsigned char materialIndex);
+		unsigned char GetVoxel(uint32_t x, uint32_t y, uint32_t z) const;
+
+		uint32_t GetVoxelsX() const { return bricksX * BrickSize; }
+		uint32_t GetVoxelsY() const { return bricksY * BrickSize; }
+		uint32_t GetVoxelsZ() const { return bricksZ * BrickSize; }
+
+		/**
+		 * \brief 3D DDA over the bricks, empty ones are skipped as a whole, filled ones get a 3D DDA over their voxels
+		 * \param t distance to the face of the first filled voxel (out)
+		 * \param normal normal of that face (out)
+		 * \param materialIndex material of that voxel (out)
+		 */
+		bool Intersect(const Ray& ray, float& t, Vector3& normal, unsigned char& materialIndex) const;
+
+		size_t GetMemoryFootprint() const;
+	};
+}
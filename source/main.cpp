@@ -5,59 +5,745 @@
 #undef main
 
 //Standard includes
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <initializer_list>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 //Project includes
+#include "CameraPath.h"
+#include "DeltaFrameStream.h"
+#include "InputSource.h"
+#include "RenderCoordinator.h"
+#include "RenderStatistics.h"
+#include "RenderServer.h"
+#include "RenderTarget.h"
+#include "SharedMemoryRenderTarget.h"
 #include "Timer.h"
 #include "Renderer.h"
 #include "Scene.h"
+#include "MemoryTracker.h"
 
 using namespace dae;
 
 void ShutDown(SDL_Window* pWindow)
 {
-	SDL_DestroyWindow(pWindow);
+	if (pWindow)
+		SDL_DestroyWindow(pWindow);
 	SDL_Quit();
 }
 
+void PrintUsage()
+{
+	std::cout <<
+		"RayTracer [scene file] [options]\n"
+		"  --scene <name>              compiled scene instead of a file: w1, w2, w3, w3test, w4test, reference (default), bunny,\n"
+		"                              analytic, heightfield, heightfield-triangles, pointcloud, voxels\n"
+		"  --size <width>x<height>     resolution, 640x480 by default\n"
+		"  --frames <n>                exit after n frames (1 when headless)\n"
+		"  --threads <n>               render threads, default: one per hardware thread\n"
+		"  --lighting <mode>           observedarea, radiance, brdf or combined\n"
+		"  --shadows on|off            --reflections on|off\n"
+		"  --output <file>             save the last frame: .ppm, .bmp, .qoi or .pfm (HDR)\n"
+		"  --batch, --headless         no window & no input, the scene advances 1/fps per frame, prints timing statistics\n"
+		"  --stream <file|->           every frame into one video stream, --stream-format y4m|raw, --fps <n>\n"
+		"  --tiled <file.tif>          render --size tile by tile into a tiled TIFF, --tile <n> (256, a multiple of 16)\n"
+		"  --server [address:]<port>   keep the scene loaded and render frames for clients on 127.0.0.1:<port>,\n"
+		"                              see RenderServer.h for the protocol. 0.0.0.0:<port> accepts other machines\n"
+		"  --coordinator <[host:]port,...>\n"
+		"                              render --frames on --server workers (every one with the same scene), --tile <n> (64)\n"
+		"  --scaling                   with --coordinator: the frame on 1, 2, .. all workers, prints speedup & efficiency\n"
+		"  --shared-memory <name>      headless, every frame goes into a ring of 3 frames in shared memory for other processes,\n"
+		"                              see SharedMemoryRenderTarget.h for the layout\n"
+		"  --read-shared-memory <name> read --frames (1) from a --shared-memory renderer, prints their timing\n"
+		"  --record-input <file>       write the camera input of every frame to a file\n"
+		"  --replay-input <file>       headless, the camera gets the recorded input, one frame per recorded frame\n"
+		"  --camera-path <file>        headless, the camera follows the keyframes in the file (see CameraPath.h) for\n"
+		"                              its duration. Both replays advance 1/fps per frame, every run renders the same frames\n"
+		"  --record-path <file>        write the camera's pose every frame, a camera path for --camera-path\n"
+		"  --heatmap <cost>            show what every pixel cost instead of its color: tests, nodes, shadows or time (us).\n"
+		"                              F10 cycles them in the window, Shift+F10 the ramp, F11 saves the raw costs\n"
+		"  --heatmap-ramp <ramp>       heat (default), rainbow, gray, or colors from cheap to expensive: rrggbb,rrggbb,...\n"
+		"  --heatmap-scale <cost>      cost at the end of the ramp, 0 (default) is the 99th percentile of every frame\n"
+		"  --cost-output <file.pfm>    save the last frame's raw costs (single channel float map), needs --heatmap\n"
+		"  --delta-stats               what every frame would cost as a delta stream (only the changed 32x32 tiles, LZ4),\n"
+		"                              see DeltaFrameStream.h\n";
+}
+
+// Compiled scenes by their command line name, nullptr if there's none with that name
+Scene* CreateScene(const std::string& name)
+{
+	if (name == "w1") return new Scene_W1;
+	if (name == "w2") return new Scene_W2;
+	if (name == "w3") return new Scene_W3;
+	if (name == "w3test") return new Scene_W3_Test;
+	if (name == "w4test") return new Scene_W4_TestScene;
+	if (name == "reference") return new Scene_W4_ReferenceScene;
+	if (name == "bunny") return new Scene_W4_BunnyScene;
+	if (name == "analytic") return new Scene_AnalyticPrimitives;
+	if (name == "heightfield") return new Scene_HeightField;
+	if (name == "heightfield-triangles") return new Scene_HeightField{ true };
+	if (name == "pointcloud") return new Scene_PointCloud;
+	if (name == "voxels") return new Scene_Voxels;
+	return nullptr;
+}
+
+// "host:port,port,..." (no host = this machine)
+std::vector<RenderCoordinator::Endpoint> ParseEndpoints(const std::string& list)
+{
+	std::vector<RenderCoordinator::Endpoint> endpoints = {};
+	size_t start = 0;
+	while (start < list.size())
+	{
+		const size_t end = std::min(list.find(',', start), list.size());
+		const std::string endpoint = list.substr(start, end - start);
+		const size_t separator = endpoint.rfind(':');
+		if (separator == std::string::npos)
+			endpoints.push_back({ "127.0.0.1", static_cast<uint16_t>(std::atoi(endpoint.c_str())) });
+		else
+			endpoints.push_back({ endpoint.substr(0, separator), static_cast<uint16_t>(std::atoi(endpoint.c_str() + separator + 1)) });
+		start = end + 1;
+	}
+	return endpoints;
+}
+
+// Update + Render time per frame, for scripted throughput runs
+void PrintFrameStatistics(std::vector<float> frameMilliseconds, uint32_t width, uint32_t height)
+{
+	if (frameMilliseconds.empty())
+		return;
+
+	std::sort(frameMilliseconds.begin(), frameMilliseconds.end());
+	const size_t frameCount = frameMilliseconds.size();
+	float totalMilliseconds = 0.f;
+	for (float milliseconds : frameMilliseconds)
+		totalMilliseconds += milliseconds;
+
+	const float totalSeconds = totalMilliseconds / 1000.f;
+	std::cout << "Frames: " << frameCount << " at " << width << "x" << height << " in " << totalSeconds << "s\n"
+		<< "  ms/frame: avg " << totalMilliseconds / frameCount << ", min " << frameMilliseconds.front()
+		<< ", median " << frameMilliseconds[frameCount / 2] << ", p95 " << frameMilliseconds[std::min(frameCount - 1, frameCount * 95 / 100)]
+		<< ", max " << frameMilliseconds.back() << "\n"
+		<< "  " << frameCount / totalSeconds << " frames/s, " << float(width) * height * frameCount / totalSeconds / 1e6f << " Mpixels/s\n";
+}
+
+// Heat map ramp by name, or hex colors separated by commas. False when it's neither
+bool ParseHeatMapRamp(const std::string& text, std::vector<ColorRGB>& ramp)
+{
+	if (text == "heat" || text == "rainbow" || text == "gray")
+	{
+		ramp = HeatMap::GetRamp(text == "heat" ? HeatMap::Ramp::Heat : text == "rainbow" ? HeatMap::Ramp::Rainbow : HeatMap::Ramp::Grayscale);
+		return true;
+	}
+
+	ramp.clear();
+	size_t start = 0;
+	while (start <= text.size())
+	{
+		const size_t end = std::min(text.find(',', start), text.size());
+		const std::string color = text.substr(start, end - start);
+		if (color.size() != 6 || color.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+			return false;
+		const unsigned long value = std::strtoul(color.c_str(), nullptr, 16);
+		ramp.push_back({ ((value >> 16) & 0xFF) / 255.f, ((value >> 8) & 0xFF) / 255.f, (value & 0xFF) / 255.f });
+		start = end + 1;
+	}
+	return !ramp.empty();
+}
+
+// True when value is one of the choices or wasn't given, otherwise says what option takes
+bool IsValidChoice(const char* option, const std::string& value, std::initializer_list<const char*> choices)
+{
+	if (value.empty())
+		return true;
+	for (const char* choice : choices)
+	{
+		if (value == choice)
+			return true;
+	}
+
+	std::cout << "Unknown " << option << " " << value << ", it's";
+	const char* separator = " ";
+	for (const char* choice : choices)
+	{
+		std::cout << separator << choice;
+		separator = ", ";
+	}
+	std::cout << "\n";
+	return false;
+}
+
+// FNV-1a over the colors (alpha left out), continuing from hash
+uint64_t HashPixels(const uint32_t* pPixels, size_t pixelCount, uint64_t hash)
+{
+	for (size_t i = 0; i < pixelCount; ++i)
+		hash = (hash ^ (pPixels[i] & 0x00FFFFFF)) * 0x100000001b3ull;
+	return hash;
+}
+
+// Bytes per frame for a viewer that gets only the tiles that changed, next to sending every frame as raw RGB
+void PrintDeltaStatistics(const std::vector<DeltaFrameEncoder::Statistics>& frames, uint32_t width, uint32_t height)
+{
+	if (frames.empty())
+		return;
+
+	size_t keyframeSize = 0;
+	size_t deltaSize = 0;
+	size_t maxDeltaSize = 0;
+	size_t deltaCount = 0;
+	uint64_t changedTileCount = 0;
+	uint64_t tileCount = 0;
+	for (const DeltaFrameEncoder::Statistics& frame : frames)
+	{
+		if (frame.isKeyframe)
+		{
+			keyframeSize = std::max(keyframeSize, frame.messageSize);
+			continue;
+		}
+		deltaSize += frame.messageSize;
+		maxDeltaSize = std::max(maxDeltaSize, frame.messageSize);
+		changedTileCount += frame.changedTileCount;
+		tileCount += frame.tileCount;
+		++deltaCount;
+	}
+
+	const float rawKB = float(width) * height * 3 / 1024.f;
+	std::cout << "Delta stream: keyframe " << keyframeSize / 1024.f << " KB, raw RGB frame " << rawKB << " KB\n";
+	if (deltaCount == 0)
+		return;
+
+	const float averageKB = float(deltaSize) / deltaCount / 1024.f;
+	std::cout << "  delta KB/frame: avg " << averageKB << ", max " << maxDeltaSize / 1024.f << " (" << 100.f * averageKB / rawKB
+		<< "% of raw), tiles changed " << 100.f * changedTileCount / tileCount << "%\n";
+}
+
+// The other end of --shared-memory: takes frameCount frames from a renderer that's running, prints how often they came,
+// how long after Present they got here & how many were skipped or overwritten while being read. Without skipped frames the
+// checksum is the renderer's
+int RunSharedMemoryReader(const std::string& name, uint32_t frameCount)
+{
+	// The renderer might still be loading its scene
+	SharedFrameReader reader = {};
+	const auto openDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!reader.Open(name))
+	{
+		if (std::chrono::steady_clock::now() >= openDeadline)
+		{
+			std::cout << "No shared memory " << name << ", start a renderer with --shared-memory " << name << "\n";
+			return 1;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	const SharedFrames::Header* pHeader = reader.GetHeader();
+	std::vector<float> frameMilliseconds = {};
+	frameMilliseconds.reserve(frameCount);
+	float totalLatencyMilliseconds = 0.f;
+	float maxLatencyMilliseconds = 0.f;
+	uint64_t lastFrameNumber = 0;
+	uint64_t skippedCount = 0;
+	uint32_t overwrittenCount = 0;
+	uint32_t readCount = 0;
+	uint64_t frameChecksum = 0xcbf29ce484222325ull;
+	auto lastFrameTime = std::chrono::steady_clock::now();
+	SharedFrameReader::Frame frame = {};
+	while (readCount < frameCount && reader.WaitForFrame(lastFrameNumber, 5000, frame))
+	{
+		const auto now = std::chrono::steady_clock::now();
+		// Same clock as the renderer's Present
+		const float latencyMilliseconds = (float(std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count())
+			- float(frame.presentNanoseconds)) / 1e6f;
+
+		// A renderer that's more than slotCount - 1 frames ahead overwrites the pixels while we read them
+		frameChecksum = HashPixels(frame.pPixels, size_t(pHeader->width) * pHeader->height, frameChecksum);
+		if (!reader.IsIntact(frame))
+			++overwrittenCount;
+
+		skippedCount += frame.frameNumber - lastFrameNumber - 1;
+		if (lastFrameNumber > 0)
+			frameMilliseconds.push_back(std::chrono::duration<float, std::milli>(now - lastFrameTime).count());
+		totalLatencyMilliseconds += latencyMilliseconds;
+		maxLatencyMilliseconds = std::max(maxLatencyMilliseconds, latencyMilliseconds);
+		lastFrameNumber = frame.frameNumber;
+		lastFrameTime = now;
+		++readCount;
+	}
+
+	if (readCount == 0)
+	{
+		std::cout << "No frame from " << name << " in 5s\n";
+		return 1;
+	}
+	std::cout << "Read " << readCount << " frames from " << name << ", up to frame " << lastFrameNumber << "\n";
+	PrintFrameStatistics(frameMilliseconds, pHeader->width, pHeader->height);
+	std::cout << "  after Present: avg " << totalLatencyMilliseconds / readCount << " ms, max " << maxLatencyMilliseconds
+		<< " ms. Skipped " << skippedCount << ", overwritten while reading " << overwrittenCount << "\n"
+		<< "Frame checksum: " << std::hex << frameChecksum << std::dec << "\n";
+	return 0;
+}
+
+// Frames rendered by worker processes instead of this one. Scaling runs render the same frame on more and more workers,
+// efficiency is the speedup over one worker divided by the worker count
+int RunCoordinator(const std::string& workers, uint32_t width, uint32_t height, uint32_t tileSize, uint32_t frameCount,
+	uint32_t framesPerSecond, const std::string& options, const std::string& outputPath, bool isScalingRun)
+{
+	if (!Socket::Startup())
+		return 1;
+
+	bool isRendered = true;
+	{
+		RenderCoordinator coordinator = { width, height, tileSize };
+		if (!coordinator.Connect(ParseEndpoints(workers)))
+		{
+			std::cout << "No workers, start them with RayTracer <scene> --server <port>\n";
+			isRendered = false;
+		}
+		else if (isScalingRun)
+		{
+			float singleWorkerMilliseconds = 0.f;
+			for (uint32_t workerCount = 1; workerCount <= coordinator.GetWorkerCount() && isRendered; ++workerCount)
+			{
+				// The first frame on a worker sets up its renderer
+				isRendered = coordinator.RenderFrame(options, workerCount);
+				std::vector<float> frameMilliseconds = {};
+				for (uint32_t frame = 0; frame < frameCount && isRendered; ++frame)
+				{
+					const auto frameStart = std::chrono::steady_clock::now();
+					isRendered = coordinator.RenderFrame(options, workerCount);
+					frameMilliseconds.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+				}
+				if (!isRendered)
+					break;
+
+				std::sort(frameMilliseconds.begin(), frameMilliseconds.end());
+				const float milliseconds = frameMilliseconds[frameMilliseconds.size() / 2];
+				if (workerCount == 1)
+					singleWorkerMilliseconds = milliseconds;
+				const float speedup = singleWorkerMilliseconds / milliseconds;
+				std::cout << "Workers: " << workerCount << "  ms/frame (median): " << milliseconds
+					<< "  speedup: " << speedup << "  efficiency: " << speedup / workerCount * 100.f << "%\n";
+			}
+		}
+		else
+		{
+			// Animated scenes advance 1/fps per frame, like a batch run
+			std::vector<float> frameMilliseconds = {};
+			for (uint32_t frame = 0; frame < frameCount && isRendered; ++frame)
+			{
+				const auto frameStart = std::chrono::steady_clock::now();
+				isRendered = coordinator.RenderFrame(options + " time=" + std::to_string(float(frame) / framesPerSecond));
+				frameMilliseconds.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+			}
+			PrintFrameStatistics(frameMilliseconds, width, height);
+
+			const std::vector<uint32_t> tilesPerWorker = coordinator.GetTilesPerWorker();
+			std::cout << "  tiles per worker (last frame):";
+			for (uint32_t tileCount : tilesPerWorker)
+				std::cout << " " << tileCount;
+			std::cout << ", handed out again: " << coordinator.GetReassignedCount() << "\n";
+		}
+
+		if (!isRendered)
+			std::cout << "Every worker is gone, the frame isn't complete\n";
+
+		ImageFormat format = {};
+		if (isRendered && !outputPath.empty())
+		{
+			FrameWriter writer = { width, height, FrameWriter::PixelLayout{}, 1 };
+			isRendered = FrameWriter::GetFormat(outputPath, format) && outputPath.size() < FrameWriter::MaxFilenameLength
+				&& writer.Submit(coordinator.GetPixels().data(), format, outputPath.c_str());
+			writer.Flush();
+			isRendered &= writer.GetFailedCount() == 0;
+			std::cout << (isRendered ? "Saved " : "Couldn't save ") << outputPath << "\n";
+		}
+	}
+
+	Socket::Cleanup();
+	return isRendered ? 0 : 1;
+}
+
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	// Command line, see PrintUsage
+	std::string sceneFile = {};
+	std::string sceneName = "reference";
+	std::string streamPath = {};
+	SequenceFormat streamFormat = SequenceFormat::Y4M;
+	uint32_t framesPerSecond = 30;
+	uint32_t frameLimit = 0; // 0 = until the window gets closed
+	std::string tiledPath = {};
+	uint32_t tileSize = 0; // 0 = the default of the mode
+	uint32_t width = 640;
+	uint32_t height = 480;
+	bool isHeadless = false; // no window, no input, no display needed
+	uint32_t threadCount = 0;
+	std::string outputPath = {};
+	std::string lightingMode = {};
+	std::string shadows = {};
+	std::string reflections = {};
+	uint16_t serverPort = 0;
+	std::string serverAddress = "127.0.0.1";
+	std::string coordinatorWorkers = {};
+	bool isScalingRun = false;
+	std::string sharedMemoryName = {};
+	std::string readSharedMemoryName = {};
+	bool isDeltaStatsRun = false;
+	std::string recordInputPath = {};
+	std::string replayInputPath = {};
+	std::string cameraPathFile = {};
+	std::string recordPathFile = {};
+	std::string heatMapMode = {};
+	std::string heatMapRamp = {};
+	float heatMapScale = 0.f;
+	std::string costOutputPath = {};
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = args[i];
+		const bool hasValue = i + 1 < argc;
+		if (argument == "--stream" && hasValue)
+			streamPath = args[++i];
+		else if (argument == "--stream-format" && hasValue)
+			streamFormat = std::string(args[++i]) == "raw" ? SequenceFormat::RawRGB : SequenceFormat::Y4M;
+		else if (argument == "--fps" && hasValue)
+			framesPerSecond = std::max(1, std::atoi(args[++i]));
+		else if (argument == "--frames" && hasValue)
+			frameLimit = std::max(0, std::atoi(args[++i]));
+		else if (argument == "--tiled" && hasValue)
+			tiledPath = args[++i];
+		else if (argument == "--size" && hasValue)
+		{
+			const std::string size = args[++i];
+			const size_t separator = size.find('x');
+			width = std::max(1, std::atoi(size.c_str()));
+			height = separator != std::string::npos ? std::max(1, std::atoi(size.c_str() + separator + 1)) : width;
+		}
+		else if (argument == "--tile" && hasValue)
+		{
+			// TIFF tiles have to be a multiple of 16 wide & high
+			const int size = std::atoi(args[++i]);
+			if (size <= 0 || size % 16 != 0)
+			{
+				std::cout << "--tile " << args[i] << ": the tile size has to be a multiple of 16 (16, 32, 64, ...)\n";
+				return 1;
+			}
+			tileSize = static_cast<uint32_t>(size);
+		}
+		else if (argument == "--headless" || argument == "--batch")
+			isHeadless = true;
+		else if (argument == "--scene" && hasValue)
+			sceneName = args[++i];
+		else if (argument == "--threads" && hasValue)
+			threadCount = std::max(0, std::atoi(args[++i]));
+		else if (argument == "--output" && hasValue)
+			outputPath = args[++i];
+		else if (argument == "--lighting" && hasValue)
+			lightingMode = args[++i];
+		else if (argument == "--shadows" && hasValue)
+			shadows = args[++i];
+		else if (argument == "--reflections" && hasValue)
+			reflections = args[++i];
+		else if (argument == "--server" && hasValue)
+		{
+			const std::string address = args[++i];
+			const size_t separator = address.rfind(':');
+			if (separator != std::string::npos)
+				serverAddress = address.substr(0, separator);
+			// A port that isn't a number would be 0, which is the window instead of a server
+			char* pEnd = nullptr;
+			const char* pPort = address.c_str() + (separator != std::string::npos ? separator + 1 : 0);
+			const long port = std::strtol(pPort, &pEnd, 10);
+			if (pEnd == pPort || *pEnd != '\0' || port < 1 || port > 65535)
+			{
+				std::cout << "--server " << address << ": the port has to be a number from 1 to 65535\n";
+				PrintUsage();
+				return 1;
+			}
+			serverPort = static_cast<uint16_t>(port);
+		}
+		else if (argument == "--coordinator" && hasValue)
+			coordinatorWorkers = args[++i];
+		else if (argument == "--scaling")
+			isScalingRun = true;
+		else if (argument == "--shared-memory" && hasValue)
+			sharedMemoryName = args[++i];
+		else if (argument == "--read-shared-memory" && hasValue)
+			readSharedMemoryName = args[++i];
+		else if (argument == "--record-input" && hasValue)
+			recordInputPath = args[++i];
+		else if (argument == "--replay-input" && hasValue)
+			replayInputPath = args[++i];
+		else if (argument == "--camera-path" && hasValue)
+			cameraPathFile = args[++i];
+		else if (argument == "--record-path" && hasValue)
+			recordPathFile = args[++i];
+		else if (argument == "--heatmap" && hasValue)
+			heatMapMode = args[++i];
+		else if (argument == "--heatmap-ramp" && hasValue)
+			heatMapRamp = args[++i];
+		else if (argument == "--heatmap-scale" && hasValue)
+			heatMapScale = std::max(0.f, static_cast<float>(std::atof(args[++i])));
+		else if (argument == "--cost-output" && hasValue)
+			costOutputPath = args[++i];
+		else if (argument == "--delta-stats")
+			isDeltaStatsRun = true;
+		else if (argument.rfind("--", 0) != 0)
+			sceneFile = argument;
+		else
+		{
+			PrintUsage();
+			return argument == "--help" ? 0 : 1;
+		}
+	}
 
-	//Create window + surfaces
-	SDL_Init(SDL_INIT_VIDEO);
+	// A typo would otherwise render something else without failing, and the coordinator forwards these to every worker as they are
+	std::vector<ColorRGB> ramp = {};
+	const bool isRampValid = heatMapRamp.empty() || ParseHeatMapRamp(heatMapRamp, ramp);
+	if (!isRampValid)
+		std::cout << "Unknown --heatmap-ramp " << heatMapRamp << "\n";
+	if (!IsValidChoice("--lighting", lightingMode, { "observedarea", "radiance", "brdf", "combined" })
+		|| !IsValidChoice("--shadows", shadows, { "on", "off" })
+		|| !IsValidChoice("--reflections", reflections, { "on", "off" })
+		|| !IsValidChoice("--heatmap", heatMapMode, { "tests", "nodes", "shadows", "time" })
+		|| !isRampValid)
+	{
+		PrintUsage();
+		return 1;
+	}
 
-	const uint32_t width = 640;
-	const uint32_t height = 480;
+	// No scene here, the frames come from another process
+	if (!readSharedMemoryName.empty())
+		return RunSharedMemoryReader(readSharedMemoryName, std::max(1u, frameLimit));
 
-	SDL_Window* pWindow = SDL_CreateWindow(
-		"RayTracer - Ward Dejonckheere",
-		SDL_WINDOWPOS_UNDEFINED,
-		SDL_WINDOWPOS_UNDEFINED,
-		width, height, 0);
+	// The workers have the scene, this process only hands out tiles & puts the frame together
+	if (!coordinatorWorkers.empty())
+	{
+		std::string options = {};
+		if (!lightingMode.empty())
+			options += " lighting=" + lightingMode;
+		if (!shadows.empty())
+			options += " shadows=" + shadows;
+		if (!reflections.empty())
+			options += " reflections=" + reflections;
+		return RunCoordinator(coordinatorWorkers, width, height, tileSize > 0 ? tileSize : 64, std::max(1u, frameLimit),
+			framesPerSecond, options, outputPath, isScalingRun);
+	}
 
-	if (!pWindow)
+	Scene* pScene = nullptr;
+	if (!sceneFile.empty())
+		pScene = new Scene_File{ sceneFile };
+	else
+		pScene = CreateScene(sceneName);
+
+	if (!pScene)
+	{
+		std::cout << "Unknown scene " << sceneName << "\n";
+		PrintUsage();
 		return 1;
-	
+	}
+
+	// stdout carries the frames, everything that normally gets printed goes to stderr instead
+	if (streamPath == "-")
+		std::cout.rdbuf(std::cerr.rdbuf());
+
+	// Replays run as long as what they replay, unless --frames says otherwise
+	// Input & recorders are unique_ptrs, so the early returns (tiled, server) close & flush them too
+	std::unique_ptr<RecordedInputSource> pRecordedInput = nullptr;
+	if (!replayInputPath.empty())
+	{
+		pRecordedInput = std::make_unique<RecordedInputSource>(replayInputPath);
+		if (!pRecordedInput->IsLoaded())
+		{
+			delete pScene;
+			return 1;
+		}
+		if (frameLimit == 0)
+			frameLimit = std::max(1u, pRecordedInput->GetFrameCount());
+	}
+	CameraPath cameraPath = {};
+	if (!cameraPathFile.empty())
+	{
+		if (!cameraPath.Load(cameraPathFile))
+		{
+			delete pScene;
+			return 1;
+		}
+		if (frameLimit == 0)
+			frameLimit = static_cast<uint32_t>(cameraPath.GetDuration() * framesPerSecond) + 1;
+	}
+
+	// Poster renders, the render server & replays don't show anything either
+	isHeadless |= !tiledPath.empty() || serverPort != 0 || !sharedMemoryName.empty() || pRecordedInput != nullptr || !cameraPathFile.empty();
+
+	// There's no window to close, without --frames a headless run renders a single frame
+	if (isHeadless && frameLimit == 0)
+		frameLimit = 1;
+
+	//Create window + surfaces
+	SDL_Window* pWindow = nullptr;
+	RenderTarget* pTarget = nullptr;
+	std::unique_ptr<InputSource> pInput = nullptr;
+	if (isHeadless)
+	{
+		// SDL only for the timer. Tiled renders never use the renderer's frame, the size there is the poster's
+		SDL_Init(SDL_INIT_TIMER);
+		if (!sharedMemoryName.empty())
+		{
+			SharedMemoryRenderTarget* pSharedTarget = new SharedMemoryRenderTarget(sharedMemoryName, width, height);
+			if (!pSharedTarget->IsOpen())
+			{
+				std::cout << "Couldn't create shared memory " << sharedMemoryName
+					<< (pSharedTarget->IsNameTaken() ? ", another process still has that name open\n" : "\n");
+				delete pSharedTarget;
+				delete pScene;
+				return 1;
+			}
+			pTarget = pSharedTarget;
+		}
+		else
+			pTarget = tiledPath.empty() ? new MemoryRenderTarget(width, height) : new MemoryRenderTarget(16, 16);
+	}
+	else
+	{
+		SDL_Init(SDL_INIT_VIDEO);
+
+		pWindow = SDL_CreateWindow(
+			"RayTracer - Ward Dejonckheere",
+			SDL_WINDOWPOS_UNDEFINED,
+			SDL_WINDOWPOS_UNDEFINED,
+			width, height, 0);
+
+		if (!pWindow)
+		{
+			delete pScene;
+			return 1;
+		}
+
+		pTarget = new WindowRenderTarget(pWindow);
+		pInput = std::make_unique<SDLInputSource>();
+	}
+	if (pRecordedInput)
+		pInput = std::move(pRecordedInput);
+
+	// Records whatever the camera gets, live or replayed
+	std::unique_ptr<InputRecorder> pInputRecorder = nullptr;
+	if (!recordInputPath.empty() && pInput)
+	{
+		pInputRecorder = std::make_unique<InputRecorder>(pInput.get(), recordInputPath);
+		if (!pInputRecorder->IsOpen())
+			std::cout << "Couldn't create input recording " << recordInputPath << "\n";
+	}
+	std::unique_ptr<CameraPathRecorder> pPathRecorder = nullptr;
+	if (!recordPathFile.empty())
+	{
+		pPathRecorder = std::make_unique<CameraPathRecorder>(recordPathFile);
+		if (!pPathRecorder->IsOpen())
+			std::cout << "Couldn't create camera path " << recordPathFile << "\n";
+	}
+
 	//Initialize "framework"
 	const auto pTimer = new Timer();
-	const auto pRenderer = new Renderer(pWindow);
+	const auto pRenderer = new Renderer(pTarget);
+	pRenderer->SetThreadCount(threadCount);
 
-	const auto pScene = new Scene_W4_ReferenceScene;
+	if (lightingMode == "observedarea")
+		pRenderer->SetLightingMode(Renderer::LightingMode::ObservedArea);
+	else if (lightingMode == "radiance")
+		pRenderer->SetLightingMode(Renderer::LightingMode::Radiance);
+	else if (lightingMode == "brdf")
+		pRenderer->SetLightingMode(Renderer::LightingMode::BRDF);
+	else if (lightingMode == "combined")
+		pRenderer->SetLightingMode(Renderer::LightingMode::Combined);
+	if (!shadows.empty())
+		pRenderer->SetShadowsEnabled(shadows == "on");
+	if (!reflections.empty())
+		pRenderer->SetReflectionsEnabled(reflections == "on");
+
+	if (heatMapMode == "tests")
+		pRenderer->SetHeatMapMode(Renderer::HeatMapMode::IntersectionTests);
+	else if (heatMapMode == "nodes")
+		pRenderer->SetHeatMapMode(Renderer::HeatMapMode::NodesVisited);
+	else if (heatMapMode == "shadows")
+		pRenderer->SetHeatMapMode(Renderer::HeatMapMode::ShadowRays);
+	else if (heatMapMode == "time")
+		pRenderer->SetHeatMapMode(Renderer::HeatMapMode::Time);
+	if (!ramp.empty())
+		pRenderer->SetHeatMapRamp(ramp);
+	pRenderer->SetHeatMapScale(heatMapScale);
+
+	// RayTracer.exe Resources/reference.scene loads a scene file, no rebuild needed to change it
 	pScene->Initialize();
+	pScene->SetInputSource(pInputRecorder ? pInputRecorder.get() : pInput.get());
+
+	// Offline: the scene advances exactly one frame of time per rendered frame, however long rendering takes
+	// e.g. RayTracer scene.scene --stream - --frames 600 | ffmpeg -i - out.mp4
+	if (!streamPath.empty())
+	{
+		if (pRenderer->OpenFrameSequence(streamPath, streamFormat, framesPerSecond))
+			pTimer->SetFixedStep(1.f / framesPerSecond);
+		else
+			std::cout << "Couldn't open frame sequence " << streamPath << "\n";
+	}
+	// Batch renders are reproducible the same way
+	if (isHeadless)
+		pTimer->SetFixedStep(1.f / framesPerSecond);
+
+	// Poster renders (any size, straight to disk) instead of the window loop, at the scene's state at time 0.
+	// Running the same command again after an interruption finishes the tiles that are missing
+	if (!tiledPath.empty())
+	{
+		pScene->Update(pTimer);
+		const bool isRendered = pRenderer->RenderTiled(pScene, tiledPath, width, height, tileSize > 0 ? tileSize : 256);
+
+		delete pScene;
+		delete pRenderer;
+		delete pTimer;
+		delete pTarget;
+		ShutDown(pWindow);
+		return isRendered ? 0 : 1;
+	}
+
+	// Scene & BVHs are built once here, every request after that only renders (and animates when it asks for another time)
+	if (serverPort != 0)
+	{
+		bool isServed = false;
+		{
+			RenderServer server = { pScene, threadCount };
+			isServed = server.Run(serverPort, serverAddress);
+		}
+
+		delete pScene;
+		delete pRenderer;
+		delete pTimer;
+		delete pTarget;
+		ShutDown(pWindow);
+		return isServed ? 0 : 1;
+	}
 
 	//Start loop
 	pTimer->Start();
 	float printTimer = 0.f;
+	// First frames are allowed to allocate (transform buffers, frame allocator blocks, ...)
+	constexpr uint32_t warmupFrames = 3;
+	uint32_t frameCount = 0;
 	bool isLooping = true;
 	bool takeScreenshot = false;
+	std::vector<float> frameMilliseconds = {};
+	frameMilliseconds.reserve(frameLimit);
+	// Over every frame, two runs that print the same checksum rendered the same frames
+	uint64_t frameChecksum = 0xcbf29ce484222325ull;
+	DeltaFrameEncoder deltaEncoder{};
+	std::vector<DeltaFrameEncoder::Statistics> deltaStatistics = {};
+	deltaStatistics.reserve(isDeltaStatsRun ? frameLimit : 0);
 	while (isLooping)
 	{
 		//--------- Get input events ---------
 		SDL_Event e;
-		while (SDL_PollEvent(&e))
+		while (!isHeadless && SDL_PollEvent(&e))
 		{
 			switch (e.type)
 			{
@@ -68,7 +754,15 @@ int main(int argc, char* args[])
 				switch (e.key.keysym.scancode)
 				{
 					case SDL_SCANCODE_X:
-						takeScreenshot = true;
+						// Shift+X saves the HDR framebuffer instead
+						if (e.key.keysym.mod & KMOD_SHIFT)
+						{
+							if (!pRenderer->SaveHDRImage())
+								std::cout << "Something went wrong. HDR screenshot not saved!" << "\n";
+						}
+						else
+							takeScreenshot = true;
+						break;
 					case SDL_SCANCODE_F2:
 						if (not e.key.repeat)pRenderer->ToggleShadows();
 						break;
@@ -81,16 +775,66 @@ int main(int argc, char* args[])
 					case SDL_SCANCODE_F6:
 						if (not e.key.repeat) pTimer->StartBenchmark();
 						break;
+					case SDL_SCANCODE_F7:
+						if (not e.key.repeat) pRenderer->ToggleFrameCapture();
+						break;
+					case SDL_SCANCODE_F8:
+						if (not e.key.repeat) pRenderer->CycleImageFormat();
+						break;
+					case SDL_SCANCODE_F9:
+						if (not e.key.repeat) pRenderer->CycleToneMapping();
+						break;
+					case SDL_SCANCODE_F10:
+						if (e.key.repeat)
+							break;
+						if (e.key.keysym.mod & KMOD_SHIFT)
+							pRenderer->CycleHeatMapRamp();
+						else
+							pRenderer->CycleHeatMapMode();
+						break;
+					case SDL_SCANCODE_F11:
+						if (not e.key.repeat && !pRenderer->SaveCostBuffer())
+							std::cout << "No heat map frame yet, F10 shows one" << "\n";
+						break;
+					case SDL_SCANCODE_KP_PLUS:
+						pRenderer->ScaleExposure(1.25f);
+						break;
+					case SDL_SCANCODE_KP_MINUS:
+						pRenderer->ScaleExposure(0.8f);
+						break;
 				}
 			}
 			
 		}
 
-		//--------- Update ---------
-		pScene->Update(pTimer);
+		MemoryTracker::ResetAllocationCount();
+		const auto frameStart = std::chrono::steady_clock::now();
+		{
+			MemoryTracker::ScopedTracking trackAllocations{};
+
+			//--------- Update ---------
+			pScene->Update(pTimer);
+			if (!cameraPathFile.empty())
+				cameraPath.Apply(pTimer->GetTotal(), pScene->GetCamera());
 
-		//--------- Render ---------
-		pRenderer->Render(pScene);
+			//--------- Render ---------
+			pRenderer->Render(pScene);
+			pRenderer->CaptureFrame();
+		}
+		frameMilliseconds.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+		++frameCount;
+		if (pPathRecorder)
+			pPathRecorder->Record(pTimer->GetTotal(), pScene->GetCamera());
+		if (isHeadless)
+			frameChecksum = HashPixels(pTarget->GetPixels(), size_t(pTarget->GetWidth()) * pTarget->GetHeight(), frameChecksum);
+		if (isDeltaStatsRun)
+		{
+			deltaEncoder.Encode(pTarget->GetPixels(), pTarget->GetWidth(), pTarget->GetHeight(), pTarget->GetLayout());
+			deltaStatistics.push_back(deltaEncoder.GetStatistics());
+		}
+		if (frameLimit > 0 && frameCount >= frameLimit)
+			isLooping = false;
+		assert((frameCount <= warmupFrames || MemoryTracker::GetAllocationCount() == 0) && "Steady-state frame allocated on the heap");
 
 		//--------- Timer ---------
 		pTimer->Update();
@@ -99,25 +843,47 @@ int main(int argc, char* args[])
 		{
 			printTimer = 0.f;
 			std::cout << "dFPS: " << pTimer->GetdFPS() << "\n";
+#if RENDER_STATISTICS
+			std::cout << "  last frame: ";
+			RenderStatistics::Print(std::cout, RenderStatistics::GetFrame());
+			std::cout << "\n";
+#endif
 		}
 
-		//Save screenshot after full render
+		//Save screenshot after full render, it gets written on the frame writer's thread
 		if (takeScreenshot)
 		{
 			if (!pRenderer->SaveBufferToImage())
-				std::cout << "Screenshot saved!" << "\n";
-			else
 				std::cout << "Something went wrong. Screenshot not saved!" << "\n";
 			takeScreenshot = false;
 		}
 	}
 	pTimer->Stop();
+	pRenderer->CloseFrameSequence();
+
+	bool isSaved = true;
+	if (!outputPath.empty())
+	{
+		isSaved = pRenderer->SaveImage(outputPath);
+		std::cout << (isSaved ? "Saved " : "Couldn't save ") << outputPath << "\n";
+	}
+	if (!costOutputPath.empty())
+	{
+		const bool isCostSaved = pRenderer->SaveCostBuffer(costOutputPath);
+		std::cout << (isCostSaved ? "Saved " : "Couldn't save (needs --heatmap) ") << costOutputPath << "\n";
+		isSaved &= isCostSaved;
+	}
+	PrintFrameStatistics(frameMilliseconds, width, height);
+	PrintDeltaStatistics(deltaStatistics, width, height);
+	if (isHeadless)
+		std::cout << "Frame checksum: " << std::hex << frameChecksum << std::dec << "\n";
 
 	//Shutdown "framework"
 	delete pScene;
 	delete pRenderer;
 	delete pTimer;
+	delete pTarget;
 
 	ShutDown(pWindow);
-	return 0;
+	return isSaved ? 0 : 1;
 }
\ No newline at end of file